@@ -0,0 +1,521 @@
+// Throughput benchmarks for swizDoSwizzle() and swizDoUnswizzle().
+// Each case is compared with memcpy() of the same size.
+
+// clock_gettime is not in C99.
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "console-swizzler.h"
+#include "perf_counters.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+typedef struct BlockInfo {
+    int width;
+    int height;
+    int data_size;
+} BlockInfo;
+
+typedef struct TextureSize {
+    int width;
+    int height;
+} TextureSize;
+
+typedef struct Layout {
+    int has_mips;
+    int array_size;
+} Layout;
+
+typedef struct Target {
+    SwizPlatform platform;
+    int gobs_height;
+} Target;
+
+typedef struct BenchCase {
+    Target target;
+    BlockInfo block;
+    TextureSize size;
+    Layout layout;
+    int swizzle;
+} BenchCase;
+
+typedef struct BenchResult {
+    uint64_t bytes;  // Size of unswizzled data
+    int iterations;
+    double seconds;  // Average time of an iteration
+    double memcpy_seconds;  // Average time of memcpy() for the same size
+    CounterValues counters;  // Sum of all iterations
+} BenchResult;
+
+typedef struct BenchOptions {
+    double min_time;  // Min time to measure a case in seconds
+    int thread_count;
+    const char *filter;  // Substring of case names to run, or NULL
+    const char *json_path;  // Path to write results, or NULL
+    PerfCounters *counters;  // NULL if hardware counters are disabled
+} BenchOptions;
+
+// Counters of cases that have the same platform, block, and direction.
+typedef struct CounterSummary {
+    SwizPlatform platform;
+    BlockInfo block;
+    int swizzle;
+    uint64_t bytes;  // Size of unswizzled data of all iterations
+    CounterValues counters;
+} CounterSummary;
+
+// 2 platforms, 5 blocks, and 2 directions
+#define MAX_COUNTER_SUMMARIES 20
+
+typedef struct BenchState {
+    FILE *json;  // NULL if results are not written
+    int count;  // The number of finished cases
+    int failed;  // The number of failed cases
+    CounterSummary summaries[MAX_COUNTER_SUMMARIES];
+    int summary_count;
+} BenchState;
+
+// Uncompressed 8, 16, 32, and 64-bit pixels, and 16-byte blocks of BC7.
+static const BlockInfo BLOCKS[] = {
+    { 1, 1, 1 }, { 1, 1, 2 }, { 1, 1, 4 }, { 1, 1, 8 }, { 4, 4, 16 },
+};
+
+static const TextureSize SIZES[] = {
+    { 1024, 1024 }, { 999, 601 },
+};
+
+static const Layout LAYOUTS[] = {
+    { 0, 1 }, { 1, 1 }, { 1, 6 },
+};
+
+// Other gobs heights are measured only for the first block, size, and layout.
+static const Target TARGETS[] = {
+    { SWIZ_PLATFORM_PS4, 16 }, { SWIZ_PLATFORM_SWITCH, 16 },
+};
+
+static const int SWITCH_GOBS_HEIGHTS[] = { 1, 2, 4, 8, 32 };
+
+#define COUNT_OF(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+static double get_time(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+static const char *get_platform_name(SwizPlatform platform) {
+    return platform == SWIZ_PLATFORM_SWITCH ? "switch" : "ps4";
+}
+
+static void get_case_name(const BenchCase *c, char *name, size_t name_size) {
+    snprintf(name, name_size, "%s/gobs%d/%dx%dx%d/%dx%d/%s/array%d/%s",
+             get_platform_name(c->target.platform), c->target.gobs_height,
+             c->block.width, c->block.height, c->block.data_size,
+             c->size.width, c->size.height, c->layout.has_mips ? "mips" : "nomips",
+             c->layout.array_size, c->swizzle ? "swizzle" : "unswizzle");
+}
+
+static SwizContext *new_context(const BenchCase *c, int thread_count) {
+    SwizContext *context = swizNewContext();
+    swizContextSetPlatform(context, c->target.platform);
+    swizContextSetGobsHeight(context, c->target.gobs_height);
+    swizContextSetTextureSize(context, c->size.width, c->size.height);
+    swizContextSetBlockInfo(context, c->block.width, c->block.height, c->block.data_size);
+    swizContextSetHasMips(context, c->layout.has_mips);
+    swizContextSetArraySize(context, c->layout.array_size);
+    swizContextSetThreadCount(context, thread_count);
+    if (swizContextGetLastError(context) != SWIZ_OK) {
+        swizFreeContext(context);
+        return NULL;
+    }
+    return context;
+}
+
+// Calls swizDoSwizzle() or swizDoUnswizzle() until min_time passes.
+// Counters are read around the timed iterations when they are not NULL.
+static int time_swizzle(const BenchCase *c, SwizContext *context, const uint8_t *src,
+                        uint8_t *dst, double min_time, double *seconds,
+                        PerfCounters *counters, CounterValues *values) {
+    // The first call builds the plan and touches pages. It's not measured.
+    SwizError ret = c->swizzle ? swizDoSwizzle(src, dst, context) :
+                                 swizDoUnswizzle(src, dst, context);
+    if (ret != SWIZ_OK)
+        return 0;
+    int iterations = 0;
+    if (counters != NULL)
+        startPerfCounters(counters);
+    double start = get_time();
+    double elapsed;
+    do {
+        if (c->swizzle)
+            swizDoSwizzle(src, dst, context);
+        else
+            swizDoUnswizzle(src, dst, context);
+        iterations++;
+        elapsed = get_time() - start;
+    } while (elapsed < min_time);
+    if (counters != NULL)
+        stopPerfCounters(counters, values);
+    *seconds = elapsed / iterations;
+    return iterations;
+}
+
+static double time_memcpy(uint8_t *dst, const uint8_t *src, size_t size, double min_time) {
+    memcpy(dst, src, size);
+    int iterations = 0;
+    double start = get_time();
+    double elapsed;
+    do {
+        memcpy(dst, src, size);
+        iterations++;
+        elapsed = get_time() - start;
+    } while (elapsed < min_time);
+    return elapsed / iterations;
+}
+
+static int run_case(const BenchCase *c, const BenchOptions *options, BenchResult *result) {
+    SwizContext *context = new_context(c, options->thread_count);
+    if (context == NULL)
+        return 0;
+    uint64_t data_size = swizGetUnswizzledSize64(context);
+    uint64_t swizzled_size = swizGetSwizzledSize64(context);
+    uint8_t *data = (uint8_t *)malloc((size_t)data_size);
+    uint8_t *swizzled = (uint8_t *)malloc((size_t)swizzled_size);
+    int ok = data != NULL && swizzled != NULL;
+    if (ok) {
+        for (uint64_t i = 0; i < data_size; i++)
+            data[i] = (uint8_t)(i * 7);
+        memset(swizzled, 0x5A, (size_t)swizzled_size);
+        const uint8_t *src = c->swizzle ? data : swizzled;
+        uint8_t *dst = c->swizzle ? swizzled : data;
+        result->bytes = data_size;
+        memset(&result->counters, 0, sizeof(CounterValues));
+        result->iterations = time_swizzle(c, context, src, dst, options->min_time,
+                                          &result->seconds, options->counters,
+                                          &result->counters);
+        ok = result->iterations > 0;
+        if (ok) {
+            result->memcpy_seconds = time_memcpy(swizzled, data, (size_t)data_size,
+                                                 options->min_time);
+        }
+    }
+    free(data);
+    free(swizzled);
+    swizFreeContext(context);
+    return ok;
+}
+
+static double to_gb_per_s(uint64_t bytes, double seconds) {
+    return (double)bytes / seconds / 1e9;
+}
+
+// Metrics of counters. They are negative when the counters are not available.
+typedef struct CounterMetrics {
+    double bytes_per_cycle;
+    double ipc;  // Instructions per cycle
+    double llc_misses_per_kb;
+    double dtlb_misses_per_kb;
+} CounterMetrics;
+
+// bytes is the size of unswizzled data that the counters measured.
+static void get_counter_metrics(const CounterValues *v, uint64_t bytes, CounterMetrics *m) {
+    double kb = (double)bytes / 1024;
+    int has_cycles = v->valid[COUNTER_CYCLES] && v->values[COUNTER_CYCLES] > 0;
+    m->bytes_per_cycle = has_cycles ? (double)bytes / v->values[COUNTER_CYCLES] : -1;
+    m->ipc = has_cycles && v->valid[COUNTER_INSTRUCTIONS] ?
+             (double)v->values[COUNTER_INSTRUCTIONS] / v->values[COUNTER_CYCLES] : -1;
+    m->llc_misses_per_kb = v->valid[COUNTER_LLC_MISSES] && kb > 0 ?
+                           v->values[COUNTER_LLC_MISSES] / kb : -1;
+    m->dtlb_misses_per_kb = v->valid[COUNTER_DTLB_MISSES] && kb > 0 ?
+                            v->values[COUNTER_DTLB_MISSES] / kb : -1;
+}
+
+static void print_metric(const char *format, double value) {
+    if (value < 0)
+        printf(" %8s", "n/a");
+    else
+        printf(format, value);
+}
+
+static void print_counter_metrics(const CounterValues *values, uint64_t bytes) {
+    CounterMetrics m;
+    get_counter_metrics(values, bytes, &m);
+    print_metric(" %8.3f", m.bytes_per_cycle);
+    print_metric(" %8.2f", m.ipc);
+    print_metric(" %8.3f", m.llc_misses_per_kb);
+    print_metric(" %8.3f", m.dtlb_misses_per_kb);
+}
+
+static void write_json_metric(FILE *json, const char *key, double value) {
+    if (value < 0)
+        fprintf(json, ", \"%s\": null", key);
+    else
+        fprintf(json, ", \"%s\": %.6f", key, value);
+}
+
+// Writes raw counters of an iteration and metrics. iterations should be positive.
+static void write_json_counters(FILE *json, const CounterValues *values, uint64_t bytes,
+                                int iterations) {
+    fprintf(json, ", \"counters\": {");
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        fprintf(json, "%s\"%s\": ", i == 0 ? "" : ", ", getCounterName((CounterId)i));
+        if (values->valid[i])
+            fprintf(json, "%.1f", (double)values->values[i] / iterations);
+        else
+            fprintf(json, "null");
+    }
+    fprintf(json, "}");
+    CounterMetrics m;
+    get_counter_metrics(values, bytes * iterations, &m);
+    write_json_metric(json, "bytes_per_cycle", m.bytes_per_cycle);
+    write_json_metric(json, "ipc", m.ipc);
+    write_json_metric(json, "llc_misses_per_kb", m.llc_misses_per_kb);
+    write_json_metric(json, "dtlb_misses_per_kb", m.dtlb_misses_per_kb);
+}
+
+static void write_json_result(FILE *json, const BenchCase *c, const char *name,
+                              const BenchResult *result, int first, int has_counters) {
+    fprintf(json, "%s\n    {\"name\": \"%s\", \"platform\": \"%s\", \"gobs_height\": %d, ",
+            first ? "" : ",", name, get_platform_name(c->target.platform),
+            c->target.gobs_height);
+    fprintf(json, "\"block_width\": %d, \"block_height\": %d, \"block_data_size\": %d, ",
+            c->block.width, c->block.height, c->block.data_size);
+    fprintf(json, "\"width\": %d, \"height\": %d, \"has_mips\": %s, \"array_size\": %d, ",
+            c->size.width, c->size.height, c->layout.has_mips ? "true" : "false",
+            c->layout.array_size);
+    fprintf(json, "\"direction\": \"%s\", \"bytes\": %" PRIu64 ", \"iterations\": %d, ",
+            c->swizzle ? "swizzle" : "unswizzle", result->bytes,
+            result->iterations);
+    fprintf(json, "\"seconds\": %.9f, \"gb_per_s\": %.4f, \"memcpy_gb_per_s\": %.4f",
+            result->seconds, to_gb_per_s(result->bytes, result->seconds),
+            to_gb_per_s(result->bytes, result->memcpy_seconds));
+    if (has_counters)
+        write_json_counters(json, &result->counters, result->bytes, result->iterations);
+    fprintf(json, "}");
+}
+
+// Adds counters of a case to the summary of its platform, block, and direction.
+static void add_counter_summary(BenchState *state, const BenchCase *c,
+                                const BenchResult *result) {
+    CounterSummary *summary = NULL;
+    for (int i = 0; i < state->summary_count; i++) {
+        CounterSummary *s = &state->summaries[i];
+        if (s->platform == c->target.platform && s->swizzle == c->swizzle &&
+            memcmp(&s->block, &c->block, sizeof(BlockInfo)) == 0) {
+            summary = s;
+            break;
+        }
+    }
+    if (summary == NULL) {
+        if (state->summary_count == MAX_COUNTER_SUMMARIES)
+            return;
+        summary = &state->summaries[state->summary_count++];
+        memset(summary, 0, sizeof(CounterSummary));
+        summary->platform = c->target.platform;
+        summary->block = c->block;
+        summary->swizzle = c->swizzle;
+        for (int i = 0; i < COUNTER_COUNT; i++)
+            summary->counters.valid[i] = 1;
+    }
+    summary->bytes += result->bytes * result->iterations;
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        summary->counters.values[i] += result->counters.values[i];
+        // A summary is valid only when all of its cases have the counter.
+        summary->counters.valid[i] &= result->counters.valid[i];
+    }
+}
+
+static void get_summary_name(const CounterSummary *s, char *name, size_t name_size) {
+    snprintf(name, name_size, "%s/%dx%dx%d/%s", get_platform_name(s->platform),
+             s->block.width, s->block.height, s->block.data_size,
+             s->swizzle ? "swizzle" : "unswizzle");
+}
+
+static void print_counter_summaries(const BenchState *state) {
+    printf("\nCounters by platform, block, and direction:\n");
+    printf("%-56s %8s %8s %8s %8s\n", "group", "B/cycle", "IPC", "LLC/KB", "dTLB/KB");
+    for (int i = 0; i < state->summary_count; i++) {
+        const CounterSummary *s = &state->summaries[i];
+        char name[64];
+        get_summary_name(s, name, sizeof(name));
+        printf("%-56s", name);
+        print_counter_metrics(&s->counters, s->bytes);
+        printf("\n");
+    }
+}
+
+static void write_json_summaries(FILE *json, const BenchState *state) {
+    fprintf(json, ",\n  \"counter_summaries\": [");
+    for (int i = 0; i < state->summary_count; i++) {
+        const CounterSummary *s = &state->summaries[i];
+        char name[64];
+        get_summary_name(s, name, sizeof(name));
+        fprintf(json, "%s\n    {\"name\": \"%s\", \"bytes\": %" PRIu64, i == 0 ? "" : ",",
+                name, s->bytes);
+        write_json_counters(json, &s->counters, s->bytes, 1);
+        fprintf(json, "}");
+    }
+    fprintf(json, "\n  ]");
+}
+
+// Runs a case if it matches the filter.
+static void bench(const BenchCase *c, const BenchOptions *options, BenchState *state) {
+    char name[128];
+    get_case_name(c, name, sizeof(name));
+    if (options->filter != NULL && strstr(name, options->filter) == NULL)
+        return;
+
+    BenchResult result;
+    if (!run_case(c, options, &result)) {
+        printf("%-56s failed\n", name);
+        state->failed++;
+        return;
+    }
+    double gb_per_s = to_gb_per_s(result.bytes, result.seconds);
+    double memcpy_gb_per_s = to_gb_per_s(result.bytes, result.memcpy_seconds);
+    printf("%-56s %9.2f MiB %8.2f GB/s %8.2f GB/s %6.1f%%", name,
+           (double)result.bytes / (1024 * 1024), gb_per_s, memcpy_gb_per_s,
+           100.0 * gb_per_s / memcpy_gb_per_s);
+    if (options->counters != NULL) {
+        print_counter_metrics(&result.counters, result.bytes * result.iterations);
+        add_counter_summary(state, c, &result);
+    }
+    printf("\n");
+    fflush(stdout);
+    if (state->json != NULL) {
+        write_json_result(state->json, c, name, &result, state->count == 0,
+                          options->counters != NULL);
+    }
+    state->count++;
+}
+
+static void run_all(const BenchOptions *options, BenchState *state) {
+    BenchCase c;
+    for (int t = 0; t < COUNT_OF(TARGETS); t++) {
+        c.target = TARGETS[t];
+        for (int b = 0; b < COUNT_OF(BLOCKS); b++) {
+            c.block = BLOCKS[b];
+            for (int s = 0; s < COUNT_OF(SIZES); s++) {
+                c.size = SIZES[s];
+                for (int l = 0; l < COUNT_OF(LAYOUTS); l++) {
+                    c.layout = LAYOUTS[l];
+                    for (c.swizzle = 1; c.swizzle >= 0; c.swizzle--)
+                        bench(&c, options, state);
+                }
+            }
+        }
+    }
+
+    c.target.platform = SWIZ_PLATFORM_SWITCH;
+    c.block = BLOCKS[0];
+    c.size = SIZES[0];
+    c.layout = LAYOUTS[0];
+    for (int g = 0; g < COUNT_OF(SWITCH_GOBS_HEIGHTS); g++) {
+        c.target.gobs_height = SWITCH_GOBS_HEIGHTS[g];
+        for (c.swizzle = 1; c.swizzle >= 0; c.swizzle--)
+            bench(&c, options, state);
+    }
+}
+
+static void print_usage(void) {
+    printf("Usage: console_swizzler_bench [--json <path>] [--min-time <seconds>]"
+           " [--threads <count>] [--filter <substring>] [--counters]\n"
+           "    --counters reads hardware counters of the calling thread on Linux.\n"
+           "    Use them with --threads 1 (the default) to measure all the work.\n");
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options;
+    options.min_time = 0.1;
+    options.thread_count = 1;
+    options.filter = NULL;
+    options.json_path = NULL;
+    options.counters = NULL;
+    int use_counters = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--counters") == 0) {
+            use_counters = 1;
+            continue;
+        }
+        if (i + 1 == argc) {
+            print_usage();
+            return 1;
+        }
+        if (strcmp(argv[i], "--json") == 0) {
+            options.json_path = argv[++i];
+        } else if (strcmp(argv[i], "--min-time") == 0) {
+            options.min_time = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            options.thread_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0) {
+            options.filter = argv[++i];
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    printf("Console Swizzler v%s (threads: %d)\n", swizGetVersion(), options.thread_count);
+
+    // Benchmarks still run without counters when the system doesn't permit them.
+    PerfCounters counters;
+    if (use_counters) {
+        const char *reason = NULL;
+        if (openPerfCounters(&counters, &reason) > 0)
+            options.counters = &counters;
+        else
+            printf("Hardware counters are disabled: %s\n", reason);
+    }
+
+    BenchState state;
+    state.json = NULL;
+    state.count = 0;
+    state.failed = 0;
+    state.summary_count = 0;
+    if (options.json_path != NULL) {
+        state.json = fopen(options.json_path, "w");
+        if (state.json == NULL) {
+            printf("Failed to open %s\n", options.json_path);
+            if (options.counters != NULL)
+                closePerfCounters(options.counters);
+            return 1;
+        }
+        fprintf(state.json, "{\n  \"version\": \"%s\",\n  \"threads\": %d,\n"
+                "  \"counters\": %s,\n  \"results\": [", swizGetVersion(),
+                options.thread_count, options.counters != NULL ? "true" : "false");
+    }
+
+    printf("%-56s %13s %13s %13s %7s", "case", "size", "swizzler", "memcpy", "ratio");
+    if (options.counters != NULL)
+        printf(" %8s %8s %8s %8s", "B/cycle", "IPC", "LLC/KB", "dTLB/KB");
+    printf("\n");
+    run_all(&options, &state);
+    if (options.counters != NULL) {
+        print_counter_summaries(&state);
+        closePerfCounters(options.counters);
+    }
+
+    if (state.json != NULL) {
+        fprintf(state.json, "\n  ]");
+        if (options.counters != NULL)
+            write_json_summaries(state.json, &state);
+        fprintf(state.json, "\n}\n");
+        fclose(state.json);
+    }
+    return state.failed > 0;
+}
@@ -0,0 +1,417 @@
+// Runs swizzle and unswizzle round trips of swizzler-cli over dds files.
+// It records times of stages, peak RSS, and throughput of each run.
+// Each file goes through both I/O paths of swizzler-cli:
+//   mapped: the default. The swizzle stage pages the input in and the output out.
+//           So, load and save are only mmap and munmap, and wall time is the one to compare.
+//   chunked: --memory-budget. Reading and writing overlap with the swizzle stage.
+
+// fork, execv, and wait4 are not in C99.
+#ifndef _WIN32
+#define _DEFAULT_SOURCE
+#define _DARWIN_C_SOURCE
+#endif
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// Result of a swizzler-cli process.
+typedef struct RunResult {
+    int ok;
+    double wall;  // Seconds from start to exit
+    double load;  // Times of stages that the process printed
+    double swizzle;
+    double save;
+    uint64_t peak_rss;  // Bytes
+} RunResult;
+
+typedef struct BenchOptions {
+    const char *cli_path;
+    const char *manifest_path;
+    const char *platform;
+    const char *work_dir;
+    const char *json_path;
+    int thread_count;
+    int memory_budget;  // MiB for the chunked path
+} BenchOptions;
+
+// I/O paths of swizzler-cli. The chunked path uses --memory-budget.
+static const char *const MODES[] = { "mapped", "chunked" };
+#define MODE_COUNT 2
+
+static double get_time(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+// Reads "Timings: load X s, swizzle Y s, save Z s" from the output of swizzler-cli.
+static int parse_timings(const char *output, RunResult *result) {
+    const char *line = strstr(output, "Timings: ");
+    if (line == NULL)
+        return 0;
+    return sscanf(line, "Timings: load %lf s, swizzle %lf s, save %lf s",
+                  &result->load, &result->swizzle, &result->save) == 3;
+}
+
+#ifdef _WIN32
+
+// Runs a process and reads its stdout into output.
+static int run_process(char *const argv[], char *output, size_t output_size,
+                       RunResult *result) {
+    // Quote all arguments for the command line.
+    char command[8192] = "";
+    size_t len = 0;
+    for (int i = 0; argv[i] != NULL; i++) {
+        int n = snprintf(command + len, sizeof(command) - len, "%s\"%s\"",
+                         i == 0 ? "" : " ", argv[i]);
+        if (n < 0 || (size_t)n >= sizeof(command) - len)
+            return 0;
+        len += (size_t)n;
+    }
+
+    SECURITY_ATTRIBUTES sa = { sizeof(sa), NULL, TRUE };
+    HANDLE read_pipe, write_pipe;
+    if (!CreatePipe(&read_pipe, &write_pipe, &sa, 0))
+        return 0;
+    SetHandleInformation(read_pipe, HANDLE_FLAG_INHERIT, 0);
+    STARTUPINFOA si;
+    memset(&si, 0, sizeof(si));
+    si.cb = sizeof(si);
+    si.dwFlags = STARTF_USESTDHANDLES;
+    si.hStdOutput = write_pipe;
+    si.hStdError = write_pipe;
+    si.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+    PROCESS_INFORMATION pi;
+    double start = get_time();
+    BOOL created = CreateProcessA(NULL, command, NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi);
+    CloseHandle(write_pipe);
+    if (!created) {
+        CloseHandle(read_pipe);
+        return 0;
+    }
+
+    size_t size = 0;
+    DWORD read_size;
+    while (size + 1 < output_size &&
+           ReadFile(read_pipe, output + size, (DWORD)(output_size - size - 1), &read_size, NULL) &&
+           read_size > 0)
+        size += read_size;
+    output[size] = '\0';
+    WaitForSingleObject(pi.hProcess, INFINITE);
+    result->wall = get_time() - start;
+
+    DWORD exit_code = 1;
+    GetExitCodeProcess(pi.hProcess, &exit_code);
+    PROCESS_MEMORY_COUNTERS counters;
+    result->peak_rss = 0;
+    if (GetProcessMemoryInfo(pi.hProcess, &counters, sizeof(counters)))
+        result->peak_rss = (uint64_t)counters.PeakWorkingSetSize;
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
+    CloseHandle(read_pipe);
+    return exit_code == 0;
+}
+
+#else  // _WIN32
+
+// Runs a process and reads its stdout into output.
+static int run_process(char *const argv[], char *output, size_t output_size,
+                       RunResult *result) {
+    int fds[2];
+    if (pipe(fds) != 0)
+        return 0;
+    double start = get_time();
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return 0;
+    }
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        dup2(fds[1], STDERR_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execv(argv[0], argv);
+        _exit(127);
+    }
+    close(fds[1]);
+
+    // Keep reading after the buffer is full. Otherwise, the child blocks on the pipe.
+    size_t size = 0;
+    char discard[4096];
+    while (1) {
+        char *dest = size + 1 < output_size ? output + size : discard;
+        size_t capacity = size + 1 < output_size ? output_size - size - 1 : sizeof(discard);
+        ssize_t read_size = read(fds[0], dest, capacity);
+        if (read_size <= 0)
+            break;
+        if (dest != discard)
+            size += (size_t)read_size;
+    }
+    output[size] = '\0';
+    close(fds[0]);
+
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid)
+        return 0;
+    result->wall = get_time() - start;
+#ifdef __APPLE__
+    result->peak_rss = (uint64_t)usage.ru_maxrss;  // Bytes on macOS
+#else
+    result->peak_rss = (uint64_t)usage.ru_maxrss * 1024;  // KiB on Linux
+#endif
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+#endif  // _WIN32
+
+static void run_cli(const BenchOptions *options, int chunked, const char *command,
+                    const char *input, const char *output, RunResult *result) {
+    char threads[16];
+    char budget[16];
+    snprintf(threads, sizeof(threads), "%d", options->thread_count);
+    snprintf(budget, sizeof(budget), "%d", options->memory_budget);
+    char *argv[12];
+    int argc = 0;
+    argv[argc++] = (char *)options->cli_path;
+    argv[argc++] = (char *)"--timings";
+    argv[argc++] = (char *)"--threads";
+    argv[argc++] = threads;
+    if (chunked) {
+        argv[argc++] = (char *)"--memory-budget";
+        argv[argc++] = budget;
+    }
+    argv[argc++] = (char *)command;
+    argv[argc++] = (char *)input;
+    argv[argc++] = (char *)output;
+    argv[argc++] = (char *)options->platform;
+    argv[argc] = NULL;
+    static char text[65536];
+    memset(result, 0, sizeof(RunResult));
+    result->ok = run_process(argv, text, sizeof(text), result) && parse_timings(text, result);
+    if (!result->ok)
+        printf("%s", text);
+}
+
+static uint64_t get_file_size(const char *path) {
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(path, &st) != 0)
+        return 0;
+#else
+    struct stat st;
+    if (stat(path, &st) != 0)
+        return 0;
+#endif
+    return st.st_size > 0 ? (uint64_t)st.st_size : 0;
+}
+
+// Returns non-zero if files have the same bytes.
+static int same_files(const char *path1, const char *path2) {
+    FILE *file1 = fopen(path1, "rb");
+    FILE *file2 = fopen(path2, "rb");
+    int same = file1 != NULL && file2 != NULL;
+    static char buffer1[1 << 16];
+    static char buffer2[1 << 16];
+    while (same) {
+        size_t size1 = fread(buffer1, 1, sizeof(buffer1), file1);
+        size_t size2 = fread(buffer2, 1, sizeof(buffer2), file2);
+        same = size1 == size2 && memcmp(buffer1, buffer2, size1) == 0;
+        if (size1 == 0)
+            break;
+    }
+    if (file1 != NULL)
+        fclose(file1);
+    if (file2 != NULL)
+        fclose(file2);
+    return same;
+}
+
+static double to_mib_per_s(uint64_t bytes, double seconds) {
+    return seconds > 0 ? (double)bytes / (1024 * 1024) / seconds : 0;
+}
+
+static void print_result(const char *name, const char *mode, const char *command,
+                         uint64_t bytes, const RunResult *r) {
+    printf("%-40s %-7s %-9s %8.2f MiB/s load %8.2f MiB/s swizzle %8.2f MiB/s save"
+           " %8.2f MiB/s wall %8.1f MiB RSS\n", name, mode, command,
+           to_mib_per_s(bytes, r->load), to_mib_per_s(bytes, r->swizzle),
+           to_mib_per_s(bytes, r->save), to_mib_per_s(bytes, r->wall),
+           (double)r->peak_rss / (1024 * 1024));
+}
+
+static void write_json_run(FILE *json, const char *command, uint64_t bytes,
+                           const RunResult *r) {
+    fprintf(json, "\"%s\": {\"ok\": %s, \"wall_s\": %.6f, \"load_s\": %.6f, "
+            "\"swizzle_s\": %.6f, \"save_s\": %.6f, \"peak_rss_bytes\": %" PRIu64 ", "
+            "\"load_bytes_per_s\": %.0f, \"swizzle_bytes_per_s\": %.0f, "
+            "\"save_bytes_per_s\": %.0f, \"wall_bytes_per_s\": %.0f}", command,
+            r->ok ? "true" : "false", r->wall, r->load, r->swizzle, r->save, r->peak_rss,
+            r->load > 0 ? bytes / r->load : 0, r->swizzle > 0 ? bytes / r->swizzle : 0,
+            r->save > 0 ? bytes / r->save : 0, r->wall > 0 ? bytes / r->wall : 0);
+}
+
+// Gets the file name of a path.
+static const char *get_name(const char *path) {
+    const char *name = path;
+    for (const char *p = path; *p != '\0'; p++) {
+        if (*p == '/' || *p == '\\')
+            name = p + 1;
+    }
+    return name;
+}
+
+// Runs a round trip of a file through a path. Returns zero if it failed.
+static int bench_mode(const BenchOptions *options, const char *path, int mode, FILE *json) {
+    char swizzled[4096];
+    char unswizzled[4096];
+    snprintf(swizzled, sizeof(swizzled), "%s/cli_bench_%s_swizzled.dds",
+             options->work_dir, options->platform);
+    snprintf(unswizzled, sizeof(unswizzled), "%s/cli_bench_%s_unswizzled.dds",
+             options->work_dir, options->platform);
+
+    const char *name = get_name(path);
+    int chunked = mode == 1;
+    uint64_t bytes = get_file_size(path);
+    RunResult swizzle, unswizzle;
+    run_cli(options, chunked, "swizzle", path, swizzled, &swizzle);
+    uint64_t swizzled_bytes = get_file_size(swizzled);
+    run_cli(options, chunked, "unswizzle", swizzled, unswizzled, &unswizzle);
+    int same = swizzle.ok && unswizzle.ok && same_files(path, unswizzled);
+    remove(swizzled);
+    remove(unswizzled);
+
+    print_result(name, MODES[mode], "swizzle", bytes, &swizzle);
+    print_result(name, MODES[mode], "unswizzle", swizzled_bytes, &unswizzle);
+    if (!same)
+        printf("%-40s %-7s round trip failed\n", name, MODES[mode]);
+    if (json != NULL) {
+        fprintf(json, "\"%s\": {\"round_trip\": %s, ", MODES[mode], same ? "true" : "false");
+        write_json_run(json, "swizzle", bytes, &swizzle);
+        fprintf(json, ", ");
+        write_json_run(json, "unswizzle", swizzled_bytes, &unswizzle);
+        fprintf(json, "}");
+    }
+    fflush(stdout);
+    return same;
+}
+
+// Runs round trips of a file through all paths. Returns zero if any of them failed.
+static int bench_file(const BenchOptions *options, const char *path, FILE *json, int first) {
+    if (json != NULL) {
+        fprintf(json, "%s\n    {\"file\": \"%s\", \"bytes\": %" PRIu64 ", ",
+                first ? "" : ",", get_name(path), get_file_size(path));
+    }
+    int same = 1;
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+        if (json != NULL && mode > 0)
+            fprintf(json, ", ");
+        same &= bench_mode(options, path, mode, json);
+    }
+    if (json != NULL)
+        fprintf(json, "}");
+    return same;
+}
+
+static void print_usage(void) {
+    printf("Usage: console_swizzler_cli_bench <swizzler-cli> <manifest> [--platform <platform>]"
+           " [--threads <count>] [--memory-budget <MiB>] [--work-dir <dir>] [--json <path>]\n"
+           "    A manifest has a path of a dds file per line."
+           " console_swizzler_gen_dds makes one.\n"
+           "    Files are converted through mapped files, and in chunks within the budget.\n"
+           "    The default budget is 64 MiB.\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        print_usage();
+        return 1;
+    }
+    BenchOptions options;
+    options.cli_path = argv[1];
+    options.manifest_path = argv[2];
+    options.platform = "ps4";
+    options.work_dir = ".";
+    options.json_path = NULL;
+    options.thread_count = 1;
+    options.memory_budget = 64;
+    for (int i = 3; i < argc; i++) {
+        if (i + 1 == argc) {
+            print_usage();
+            return 1;
+        }
+        if (strcmp(argv[i], "--platform") == 0) {
+            options.platform = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            options.thread_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--memory-budget") == 0) {
+            options.memory_budget = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--work-dir") == 0) {
+            options.work_dir = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0) {
+            options.json_path = argv[++i];
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    FILE *manifest = fopen(options.manifest_path, "r");
+    if (manifest == NULL) {
+        printf("Failed to open %s\n", options.manifest_path);
+        return 1;
+    }
+    FILE *json = NULL;
+    if (options.json_path != NULL) {
+        json = fopen(options.json_path, "w");
+        if (json == NULL) {
+            printf("Failed to open %s\n", options.json_path);
+            fclose(manifest);
+            return 1;
+        }
+        fprintf(json, "{\n  \"platform\": \"%s\",\n  \"threads\": %d,\n"
+                "  \"memory_budget_mib\": %d,\n  \"results\": [",
+                options.platform, options.thread_count, options.memory_budget);
+    }
+
+    int failed = 0;
+    int count = 0;
+    char path[4096];
+    while (fgets(path, sizeof(path), manifest) != NULL) {
+        path[strcspn(path, "\r\n")] = '\0';
+        if (path[0] == '\0')
+            continue;
+        failed += !bench_file(&options, path, json, count == 0);
+        count++;
+    }
+    fclose(manifest);
+    if (json != NULL) {
+        fprintf(json, "\n  ]\n}\n");
+        fclose(json);
+    }
+    printf("%d files, %d failed\n", count, failed);
+    return failed > 0;
+}
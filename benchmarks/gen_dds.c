@@ -0,0 +1,243 @@
+// Generates deterministic dds files for end-to-end benchmarks of swizzler-cli.
+// Pixels are pseudo-random, and the same arguments always make the same files.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "console-swizzler.h"
+#include "dds.h"
+
+#define FOURCC_DXT1 0x31545844
+#define FOURCC_DXT5 0x35545844
+#define FOURCC_DX10 0x30315844
+
+// DDS_RESOURCE_MISC_TEXTURECUBE of dds_header_dxt10::misc_flag
+#define DDS_RESOURCE_MISC_TEXTURECUBE 0x4
+
+// D3D10_RESOURCE_DIMENSION_TEXTURE2D
+#define DDS_DIMENSION_TEXTURE2D 3
+
+typedef struct Format {
+    const char *name;
+    dds_uint four_cc;  // FOURCC_DX10 for formats that need dds_header_dxt10
+    dds_uint dxgi_format;  // Also used for arrays of legacy formats
+    int block_width;
+    int block_height;
+    int block_data_size;
+} Format;
+
+typedef struct Texture {
+    int width;
+    int height;
+    int has_mips;
+    int array_size;  // The number of elements. Cubemaps have 6 faces for each.
+    int is_cube;
+} Texture;
+
+static const Format FORMATS[] = {
+    { "dxt1", FOURCC_DXT1, 71, 4, 4, 8 },
+    { "dxt5", FOURCC_DXT5, 77, 4, 4, 16 },
+    { "bc7", FOURCC_DX10, 98, 4, 4, 16 },
+    { "rgba8", FOURCC_DX10, 28, 1, 1, 4 },
+    { "astc4x4", FOURCC_DX10, 134, 4, 4, 16 },
+};
+
+// Textures larger than --max-size will be skipped.
+static const Texture TEXTURES[] = {
+    { 256, 256, 1, 1, 0 },
+    { 1024, 1024, 1, 1, 0 },
+    { 1920, 1080, 1, 1, 0 },
+    { 4096, 4096, 1, 1, 0 },
+    { 4096, 4096, 0, 1, 0 },
+    { 8192, 8192, 1, 1, 0 },
+    { 16384, 16384, 1, 1, 0 },
+    { 1024, 1024, 1, 6, 0 },
+    { 1024, 1024, 1, 1, 1 },
+};
+
+#define COUNT_OF(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+// Makes the seed from a file name, so files don't depend on the order of generation.
+static uint64_t get_seed(const char *str) {
+    uint64_t hash = 14695981039346656037ULL;  // FNV-1a
+    for (; *str != '\0'; str++)
+        hash = (hash ^ (uint8_t)*str) * 1099511628211ULL;
+    return hash;
+}
+
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+static int get_mip_count(const Texture *t) {
+    if (!t->has_mips)
+        return 1;
+    int count = 1;
+    int size = t->width > t->height ? t->width : t->height;
+    while (size > 1) {
+        size /= 2;
+        count++;
+    }
+    return count;
+}
+
+static void init_header(struct dds_image *image, const Format *f, const Texture *t) {
+    memset(image, 0, sizeof(struct dds_image));
+    struct dds_header *h = &image->header;
+    h->size = 124;
+    h->flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE;
+    h->width = (dds_uint)t->width;
+    h->height = (dds_uint)t->height;
+    h->pitch_linear_size = (dds_uint)((t->width + f->block_width - 1) / f->block_width *
+                                      ((t->height + f->block_height - 1) / f->block_height) *
+                                      f->block_data_size);
+    h->mipmap_count = (dds_uint)get_mip_count(t);
+    h->caps = DDSCAPS_TEXTURE;
+    if (t->has_mips) {
+        h->flags |= DDSD_MIPMAPCOUNT;
+        h->caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+    }
+    if (t->is_cube) {
+        h->caps |= DDSCAPS_COMPLEX;
+        h->caps2 = DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEX | DDSCAPS2_CUBEMAP_NEGATIVEX |
+                   DDSCAPS2_CUBEMAP_POSITIVEY | DDSCAPS2_CUBEMAP_NEGATIVEY |
+                   DDSCAPS2_CUBEMAP_POSITIVEZ | DDSCAPS2_CUBEMAP_NEGATIVEZ;
+    }
+    h->pixel_format.size = 32;
+    h->pixel_format.flags = DDPF_FOURCC;
+
+    // Legacy headers can't store arrays.
+    if (f->four_cc != FOURCC_DX10 && t->array_size == 1) {
+        h->pixel_format.four_cc = f->four_cc;
+        return;
+    }
+    h->pixel_format.four_cc = FOURCC_DX10;
+    image->header10.dxgi_format = f->dxgi_format;
+    image->header10.resource_dimension = DDS_DIMENSION_TEXTURE2D;
+    image->header10.misc_flag = t->is_cube ? DDS_RESOURCE_MISC_TEXTURECUBE : 0;
+    image->header10.array_size = (dds_uint)t->array_size;
+}
+
+// Gets the size of unswizzled pixels with the library. It doesn't depend on the platform.
+static uint64_t get_data_size(const Format *f, const Texture *t) {
+    SwizContext *context = swizNewContext();
+    swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
+    swizContextSetTextureSize(context, t->width, t->height);
+    swizContextSetBlockInfo(context, f->block_width, f->block_height, f->block_data_size);
+    swizContextSetHasMips(context, t->has_mips);
+    swizContextSetArraySize(context, t->array_size * (t->is_cube ? 6 : 1));
+    uint64_t size = swizGetUnswizzledSize64(context);
+    swizFreeContext(context);
+    return size;
+}
+
+static void get_file_name(const Format *f, const Texture *t, char *name, size_t name_size) {
+    char layout[32] = "";
+    if (t->is_cube)
+        snprintf(layout, sizeof(layout), "_cube");
+    else if (t->array_size > 1)
+        snprintf(layout, sizeof(layout), "_array%d", t->array_size);
+    snprintf(name, name_size, "%s_%dx%d%s%s.dds", f->name, t->width, t->height,
+             t->has_mips ? "_mips" : "", layout);
+}
+
+static int write_dds(const char *path, const char *name, const Format *f, const Texture *t) {
+    struct dds_image image;
+    init_header(&image, f, t);
+    uint64_t data_size = get_data_size(f, t);
+    if (data_size == 0)
+        return 0;
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+        return 0;
+    dds_byte header[4 + sizeof(struct dds_header) + sizeof(struct dds_header_dxt10)];
+    dds_write_header(&image, header);
+    size_t header_size = (size_t)dds_get_header_size(&image);
+    int ok = fwrite(header, 1, header_size, file) == header_size;
+
+    static uint64_t buffer[1 << 17];  // 1 MiB
+    uint64_t state = get_seed(name);
+    while (ok && data_size > 0) {
+        size_t size = data_size < sizeof(buffer) ? (size_t)data_size : sizeof(buffer);
+        for (size_t i = 0; i < (size + 7) / 8; i++)
+            buffer[i] = xorshift64(&state);
+        ok = fwrite(buffer, 1, size, file) == size;
+        data_size -= size;
+    }
+    if (fclose(file) != 0)
+        ok = 0;
+    if (!ok)
+        remove(path);
+    return ok;
+}
+
+static void print_usage(void) {
+    printf("Usage: console_swizzler_gen_dds <output_dir> [--max-size <pixels>]"
+           " [--manifest <path>]\n"
+           "    Writes dds files to an existing directory, and their paths to the manifest.\n"
+           "    The default max size is 4096. The default manifest is <output_dir>/corpus.txt.\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+    const char *output_dir = argv[1];
+    const char *manifest_path = NULL;
+    int max_size = 4096;
+    for (int i = 2; i < argc; i++) {
+        if (i + 1 == argc) {
+            print_usage();
+            return 1;
+        }
+        if (strcmp(argv[i], "--max-size") == 0) {
+            max_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--manifest") == 0) {
+            manifest_path = argv[++i];
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    char path[4096];
+    if (manifest_path == NULL) {
+        snprintf(path, sizeof(path), "%s/corpus.txt", output_dir);
+        manifest_path = path;
+    }
+    FILE *manifest = fopen(manifest_path, "w");
+    if (manifest == NULL) {
+        printf("Failed to open %s\n", manifest_path);
+        return 1;
+    }
+
+    int failed = 0;
+    for (int i = 0; i < COUNT_OF(FORMATS); i++) {
+        for (int j = 0; j < COUNT_OF(TEXTURES); j++) {
+            const Texture *t = &TEXTURES[j];
+            if (t->width > max_size || t->height > max_size)
+                continue;
+            char name[128];
+            get_file_name(&FORMATS[i], t, name, sizeof(name));
+            char file_path[4096];
+            snprintf(file_path, sizeof(file_path), "%s/%s", output_dir, name);
+            if (write_dds(file_path, name, &FORMATS[i], t)) {
+                printf("Generated %s\n", file_path);
+                fprintf(manifest, "%s\n", file_path);
+            } else {
+                printf("Failed to generate %s\n", file_path);
+                failed = 1;
+            }
+        }
+    }
+    if (fclose(manifest) != 0)
+        failed = 1;
+    return failed;
+}
@@ -0,0 +1,164 @@
+// syscall() is not in C99.
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+#include <string.h>
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static void init_attr(struct perf_event_attr *attr, CounterId id) {
+    memset(attr, 0, sizeof(struct perf_event_attr));
+    attr->size = sizeof(struct perf_event_attr);
+    attr->type = PERF_TYPE_HARDWARE;
+    switch (id) {
+    case COUNTER_CYCLES:
+        attr->config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case COUNTER_INSTRUCTIONS:
+        attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case COUNTER_LLC_MISSES:
+        // PERF_COUNT_HW_CACHE_MISSES is vendor-defined and can include other levels.
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = PERF_COUNT_HW_CACHE_LL |
+                       (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                       (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    default:
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = PERF_COUNT_HW_CACHE_DTLB |
+                       (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                       (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    }
+    // Members of the group follow the leader. Only the leader is enabled and read.
+    attr->disabled = 1;
+    // User space only. It works with the default perf_event_paranoid (2).
+    attr->exclude_kernel = 1;
+    attr->exclude_hv = 1;
+    attr->read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+                        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+}
+
+int openPerfCounters(PerfCounters *counters, const char **reason) {
+    int count = 0;
+    int error = 0;
+    counters->leader = -1;
+    // Cycles lead the group. If it's not available, the first available counter does.
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        struct perf_event_attr attr;
+        init_attr(&attr, (CounterId)i);
+        // The calling thread on any CPU
+        int group_fd = counters->leader < 0 ? -1 : counters->fds[counters->leader];
+        counters->fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+        if (counters->fds[i] >= 0 &&
+            ioctl(counters->fds[i], PERF_EVENT_IOC_ID, &counters->ids[i]) != 0) {
+            close(counters->fds[i]);
+            counters->fds[i] = -1;
+        }
+        if (counters->fds[i] >= 0) {
+            if (counters->leader < 0)
+                counters->leader = i;
+            count++;
+        } else if (error == 0) {
+            error = errno;
+        }
+    }
+    if (count == 0) {
+        if (error == EACCES || error == EPERM)
+            *reason = "not permitted. See /proc/sys/kernel/perf_event_paranoid.";
+        else if (error == ENOENT || error == EOPNOTSUPP)
+            *reason = "not supported by the CPU or the hypervisor.";
+        else
+            *reason = strerror(error);
+    }
+    return count;
+}
+
+void closePerfCounters(PerfCounters *counters) {
+    // Close members before the leader.
+    for (int i = COUNTER_COUNT - 1; i >= 0; i--) {
+        if (counters->fds[i] >= 0)
+            close(counters->fds[i]);
+        counters->fds[i] = -1;
+    }
+    counters->leader = -1;
+}
+
+void startPerfCounters(PerfCounters *counters) {
+    if (counters->leader < 0)
+        return;
+    int fd = counters->fds[counters->leader];
+    ioctl(fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void stopPerfCounters(PerfCounters *counters, CounterValues *values) {
+    memset(values, 0, sizeof(CounterValues));
+    if (counters->leader < 0)
+        return;
+    int fd = counters->fds[counters->leader];
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    // nr, time_enabled, time_running, and then a pair of value and id for each counter
+    uint64_t data[3 + 2 * COUNTER_COUNT];
+    ssize_t size = read(fd, data, sizeof(data));
+    if (size < (ssize_t)(3 * sizeof(uint64_t)) || data[0] > COUNTER_COUNT ||
+        size < (ssize_t)((3 + 2 * data[0]) * sizeof(uint64_t)))
+        return;
+    // The group didn't run when its counters don't fit in the PMU.
+    if (data[2] == 0)
+        return;
+    for (uint64_t j = 0; j < data[0]; j++) {
+        uint64_t value = data[3 + 2 * j];
+        uint64_t id = data[4 + 2 * j];
+        for (int i = 0; i < COUNTER_COUNT; i++) {
+            if (counters->fds[i] < 0 || counters->ids[i] != id)
+                continue;
+            values->values[i] = data[2] < data[1] ?
+                                (uint64_t)((double)value * data[1] / data[2]) : value;
+            values->valid[i] = 1;
+        }
+    }
+}
+
+#else
+
+int openPerfCounters(PerfCounters *counters, const char **reason) {
+    for (int i = 0; i < COUNTER_COUNT; i++)
+        counters->fds[i] = -1;
+    counters->leader = -1;
+    *reason = "only supported on Linux.";
+    return 0;
+}
+
+void closePerfCounters(PerfCounters *counters) {}
+
+void startPerfCounters(PerfCounters *counters) {}
+
+void stopPerfCounters(PerfCounters *counters, CounterValues *values) {
+    memset(values, 0, sizeof(CounterValues));
+}
+
+#endif
+
+const char *getCounterName(CounterId id) {
+    switch (id) {
+    case COUNTER_CYCLES:
+        return "cycles";
+    case COUNTER_INSTRUCTIONS:
+        return "instructions";
+    case COUNTER_LLC_MISSES:
+        return "llc_misses";
+    case COUNTER_DTLB_MISSES:
+        return "dtlb_misses";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef __SWIZZLER_BENCHMARKS_PERF_COUNTERS_H__
+#define __SWIZZLER_BENCHMARKS_PERF_COUNTERS_H__
+#include <stdint.h>
+
+// Hardware counters of the calling thread. They use perf_event_open() on Linux.
+// Other platforms, and systems that don't permit counters, get no counters.
+
+typedef enum CounterId {
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_LLC_MISSES,  // Last level cache misses
+    COUNTER_DTLB_MISSES,  // Data TLB misses of loads
+    COUNTER_COUNT,
+} CounterId;
+
+// Counters are opened as a group, so they count exactly the same instructions.
+typedef struct PerfCounters {
+    int fds[COUNTER_COUNT];  // -1 for counters that are not available
+    uint64_t ids[COUNTER_COUNT];  // Ids of the counters in the values of the group
+    int leader;  // Index of the group leader, or -1 if no counters are available
+} PerfCounters;
+
+typedef struct CounterValues {
+    uint64_t values[COUNTER_COUNT];
+    int valid[COUNTER_COUNT];  // Zero if the counter is not available
+} CounterValues;
+
+// Opens all counters that the system supports.
+// Returns the number of available counters. The reason is stored when it's zero.
+int openPerfCounters(PerfCounters *counters, const char **reason);
+
+void closePerfCounters(PerfCounters *counters);
+
+// Resets and starts the counters.
+void startPerfCounters(PerfCounters *counters);
+
+// Stops the counters and reads them at once. A multiplexed group is scaled to the whole run.
+void stopPerfCounters(PerfCounters *counters, CounterValues *values);
+
+// Gets a name of a counter for reports.
+const char *getCounterName(CounterId id);
+
+#endif  // __SWIZZLER_BENCHMARKS_PERF_COUNTERS_H__
@@ -52,6 +52,13 @@ _SWIZ_ENUM(SwizError) {
     SWIZ_ERROR_INVALID_GOBS_HEIGHT,
     SWIZ_ERROR_MEMORY_ALLOC,
     SWIZ_ERROR_NULL_POINTER,
+    SWIZ_ERROR_INVALID_THREAD_COUNT,
+    SWIZ_ERROR_UNSUPPORTED_KERNEL_VARIANT,
+    SWIZ_ERROR_INVALID_ROW_COUNT,
+    SWIZ_ERROR_STREAM_WRITE,
+    SWIZ_ERROR_INVALID_RECT,
+    SWIZ_ERROR_OUT_OF_RANGE,
+    SWIZ_ERROR_SIZE_OVERFLOW,
     SWIZ_ERROR_MAX,
 };
 
@@ -75,6 +82,22 @@ _SWIZ_ENUM(SwizPlatform) {
     SWIZ_PLATFORM_MAX,
 };
 
+/**
+ * Instruction sets for swizzling kernels.
+ *
+ * @note Kernels are selected at runtime. One binary uses the fastest kernels on each CPU.
+ *
+ * @enum SwizKernelVariant
+ */
+_SWIZ_ENUM(SwizKernelVariant) {
+    SWIZ_KERNEL_AUTO = 0,  //!< The fastest variant that the CPU supports
+    SWIZ_KERNEL_SCALAR,  //!< Portable C code
+    SWIZ_KERNEL_SSE2,  //!< SSE2
+    SWIZ_KERNEL_AVX2,  //!< AVX2
+    SWIZ_KERNEL_AVX512,  //!< AVX-512 (AVX512F)
+    SWIZ_KERNEL_MAX,
+};
+
 /**
  * Class for context of swizzling.
  *
@@ -180,6 +203,143 @@ _SWIZ_EXTERN SwizError swizContextSetBlockInfo(SwizContext *context,
                                                int block_width, int block_height,
                                                int block_data_size);
 
+/**
+ * Sets the number of threads for swizzling.
+ *
+ * @note The default value is one. Zero means the number of logical processors.
+ * @note Slices, mipmaps, and stripes of large mipmaps will be swizzled on worker threads.
+ *       The result is the same as single-threaded swizzling.
+ * @note Worker threads will be kept until the thread count is changed or the context is freed.
+ *
+ * @param context SwizContext instance
+ * @param thread_count The number of threads
+ * @returns Non-zero if it got errors
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN SwizError swizContextSetThreadCount(SwizContext *context, int thread_count);
+
+/**
+ * Forces swizzling kernels to use an instruction set.
+ *
+ * @note The default value is #SWIZ_KERNEL_AUTO. It is meant for A/B testing.
+ * @note When the variant is #SWIZ_KERNEL_AUTO, the SWIZ_KERNEL_VARIANT environment variable
+ *       can also force a variant. It should be "scalar", "sse2", "avx2", or "avx512".
+ * @note All variants produce the same result.
+ *
+ * @param context SwizContext instance
+ * @param variant An instruction set for kernels
+ * @returns Non-zero if it got errors. The CPU should support the variant.
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN SwizError swizContextSetKernelVariant(SwizContext *context,
+                                                   SwizKernelVariant variant);
+
+/**
+ * Gets the instruction set that swizzling kernels will use.
+ *
+ * @note It never returns #SWIZ_KERNEL_AUTO.
+ *
+ * @param context SwizContext instance
+ * @returns An instruction set for kernels
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN SwizKernelVariant swizContextGetKernelVariant(SwizContext *context);
+
+/**
+ * Sets a buffer that the context uses as scratch memory.
+ *
+ * @note By default, a context allocates scratch memory by itself and keeps it
+ *       until swizFreeContext() is called. The memory only grows when needed.
+ * @note The buffer is not freed by the context. It should be alive until the context is freed,
+ *       or until another workspace is set.
+ * @note Pass NULL to make the context allocate scratch memory by itself again.
+ * @note The buffer should be aligned like memory from malloc().
+ * @note Only batches use scratch memory. See swizGetBatchWorkspaceSize() for the required size.
+ *
+ * @param context SwizContext instance
+ * @param workspace A buffer for scratch memory
+ * @param workspace_size Size of the buffer
+ * @returns Non-zero if it got errors
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN SwizError swizContextSetWorkspace(SwizContext *context,
+                                               void *workspace, size_t workspace_size);
+
+/**
+ * The max number of mipmaps in a slice.
+ */
+#define SWIZ_MAX_MIP_COUNT 32
+
+/**
+ * Statistics of a mipmap. They are summed over slices and calls.
+ *
+ * @struct SwizMipStats
+ */
+typedef struct SwizMipStats {
+    uint64_t bytes_read;  //!< Size of input data
+    uint64_t bytes_written;  //!< Size of output data
+    uint64_t padding_bytes;  //!< Size of padding that swizzling wrote to output data
+    uint64_t kernel_ns;  //!< Wall time of swizzling kernels in nanoseconds
+} SwizMipStats;
+
+/**
+ * Statistics of a context.
+ *
+ * @note Padding is written by swizzling kernels in the same pass as pixels.
+ *       So, its time is a part of kernel_ns.
+ *
+ * @struct SwizStats
+ */
+typedef struct SwizStats {
+    uint64_t call_count;  //!< The number of calls that swizzled or unswizzled data
+    uint64_t bytes_read;  //!< Size of input data
+    uint64_t bytes_written;  //!< Size of output data
+    uint64_t padding_bytes;  //!< Size of padding that swizzling wrote to output data
+    uint64_t scratch_bytes_allocated;  //!< Size of scratch memory that the context allocated
+    uint64_t allocation_count;  //!< The number of heap allocations of the context
+    uint64_t kernel_ns;  //!< Wall time of swizzling kernels in nanoseconds
+    SwizKernelVariant kernel_variant;  //!< The variant of the last call. AUTO if no calls.
+    int mip_count;  //!< The number of elements in mips that have statistics
+    SwizMipStats mips[SWIZ_MAX_MIP_COUNT];  //!< Statistics of each mipmap
+} SwizStats;
+
+/**
+ * Enables or disables statistics of a context.
+ *
+ * @note Statistics are disabled by default. Disabled statistics cost nothing.
+ * @note swizDoSwizzle(), swizDoUnswizzle(), and functions for subresources and chunks
+ *       update statistics. Batches, rectangles, and streams only count allocations.
+ * @note When statistics are enabled, swizDoSwizzle() and swizDoUnswizzle() process mipmaps
+ *       one by one to measure them. Threads still share slices and stripes of a mipmap.
+ * @note Enabling statistics resets them. Disabling them frees their memory.
+ *
+ * @param context SwizContext instance
+ * @param enable Whether to collect statistics or not
+ * @returns Non-zero if it got errors
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN SwizError swizContextSetStatsEnabled(SwizContext *context, int enable);
+
+/**
+ * Gets statistics of a context.
+ *
+ * @note All values are zero when statistics are disabled.
+ *
+ * @param context SwizContext instance
+ * @param stats A pointer to receive statistics
+ * @returns Non-zero if it got errors
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN SwizError swizContextGetStats(SwizContext *context, SwizStats *stats);
+
+/**
+ * Resets statistics of a context to zero.
+ *
+ * @param context SwizContext instance
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN void swizContextResetStats(SwizContext *context);
+
 /**
  * Gets error status of context.
  *
@@ -192,6 +352,9 @@ _SWIZ_EXTERN SwizError swizContextGetLastError(SwizContext *context);
 /**
  * Gets binary size of swizzled data.
  *
+ * @note It returns zero and sets #SWIZ_ERROR_SIZE_OVERFLOW when the size does not fit in 32 bits.
+ *       Use swizGetSwizzledSize64() for large texture arrays.
+ *
  * @param context SwizContext instance
  * @returns Binary size of swizzled data
  * @memberof SwizContext
@@ -201,17 +364,39 @@ _SWIZ_EXTERN uint32_t swizGetSwizzledSize(SwizContext *context);
 /**
  * Gets binary size of unswizzled data.
  *
+ * @note It returns zero and sets #SWIZ_ERROR_SIZE_OVERFLOW when the size does not fit in 32 bits.
+ *       Use swizGetUnswizzledSize64() for large texture arrays.
+ *
  * @param context SwizContext instance
  * @returns Binary size of unswizzled data
  * @memberof SwizContext
  */
 _SWIZ_EXTERN uint32_t swizGetUnswizzledSize(SwizContext *context);
 
+/**
+ * Gets binary size of swizzled data as a 64-bit integer.
+ *
+ * @param context SwizContext instance
+ * @returns Binary size of swizzled data
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN uint64_t swizGetSwizzledSize64(SwizContext *context);
+
+/**
+ * Gets binary size of unswizzled data as a 64-bit integer.
+ *
+ * @param context SwizContext instance
+ * @returns Binary size of unswizzled data
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN uint64_t swizGetUnswizzledSize64(SwizContext *context);
+
 /**
  * Allocates a buffer for swizzled data.
  *
  * @note Allocated data should be freed with free().
- * @note The size of allocated data should be equal to swizGetSwizzledSize()
+ * @note The size of allocated data should be equal to swizGetSwizzledSize64().
+ *       It also works for textures larger than 4 GiB.
  *
  * @param context SwizContext instance
  * @returns A pointer for allocated data. Null if it got errors
@@ -223,7 +408,8 @@ _SWIZ_EXTERN uint8_t *swizAllocSwizzledData(SwizContext *context);
  * Allocates a buffer for unswizzled data.
  *
  * @note Allocated data should be freed with free().
- * @note The size of allocated data should be equal to swizGetUnswizzledSize()
+ * @note The size of allocated data should be equal to swizGetUnswizzledSize64().
+ *       It also works for textures larger than 4 GiB.
  *
  * @param context SwizContext instance
  * @returns A pointer for allocated data. Null if it got errors
@@ -254,6 +440,596 @@ _SWIZ_EXTERN SwizError swizDoSwizzle(const uint8_t *data, uint8_t *swizzled, Swi
 _SWIZ_EXTERN SwizError swizDoUnswizzle(const uint8_t *data, uint8_t *unswizzled,
                                        SwizContext *context);
 
+/**
+ * A rectangle in a texture.
+ *
+ * @note x, y, width, and height are in pixels. They should be aligned to blocks,
+ *       but the rectangle can end at the right or bottom edge of the mipmap.
+ *
+ * @struct SwizRect
+ */
+typedef struct SwizRect {
+    int x;  //!< Left edge of the rectangle
+    int y;  //!< Top edge of the rectangle
+    int width;  //!< Width of the rectangle
+    int height;  //!< Height of the rectangle
+    int mip;  //!< Index of the mipmap
+    int slice;  //!< Index of the texture in the array
+} SwizRect;
+
+/**
+ * Swizzles a rectangle and writes it to swizzled data of the whole texture.
+ *
+ * @note Only blocks in the rectangle are updated. The rest of swizzled data is unchanged.
+ *
+ * @param data Unswizzled data of the rectangle. Rows of blocks should be tightly packed.
+ * @param swizzled Swizzled data. Data size should be equal to swizGetSwizzledSize().
+ * @param rect The rectangle to update
+ * @param context SwizContext instance
+ * @returns Non-zero if it got errors
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN SwizError swizDoSwizzleRect(const uint8_t *data, uint8_t *swizzled,
+                                         const SwizRect *rect, SwizContext *context);
+
+/**
+ * Unswizzles a rectangle from swizzled data of the whole texture.
+ *
+ * @param data Swizzled data. Data size should be equal to swizGetSwizzledSize().
+ * @param unswizzled Unswizzled data of the rectangle. Rows of blocks will be tightly packed.
+ * @param rect The rectangle to read
+ * @param context SwizContext instance
+ * @returns Non-zero if it got errors
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN SwizError swizDoUnswizzleRect(const uint8_t *data, uint8_t *unswizzled,
+                                           const SwizRect *rect, SwizContext *context);
+
+/**
+ * Layout of a mipmap of a slice.
+ *
+ * @struct SwizSubresourceInfo
+ */
+typedef struct SwizSubresourceInfo {
+    int width;  //!< Width of the mipmap
+    int height;  //!< Height of the mipmap
+    uint64_t data_offset;  //!< Offset of the subresource in unswizzled data
+    uint64_t data_size;  //!< Size of the subresource in unswizzled data
+    uint64_t swizzled_offset;  //!< Offset of the subresource in swizzled data
+    uint64_t swizzled_size;  //!< Size of the subresource in swizzled data including padding
+} SwizSubresourceInfo;
+
+/**
+ * Gets the number of mipmaps in a slice.
+ *
+ * @param context SwizContext instance
+ * @returns The number of mipmaps. Zero if it got errors.
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN int swizGetMipCount(SwizContext *context);
+
+/**
+ * Gets offsets and sizes of a mipmap of a slice.
+ *
+ * @note The context computes the layout only when its attributes have changed.
+ *       So, this function and other size functions are cheap to call many times.
+ *
+ * @param context SwizContext instance
+ * @param mip Index of the mipmap
+ * @param slice Index of the texture in the array
+ * @param info A pointer to receive the layout
+ * @returns Non-zero if it got errors
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN SwizError swizGetSubresourceInfo(SwizContext *context, int mip, int slice,
+                                              SwizSubresourceInfo *info);
+
+/**
+ * Swizzles a mipmap of a slice.
+ *
+ * @param data Unswizzled data of the subresource. Data size should be equal to
+ *             data_size of swizGetSubresourceInfo().
+ * @param swizzled Swizzled data of the subresource. Data size should be equal to
+ *                 swizzled_size of swizGetSubresourceInfo().
+ * @param mip Index of the mipmap
+ * @param slice Index of the texture in the array
+ * @param context SwizContext instance
+ * @returns Non-zero if it got errors
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN SwizError swizDoSwizzleSubresource(const uint8_t *data, uint8_t *swizzled,
+                                                int mip, int slice, SwizContext *context);
+
+/**
+ * Unswizzles a mipmap of a slice.
+ *
+ * @note It only reads the subresource. Other mipmaps are not needed.
+ *
+ * @param data Swizzled data of the subresource. Data size should be equal to
+ *             swizzled_size of swizGetSubresourceInfo().
+ * @param unswizzled Unswizzled data of the subresource. Data size should be equal to
+ *                   data_size of swizGetSubresourceInfo().
+ * @param mip Index of the mipmap
+ * @param slice Index of the texture in the array
+ * @param context SwizContext instance
+ * @returns Non-zero if it got errors
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN SwizError swizDoUnswizzleSubresource(const uint8_t *data, uint8_t *unswizzled,
+                                                  int mip, int slice, SwizContext *context);
+
+/**
+ * A range of stripes in a mipmap of a slice.
+ *
+ * @note A stripe is a row of 8x8 tiles for PS4, or a row of GOB blocks for Switch.
+ *       Chunks of a texture are contiguous in both unswizzled and swizzled data.
+ *       So, files can be converted by reading and writing chunks in order.
+ *
+ * @struct SwizChunk
+ */
+typedef struct SwizChunk {
+    int mip;  //!< Index of the mipmap
+    int slice;  //!< Index of the texture in the array
+    int stripe_begin;  //!< Index of the first stripe in the mipmap
+    int stripe_count;  //!< The number of stripes in the chunk
+    uint64_t data_offset;  //!< Offset of the chunk in unswizzled data
+    uint64_t data_size;  //!< Size of the chunk in unswizzled data
+    uint64_t swizzled_offset;  //!< Offset of the chunk in swizzled data
+    uint64_t swizzled_size;  //!< Size of the chunk in swizzled data
+} SwizChunk;
+
+/**
+ * Gets the number of chunks when a texture is split by a memory budget.
+ *
+ * @note A chunk is a subresource, or stripes of a subresource if the subresource is too large.
+ *       data_size + swizzled_size of each chunk will be less than or equal to the budget
+ *       unless a stripe exceeds the budget.
+ *
+ * @param context SwizContext instance
+ * @param memory_budget Max size of unswizzled data and swizzled data of a chunk
+ * @returns The number of chunks. Zero if it got errors.
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN int swizGetChunkCount(SwizContext *context, size_t memory_budget);
+
+/**
+ * Gets the layout of a chunk.
+ *
+ * @param context SwizContext instance
+ * @param memory_budget Max size of unswizzled data and swizzled data of a chunk
+ * @param chunk_index Index of the chunk. Chunks are in the order of offsets.
+ * @param chunk A pointer to receive the chunk
+ * @returns Non-zero if it got errors
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN SwizError swizGetChunk(SwizContext *context, size_t memory_budget, int chunk_index,
+                                    SwizChunk *chunk);
+
+/**
+ * Swizzles a chunk.
+ *
+ * @param data Unswizzled data of the chunk. Data size should be equal to data_size of the chunk.
+ * @param swizzled Swizzled data of the chunk.
+ *                 Data size should be equal to swizzled_size of the chunk.
+ * @param chunk A chunk from swizGetChunk()
+ * @param context SwizContext instance
+ * @returns Non-zero if it got errors
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN SwizError swizDoSwizzleChunk(const uint8_t *data, uint8_t *swizzled,
+                                          const SwizChunk *chunk, SwizContext *context);
+
+/**
+ * Unswizzles a chunk.
+ *
+ * @param data Swizzled data of the chunk. Data size should be equal to swizzled_size of the chunk.
+ * @param unswizzled Unswizzled data of the chunk.
+ *                   Data size should be equal to data_size of the chunk.
+ * @param chunk A chunk from swizGetChunk()
+ * @param context SwizContext instance
+ * @returns Non-zero if it got errors
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN SwizError swizDoUnswizzleChunk(const uint8_t *data, uint8_t *unswizzled,
+                                            const SwizChunk *chunk, SwizContext *context);
+
+/**
+ * Class for a compiled layout of swizzling.
+ *
+ * @note A plan is read-only after swizNewPlan() returns it.
+ *       Multiple threads can use the same plan at the same time.
+ *       Changing the context does not affect plans that were built from it.
+ *
+ * @struct SwizPlan
+ */
+typedef struct SwizPlan SwizPlan;
+
+/**
+ * Builds a new plan from a context.
+ *
+ * @note The returned plan should be freed with swizFreePlan().
+ *
+ * @param context SwizContext instance
+ * @returns A new plan. Null if it got errors. See swizContextGetLastError() for the error.
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN SwizPlan *swizNewPlan(SwizContext *context);
+
+/**
+ * Frees the memory of a plan.
+ *
+ * @param plan The plan to free memory
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN void swizFreePlan(SwizPlan *plan);
+
+/**
+ * Gets binary size of swizzled data.
+ *
+ * @param plan SwizPlan instance
+ * @returns Binary size of swizzled data. Zero if the size does not fit in 32 bits.
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN uint32_t swizPlanGetSwizzledSize(const SwizPlan *plan);
+
+/**
+ * Gets binary size of unswizzled data.
+ *
+ * @param plan SwizPlan instance
+ * @returns Binary size of unswizzled data. Zero if the size does not fit in 32 bits.
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN uint32_t swizPlanGetUnswizzledSize(const SwizPlan *plan);
+
+/**
+ * Gets binary size of swizzled data as a 64-bit integer.
+ *
+ * @param plan SwizPlan instance
+ * @returns Binary size of swizzled data
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN uint64_t swizPlanGetSwizzledSize64(const SwizPlan *plan);
+
+/**
+ * Gets binary size of unswizzled data as a 64-bit integer.
+ *
+ * @param plan SwizPlan instance
+ * @returns Binary size of unswizzled data
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN uint64_t swizPlanGetUnswizzledSize64(const SwizPlan *plan);
+
+/**
+ * Swizzles a texture with a plan.
+ *
+ * @param data Unswizzled data. Data size should be equal to swizPlanGetUnswizzledSize().
+ * @param swizzled Swizzled data. Data size should be equal to swizPlanGetSwizzledSize().
+ * @param plan SwizPlan instance
+ * @returns Non-zero if it got errors
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN SwizError swizPlanDoSwizzle(const uint8_t *data, uint8_t *swizzled,
+                                         const SwizPlan *plan);
+
+/**
+ * Unswizzles a texture with a plan.
+ *
+ * @param data Swizzled data. Data size should be equal to swizPlanGetSwizzledSize().
+ * @param unswizzled Unswizzled data. Data size should be equal to swizPlanGetUnswizzledSize().
+ * @param plan SwizPlan instance
+ * @returns Non-zero if it got errors
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN SwizError swizPlanDoUnswizzle(const uint8_t *data, uint8_t *unswizzled,
+                                           const SwizPlan *plan);
+
+/**
+ * Swizzles a rectangle with a plan.
+ *
+ * @note See swizDoSwizzleRect() for details.
+ *
+ * @param data Unswizzled data of the rectangle. Rows of blocks should be tightly packed.
+ * @param swizzled Swizzled data. Data size should be equal to swizPlanGetSwizzledSize().
+ * @param rect The rectangle to update
+ * @param plan SwizPlan instance
+ * @returns Non-zero if it got errors
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN SwizError swizPlanDoSwizzleRect(const uint8_t *data, uint8_t *swizzled,
+                                             const SwizRect *rect, const SwizPlan *plan);
+
+/**
+ * Unswizzles a rectangle with a plan.
+ *
+ * @param data Swizzled data. Data size should be equal to swizPlanGetSwizzledSize().
+ * @param unswizzled Unswizzled data of the rectangle. Rows of blocks will be tightly packed.
+ * @param rect The rectangle to read
+ * @param plan SwizPlan instance
+ * @returns Non-zero if it got errors
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN SwizError swizPlanDoUnswizzleRect(const uint8_t *data, uint8_t *unswizzled,
+                                               const SwizRect *rect, const SwizPlan *plan);
+
+/**
+ * Gets the number of mipmaps in a slice.
+ *
+ * @param plan SwizPlan instance
+ * @returns The number of mipmaps
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN int swizPlanGetMipCount(const SwizPlan *plan);
+
+/**
+ * Gets offsets and sizes of a mipmap of a slice.
+ *
+ * @param plan SwizPlan instance
+ * @param mip Index of the mipmap
+ * @param slice Index of the texture in the array
+ * @param info A pointer to receive the layout
+ * @returns Non-zero if it got errors
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN SwizError swizPlanGetSubresourceInfo(const SwizPlan *plan, int mip, int slice,
+                                                  SwizSubresourceInfo *info);
+
+/**
+ * Swizzles a mipmap of a slice with a plan.
+ *
+ * @note See swizDoSwizzleSubresource() for details.
+ *
+ * @param data Unswizzled data of the subresource
+ * @param swizzled Swizzled data of the subresource
+ * @param mip Index of the mipmap
+ * @param slice Index of the texture in the array
+ * @param plan SwizPlan instance
+ * @returns Non-zero if it got errors
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN SwizError swizPlanDoSwizzleSubresource(const uint8_t *data, uint8_t *swizzled,
+                                                    int mip, int slice, const SwizPlan *plan);
+
+/**
+ * Unswizzles a mipmap of a slice with a plan.
+ *
+ * @note See swizDoUnswizzleSubresource() for details.
+ *
+ * @param data Swizzled data of the subresource
+ * @param unswizzled Unswizzled data of the subresource
+ * @param mip Index of the mipmap
+ * @param slice Index of the texture in the array
+ * @param plan SwizPlan instance
+ * @returns Non-zero if it got errors
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN SwizError swizPlanDoUnswizzleSubresource(const uint8_t *data, uint8_t *unswizzled,
+                                                      int mip, int slice,
+                                                      const SwizPlan *plan);
+
+/**
+ * Gets the number of chunks when a texture is split by a memory budget.
+ *
+ * @note See swizGetChunkCount() for details.
+ *
+ * @param plan SwizPlan instance
+ * @param memory_budget Max size of unswizzled data and swizzled data of a chunk
+ * @returns The number of chunks
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN int swizPlanGetChunkCount(const SwizPlan *plan, size_t memory_budget);
+
+/**
+ * Gets the layout of a chunk.
+ *
+ * @param plan SwizPlan instance
+ * @param memory_budget Max size of unswizzled data and swizzled data of a chunk
+ * @param chunk_index Index of the chunk
+ * @param chunk A pointer to receive the chunk
+ * @returns Non-zero if it got errors
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN SwizError swizPlanGetChunk(const SwizPlan *plan, size_t memory_budget,
+                                        int chunk_index, SwizChunk *chunk);
+
+/**
+ * Swizzles a chunk with a plan.
+ *
+ * @param data Unswizzled data of the chunk
+ * @param swizzled Swizzled data of the chunk
+ * @param chunk A chunk from swizPlanGetChunk()
+ * @param plan SwizPlan instance
+ * @returns Non-zero if it got errors
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN SwizError swizPlanDoSwizzleChunk(const uint8_t *data, uint8_t *swizzled,
+                                              const SwizChunk *chunk, const SwizPlan *plan);
+
+/**
+ * Unswizzles a chunk with a plan.
+ *
+ * @param data Swizzled data of the chunk
+ * @param unswizzled Unswizzled data of the chunk
+ * @param chunk A chunk from swizPlanGetChunk()
+ * @param plan SwizPlan instance
+ * @returns Non-zero if it got errors
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN SwizError swizPlanDoUnswizzleChunk(const uint8_t *data, uint8_t *unswizzled,
+                                                const SwizChunk *chunk, const SwizPlan *plan);
+
+/**
+ * Gets the position of a block in swizzled data.
+ *
+ * @note It takes constant time. Use it to read a few blocks without unswizzling the texture.
+ *
+ * @param plan SwizPlan instance
+ * @param block_x X coordinate of the block. It's in blocks, not in pixels.
+ * @param block_y Y coordinate of the block. It's in blocks, not in pixels.
+ * @param mip Index of the mipmap
+ * @param slice Index of the texture in the array
+ * @param offset A pointer to receive the byte offset of the block in swizzled data
+ * @returns Non-zero if it got errors
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN SwizError swizPlanGetSwizzledOffset(const SwizPlan *plan, int block_x, int block_y,
+                                                 int mip, int slice, uint64_t *offset);
+
+/**
+ * Gets positions of blocks in swizzled data.
+ *
+ * @note It's the same as calling swizPlanGetSwizzledOffset() for each block.
+ *
+ * @param plan SwizPlan instance
+ * @param block_x An array of x coordinates of blocks
+ * @param block_y An array of y coordinates of blocks
+ * @param count The number of blocks
+ * @param mip Index of the mipmap
+ * @param slice Index of the texture in the array
+ * @param offsets An array to receive byte offsets of blocks in swizzled data
+ * @returns Non-zero if it got errors
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN SwizError swizPlanGetSwizzledOffsets(const SwizPlan *plan,
+                                                  const int *block_x, const int *block_y,
+                                                  int count, int mip, int slice,
+                                                  uint64_t *offsets);
+
+/**
+ * Gets the block that has a byte of swizzled data.
+ *
+ * @note It's the inverse of swizPlanGetSwizzledOffset().
+ *
+ * @param plan SwizPlan instance
+ * @param offset Byte offset in swizzled data
+ * @param block_x A pointer to receive the x coordinate of the block
+ * @param block_y A pointer to receive the y coordinate of the block
+ * @param mip A pointer to receive the index of the mipmap
+ * @param slice A pointer to receive the index of the texture in the array
+ * @returns Non-zero if it got errors. #SWIZ_ERROR_OUT_OF_RANGE if the byte is padding.
+ * @memberof SwizPlan
+ */
+_SWIZ_EXTERN SwizError swizPlanGetBlockPosition(const SwizPlan *plan, uint64_t offset,
+                                                int *block_x, int *block_y,
+                                                int *mip, int *slice);
+
+/**
+ * A texture to swizzle or unswizzle in a batch.
+ *
+ * @note Each texture shape needs its own plan, and a plan is made with a context.
+ *       Batches do not save that cost. Make plans once for each shape and reuse them.
+ * @note Jobs only share threads and a small array to schedule them.
+ *
+ * @struct SwizJob
+ */
+typedef struct SwizJob {
+    const SwizPlan *plan;  //!< Layout of the texture. Jobs can share the same plan.
+    const uint8_t *src;  //!< Input data
+    uint8_t *dst;  //!< Output data
+    SwizError error;  //!< Error status of the job. Batch functions will set it.
+} SwizJob;
+
+/**
+ * Gets the size of scratch memory that batch functions require.
+ *
+ * @note Buffers of swizContextSetWorkspace() should be at least this size to run batches.
+ * @note Swizzling functions and streams need no scratch memory.
+ *
+ * @param job_count The max number of jobs in a batch
+ * @returns Size of scratch memory. Zero if job_count is not positive.
+ */
+_SWIZ_EXTERN size_t swizGetBatchWorkspaceSize(int job_count);
+
+/**
+ * Swizzles textures of jobs.
+ *
+ * @note Jobs are processed on the threads of the context. Large jobs start first,
+ *       and threads that finished their work take the rest of any job.
+ * @note The context only provides threads and scratch memory. Plans of jobs decide layouts.
+ * @note Errors of jobs do not affect the context.
+ *
+ * @param jobs An array of jobs. Each job gets its own error status.
+ * @param job_count The number of jobs
+ * @param context SwizContext instance
+ * @returns Non-zero if the context or some jobs got errors
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN SwizError swizDoSwizzleBatch(SwizJob *jobs, int job_count, SwizContext *context);
+
+/**
+ * Unswizzles textures of jobs.
+ *
+ * @note See swizDoSwizzleBatch() for details.
+ *
+ * @param jobs An array of jobs. Each job gets its own error status.
+ * @param job_count The number of jobs
+ * @param context SwizContext instance
+ * @returns Non-zero if the context or some jobs got errors
+ * @memberof SwizContext
+ */
+_SWIZ_EXTERN SwizError swizDoUnswizzleBatch(SwizJob *jobs, int job_count, SwizContext *context);
+
+/**
+ * Class for swizzling rows of blocks incrementally.
+ *
+ * @struct SwizStream
+ */
+typedef struct SwizStream SwizStream;
+
+/**
+ * A function that receives swizzled data from a stream.
+ *
+ * @param data Swizzled data
+ * @param size Size of the data
+ * @param user_data The pointer that was passed to swizStreamBegin()
+ * @returns Zero on success. Non-zero values stop the stream.
+ */
+typedef int (*SwizStreamWriteFuncPtr)(const uint8_t *data, size_t size, void *user_data);
+
+/**
+ * Starts swizzling unswizzled data that comes in rows of blocks.
+ *
+ * @note The stream writes swizzled data in order as soon as a stripe is complete.
+ *       A stripe is a row of 8x8 tiles for PS4, or a row of GOB blocks for Switch.
+ * @note The stream only buffers a stripe. It allocates the buffer by itself.
+ * @note The stream does not refer to the context after this call. The context can swizzle
+ *       other textures, or be changed or freed, while the stream is open.
+ *
+ * @param context SwizContext instance
+ * @param write_func A function that writes swizzled data
+ * @param user_data A pointer that will be passed to write_func
+ * @returns A new stream. Null if it got errors. See swizContextGetLastError() for the error.
+ * @memberof SwizStream
+ */
+_SWIZ_EXTERN SwizStream *swizStreamBegin(SwizContext *context,
+                                         SwizStreamWriteFuncPtr write_func, void *user_data);
+
+/**
+ * Pushes rows of blocks to a stream.
+ *
+ * @note Rows should be pushed in the same order as unswizzled data (slices, mipmaps, and rows).
+ *       The size of a row is the data size of blocks in a row of the current mipmap.
+ * @note Rows can span multiple mipmaps and slices.
+ *
+ * @param stream SwizStream instance
+ * @param rows Unswizzled rows
+ * @param row_count The number of rows
+ * @returns Non-zero if it got errors
+ * @memberof SwizStream
+ */
+_SWIZ_EXTERN SwizError swizStreamPushRows(SwizStream *stream,
+                                          const uint8_t *rows, int row_count);
+
+/**
+ * Finishes a stream and frees its memory.
+ *
+ * @note Every time a stream is returned from swizStreamBegin(), this method should be called.
+ *
+ * @param stream The stream to finish
+ * @returns Non-zero if it got errors, or if the stream did not receive all rows.
+ * @memberof SwizStream
+ */
+_SWIZ_EXTERN SwizError swizStreamEnd(SwizStream *stream);
+
 #ifdef __cplusplus
 }
 #endif
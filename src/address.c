@@ -0,0 +1,94 @@
+#include "console-swizzler.h"
+#include "priv.h"
+
+#define CEIL_DIV(X, PAD) (((X) + (PAD) - 1) / (PAD))
+
+// Gets the offset of a block in a swizzled mipmap. The block should be in the mipmap.
+static uint64_t get_swizzled_offset(const SwizPlan *plan, const MipPlan *mip,
+                                    int block_x, int block_y) {
+    // A swizzling block can contain multiple blocks on Switch.
+    int swizzle_block_data_size = mip->context.block_data_size;
+    int data_x = block_x * plan->block_data_size;
+    return plan->GetBlockAddressFunc(&mip->context, data_x / swizzle_block_data_size, block_y) +
+           data_x % swizzle_block_data_size;
+}
+
+static int is_block_in_mip(const SwizPlan *plan, const MipPlan *mip, int block_x, int block_y) {
+    return block_x >= 0 && block_y >= 0 &&
+           block_x < CEIL_DIV(mip->context.width, plan->block_width) &&
+           block_y < CEIL_DIV(mip->context.height, plan->block_height);
+}
+
+SwizError swizPlanGetSwizzledOffset(const SwizPlan *plan, int block_x, int block_y,
+                                    int mip, int slice, uint64_t *offset) {
+    if (offset == NULL)
+        return SWIZ_ERROR_NULL_POINTER;
+
+    if (mip < 0 || mip >= plan->mip_count || slice < 0 || slice >= plan->array_size)
+        return SWIZ_ERROR_OUT_OF_RANGE;
+
+    const MipPlan *mip_plan = &plan->mips[mip];
+    if (!is_block_in_mip(plan, mip_plan, block_x, block_y))
+        return SWIZ_ERROR_OUT_OF_RANGE;
+
+    *offset = slice * plan->slice_swizzled_size + mip_plan->swizzled_offset +
+              get_swizzled_offset(plan, mip_plan, block_x, block_y);
+    return SWIZ_OK;
+}
+
+SwizError swizPlanGetSwizzledOffsets(const SwizPlan *plan,
+                                     const int *block_x, const int *block_y, int count,
+                                     int mip, int slice, uint64_t *offsets) {
+    if (count <= 0)
+        return SWIZ_OK;
+
+    if (block_x == NULL || block_y == NULL || offsets == NULL)
+        return SWIZ_ERROR_NULL_POINTER;
+
+    if (mip < 0 || mip >= plan->mip_count || slice < 0 || slice >= plan->array_size)
+        return SWIZ_ERROR_OUT_OF_RANGE;
+
+    const MipPlan *mip_plan = &plan->mips[mip];
+    uint64_t mip_offset = slice * plan->slice_swizzled_size + mip_plan->swizzled_offset;
+    for (int i = 0; i < count; i++) {
+        if (!is_block_in_mip(plan, mip_plan, block_x[i], block_y[i]))
+            return SWIZ_ERROR_OUT_OF_RANGE;
+        offsets[i] = mip_offset + get_swizzled_offset(plan, mip_plan, block_x[i], block_y[i]);
+    }
+    return SWIZ_OK;
+}
+
+SwizError swizPlanGetBlockPosition(const SwizPlan *plan, uint64_t offset,
+                                   int *block_x, int *block_y, int *mip, int *slice) {
+    if (block_x == NULL || block_y == NULL || mip == NULL || slice == NULL)
+        return SWIZ_ERROR_NULL_POINTER;
+
+    if (plan->slice_swizzled_size == 0 || offset >= swizPlanGetSwizzledSize64(plan))
+        return SWIZ_ERROR_OUT_OF_RANGE;
+
+    // Find the mipmap that has the offset.
+    uint64_t offset_in_slice = offset % plan->slice_swizzled_size;
+    int mip_index = 0;
+    while (offset_in_slice >= plan->mips[mip_index].swizzled_offset +
+                              plan->mips[mip_index].swizzled_size)
+        mip_index++;
+
+    const MipPlan *mip_plan = &plan->mips[mip_index];
+    uint64_t offset_in_mip = offset_in_slice - mip_plan->swizzled_offset;
+    int swizzle_block_data_size = mip_plan->context.block_data_size;
+    int x, y;
+    plan->GetBlockPositionFunc(&mip_plan->context, offset_in_mip / swizzle_block_data_size,
+                               &x, &y);
+    x = (x * swizzle_block_data_size + (int)(offset_in_mip % swizzle_block_data_size)) /
+        plan->block_data_size;
+
+    // Padding blocks are not in the texture.
+    if (!is_block_in_mip(plan, mip_plan, x, y))
+        return SWIZ_ERROR_OUT_OF_RANGE;
+
+    *block_x = x;
+    *block_y = y;
+    *mip = mip_index;
+    *slice = (int)(offset / plan->slice_swizzled_size);
+    return SWIZ_OK;
+}
@@ -0,0 +1,140 @@
+#include "console-swizzler.h"
+#include "priv.h"
+
+#define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
+#define MAX(X, Y) (((X) > (Y)) ? (X) : (Y))
+#define CEIL_DIV(X, PAD) (((X) + (PAD) - 1) / (PAD))
+
+// Gets the number of stripes in a chunk of a mipmap.
+// A chunk has at least one stripe even if the stripe is larger than the budget.
+static int get_chunk_stripe_count(const MipPlan *mip, size_t memory_budget) {
+    uint64_t stripe_size = mip->stripe_data_size + mip->stripe_swizzled_size;
+    if (stripe_size == 0)
+        return mip->stripe_count;
+    return (int)MIN((uint64_t)mip->stripe_count, MAX(1, memory_budget / stripe_size));
+}
+
+static int get_mip_chunk_count(const MipPlan *mip, size_t memory_budget) {
+    if (mip->stripe_count == 0)
+        return 0;
+    return CEIL_DIV(mip->stripe_count, get_chunk_stripe_count(mip, memory_budget));
+}
+
+static int get_slice_chunk_count(const SwizPlan *plan, size_t memory_budget) {
+    int count = 0;
+    for (int i = 0; i < plan->mip_count; i++)
+        count += get_mip_chunk_count(&plan->mips[i], memory_budget);
+    return count;
+}
+
+int swizPlanGetChunkCount(const SwizPlan *plan, size_t memory_budget) {
+    return plan->array_size * get_slice_chunk_count(plan, memory_budget);
+}
+
+SwizError swizPlanGetChunk(const SwizPlan *plan, size_t memory_budget, int chunk_index,
+                           SwizChunk *chunk) {
+    if (chunk == NULL)
+        return SWIZ_ERROR_NULL_POINTER;
+
+    int slice_chunk_count = get_slice_chunk_count(plan, memory_budget);
+    if (chunk_index < 0 || chunk_index >= plan->array_size * slice_chunk_count)
+        return SWIZ_ERROR_OUT_OF_RANGE;
+
+    // Find the mipmap of the chunk.
+    int slice = chunk_index / slice_chunk_count;
+    int mip_chunk_index = chunk_index % slice_chunk_count;
+    int mip = 0;
+    while (mip_chunk_index >= get_mip_chunk_count(&plan->mips[mip], memory_budget)) {
+        mip_chunk_index -= get_mip_chunk_count(&plan->mips[mip], memory_budget);
+        mip++;
+    }
+
+    const MipPlan *mip_plan = &plan->mips[mip];
+    int chunk_stripe_count = get_chunk_stripe_count(mip_plan, memory_budget);
+    int stripe_begin = mip_chunk_index * chunk_stripe_count;
+    chunk->mip = mip;
+    chunk->slice = slice;
+    chunk->stripe_begin = stripe_begin;
+    chunk->stripe_count = MIN(chunk_stripe_count, mip_plan->stripe_count - stripe_begin);
+
+    // The last stripe can have fewer rows in unswizzled data.
+    uint64_t data_offset = stripe_begin * mip_plan->stripe_data_size;
+    chunk->data_offset = slice * plan->slice_data_size + mip_plan->data_offset + data_offset;
+    chunk->data_size = MIN(chunk->stripe_count * mip_plan->stripe_data_size,
+                           mip_plan->data_size - data_offset);
+    chunk->swizzled_offset = slice * plan->slice_swizzled_size + mip_plan->swizzled_offset +
+                             stripe_begin * mip_plan->stripe_swizzled_size;
+    chunk->swizzled_size = chunk->stripe_count * mip_plan->stripe_swizzled_size;
+    return SWIZ_OK;
+}
+
+typedef struct ChunkTaskArg ChunkTaskArg;
+struct ChunkTaskArg {
+    const uint8_t *src;
+    uint8_t *dst;
+    const SwizPlan *plan;
+    const MipPlan *mip;
+    const SwizChunk *chunk;
+    int task_count;
+    int swizzle;
+};
+
+static void chunk_task(void *arg, int task_index) {
+    ChunkTaskArg *task = (ChunkTaskArg *)arg;
+    const MipPlan *mip = task->mip;
+    int stripe_count = task->chunk->stripe_count;
+
+    // Split stripes evenly. Offsets are relative to the first stripe of the chunk.
+    int begin = task_index * stripe_count / task->task_count;
+    int end = (task_index + 1) * stripe_count / task->task_count;
+    uint64_t data_offset = begin * mip->stripe_data_size;
+    uint64_t swizzled_offset = begin * mip->stripe_swizzled_size;
+    int stripe_begin = task->chunk->stripe_begin + begin;
+    if (task->swizzle) {
+        task->plan->SwizFunc(task->src + data_offset, task->dst + swizzled_offset,
+                             &mip->context, stripe_begin, end - begin);
+    } else {
+        task->plan->UnswizFunc(task->src + swizzled_offset, task->dst + data_offset,
+                               &mip->context, stripe_begin, end - begin);
+    }
+}
+
+SwizError swizPlanDoSwizzleChunkBase(const uint8_t *src, uint8_t *dst, const SwizChunk *chunk,
+                                     const SwizPlan *plan, int swizzle, SwizThreadPool *pool) {
+    if (src == NULL || dst == NULL || chunk == NULL)
+        return SWIZ_ERROR_NULL_POINTER;
+
+    if (chunk->mip < 0 || chunk->mip >= plan->mip_count ||
+        chunk->slice < 0 || chunk->slice >= plan->array_size)
+        return SWIZ_ERROR_OUT_OF_RANGE;
+
+    const MipPlan *mip = &plan->mips[chunk->mip];
+    if (chunk->stripe_begin < 0 || chunk->stripe_count < 0 ||
+        chunk->stripe_begin > mip->stripe_count - chunk->stripe_count)
+        return SWIZ_ERROR_OUT_OF_RANGE;
+
+    if (chunk->stripe_count == 0)
+        return SWIZ_OK;
+
+    // Large chunks are split into as many tasks as the mipmap would be.
+    ChunkTaskArg task;
+    task.src = src;
+    task.dst = dst;
+    task.plan = plan;
+    task.mip = mip;
+    task.chunk = chunk;
+    task.task_count = MAX(1, mip->task_count * chunk->stripe_count / mip->stripe_count);
+    task.swizzle = swizzle;
+    swizThreadPoolRun(pool, task.task_count, chunk_task, &task);
+    return SWIZ_OK;
+}
+
+SwizError swizPlanDoSwizzleChunk(const uint8_t *data, uint8_t *swizzled,
+                                 const SwizChunk *chunk, const SwizPlan *plan) {
+    return swizPlanDoSwizzleChunkBase(data, swizzled, chunk, plan, 1, NULL);
+}
+
+SwizError swizPlanDoUnswizzleChunk(const uint8_t *data, uint8_t *unswizzled,
+                                   const SwizChunk *chunk, const SwizPlan *plan) {
+    return swizPlanDoSwizzleChunkBase(data, unswizzled, chunk, plan, 0, NULL);
+}
@@ -2,16 +2,36 @@
 #include "console-swizzler.h"
 #include "priv.h"
 
-#define MAX(X, Y) (((X) > (Y)) ? (X) : (Y))
-#define CEIL_DIV(X, PAD) (((X) + (PAD) - 1) / (PAD))
-
 SwizContext *swizNewContext() {
     SwizContext *context = (SwizContext *)malloc(sizeof(SwizContext));
+    if (context != NULL) {
+        // swizContextInit() keeps the workspace. So, we initialize it here.
+        context->workspace = NULL;
+        context->workspace_size = 0;
+        context->owns_workspace = 1;
+        context->thread_pool = NULL;
+        context->plan = NULL;
+        context->stats = NULL;
+    }
     swizContextInit(context);
     return context;
 }
 
+static void free_workspace(SwizContext *context) {
+    if (context->owns_workspace)
+        free(context->workspace);
+    context->workspace = NULL;
+    context->workspace_size = 0;
+    context->owns_workspace = 1;
+}
+
 void swizFreeContext(SwizContext *context) {
+    if (context == NULL)
+        return;
+    free_workspace(context);
+    swizFreeThreadPool(context->thread_pool);
+    free(context->plan);
+    free(context->stats);
     free(context);
 }
 
@@ -26,15 +46,23 @@ void swizContextInit(SwizContext *context) {
         context->block_data_size = 0;
         context->gobs_height = 16;
         context->has_mips = 0;
+        context->thread_count = 1;
+        context->kernel_variant = SWIZ_KERNEL_AUTO;
+        context->plan_is_dirty = 1;
         context->SwizFunc = NULL;
         context->UnswizFunc = NULL;
         context->GetSwizzleBlockSizeFunc = NULL;
         context->GetPaddedSizeFunc = NULL;
+        context->GetStripeHeightFunc = NULL;
+        context->GetBlockAddressFunc = NULL;
+        context->GetBlockPositionFunc = NULL;
+        context->InitRectTileContextFunc = NULL;
         context->error = SWIZ_OK;
     }
 }
 
 SwizError swizContextSetPlatform(SwizContext *context, SwizPlatform platform) {
+    context->plan_is_dirty = 1;
     context->platform = platform;
     switch (platform) {
     case SWIZ_PLATFORM_PS4:
@@ -42,12 +70,20 @@ SwizError swizContextSetPlatform(SwizContext *context, SwizPlatform platform) {
         context->UnswizFunc = unswizFuncPS4;
         context->GetSwizzleBlockSizeFunc = getSwizzleBlockSizeDefault;
         context->GetPaddedSizeFunc = getPaddedSizePS4;
+        context->GetStripeHeightFunc = getStripeHeightPS4;
+        context->GetBlockAddressFunc = getBlockAddressPS4;
+        context->GetBlockPositionFunc = getBlockPositionPS4;
+        context->InitRectTileContextFunc = initRectTileContextPS4;
         break;
     case SWIZ_PLATFORM_SWITCH:
         context->SwizFunc = swizFuncSwitch;
         context->UnswizFunc = unswizFuncSwitch;
         context->GetSwizzleBlockSizeFunc = getSwizzleBlockSizeSwitch;
         context->GetPaddedSizeFunc = getPaddedSizeSwitch;
+        context->GetStripeHeightFunc = getStripeHeightSwitch;
+        context->GetBlockAddressFunc = getBlockAddressSwitch;
+        context->GetBlockPositionFunc = getBlockPositionSwitch;
+        context->InitRectTileContextFunc = initRectTileContextSwitch;
         break;
     default:
         context->error = SWIZ_ERROR_UNKNOWN_PLATFORM;
@@ -56,11 +92,16 @@ SwizError swizContextSetPlatform(SwizContext *context, SwizPlatform platform) {
         context->UnswizFunc = NULL;
         context->GetSwizzleBlockSizeFunc = NULL;
         context->GetPaddedSizeFunc = NULL;
+        context->GetStripeHeightFunc = NULL;
+        context->GetBlockAddressFunc = NULL;
+        context->GetBlockPositionFunc = NULL;
+        context->InitRectTileContextFunc = NULL;
     }
     return context->error;
 }
 
 SwizError swizContextSetTextureSize(SwizContext *context, int width, int height) {
+    context->plan_is_dirty = 1;
     context->width = width;
     context->height = height;
     if (context->width < 0 || context->height < 0) {
@@ -72,10 +113,12 @@ SwizError swizContextSetTextureSize(SwizContext *context, int width, int height)
 }
 
 void swizContextSetHasMips(SwizContext *context, int has_mips) {
+    context->plan_is_dirty = 1;
     context->has_mips = has_mips > 0;
 }
 
 SwizError swizContextSetArraySize(SwizContext *context, int array_size) {
+    context->plan_is_dirty = 1;
     context->array_size = array_size;
     if (context->array_size <= 0) {
         context->error = SWIZ_ERROR_INVALID_ARRAY_SIZE;
@@ -85,6 +128,7 @@ SwizError swizContextSetArraySize(SwizContext *context, int array_size) {
 }
 
 SwizError swizContextSetGobsHeight(SwizContext *context, int gobs_height) {
+    context->plan_is_dirty = 1;
     if (gobs_height != 1 && gobs_height != 2 &&
         gobs_height != 4 && gobs_height != 8 &&
         gobs_height != 16 && gobs_height != 32) {
@@ -98,6 +142,7 @@ SwizError swizContextSetGobsHeight(SwizContext *context, int gobs_height) {
 
 SwizError swizContextSetBlockInfo(SwizContext *context,
                                   int block_width, int block_height, int block_data_size) {
+    context->plan_is_dirty = 1;
     context->block_width = block_width;
     context->block_height = block_height;
     context->block_data_size = block_data_size;
@@ -110,11 +155,126 @@ SwizError swizContextSetBlockInfo(SwizContext *context,
     return context->error;
 }
 
+SwizError swizContextSetThreadCount(SwizContext *context, int thread_count) {
+    if (thread_count < 0) {
+        context->error = SWIZ_ERROR_INVALID_THREAD_COUNT;
+        context->thread_count = 1;
+    } else if (thread_count == 0) {
+        context->thread_count = swizGetCPUCount();
+    } else {
+        context->thread_count = thread_count;
+    }
+    return context->error;
+}
+
+SwizError swizContextSetKernelVariant(SwizContext *context, SwizKernelVariant variant) {
+    context->plan_is_dirty = 1;
+    if (variant >= SWIZ_KERNEL_MAX || variant > swizGetBestKernelVariant()) {
+        context->error = SWIZ_ERROR_UNSUPPORTED_KERNEL_VARIANT;
+        context->kernel_variant = SWIZ_KERNEL_AUTO;
+    } else {
+        context->kernel_variant = variant;
+    }
+    return context->error;
+}
+
+SwizKernelVariant swizContextGetKernelVariant(SwizContext *context) {
+    return swizResolveKernelVariant(context->kernel_variant);
+}
+
+SwizThreadPool *swizContextGetThreadPool(SwizContext *context) {
+    if (context->thread_count <= 1)
+        return NULL;
+
+    // Threads will be kept until the thread count is changed or the context is freed.
+    // A pool that got fewer threads is kept too. Otherwise, every call would retry.
+    if (context->thread_pool != NULL &&
+        swizThreadPoolGetThreadCount(context->thread_pool) != context->thread_count) {
+        swizFreeThreadPool(context->thread_pool);
+        context->thread_pool = NULL;
+    }
+    if (context->thread_pool == NULL)
+        context->thread_pool = swizNewThreadPool(context->thread_count);
+    // Use the caller's thread only when we could not create a pool.
+    return context->thread_pool;
+}
+
+SwizError swizContextSetWorkspace(SwizContext *context,
+                                  void *workspace, size_t workspace_size) {
+    free_workspace(context);
+    if (workspace != NULL) {
+        context->workspace = (uint8_t *)workspace;
+        context->workspace_size = workspace_size;
+        context->owns_workspace = 0;
+    }
+    return context->error;
+}
+
+uint8_t *swizContextReserveWorkspace(SwizContext *context, size_t size) {
+    if (size <= context->workspace_size)
+        return context->workspace;
+
+    if (!context->owns_workspace) {
+        // We should not replace the buffer that users gave us.
+        context->error = SWIZ_ERROR_MEMORY_ALLOC;
+        return NULL;
+    }
+
+    uint8_t *workspace = (uint8_t *)realloc(context->workspace, size);
+    if (workspace == NULL) {
+        context->error = SWIZ_ERROR_MEMORY_ALLOC;
+        return NULL;
+    }
+    context->workspace = workspace;
+    context->workspace_size = size;
+    if (context->stats != NULL) {
+        context->stats->scratch_bytes_allocated += size;
+        context->stats->allocation_count++;
+    }
+    return workspace;
+}
+
+SwizError swizContextSetStatsEnabled(SwizContext *context, int enable) {
+    if (!enable) {
+        free(context->stats);
+        context->stats = NULL;
+        return context->error;
+    }
+    if (context->stats == NULL) {
+        context->stats = (SwizStats *)malloc(sizeof(SwizStats));
+        if (context->stats == NULL) {
+            context->error = SWIZ_ERROR_MEMORY_ALLOC;
+            return context->error;
+        }
+    }
+    swizContextResetStats(context);
+    return context->error;
+}
+
+SwizError swizContextGetStats(SwizContext *context, SwizStats *stats) {
+    if (stats == NULL) {
+        context->error = SWIZ_ERROR_NULL_POINTER;
+        return context->error;
+    }
+    if (context->stats == NULL)
+        memset(stats, 0, sizeof(SwizStats));
+    else
+        *stats = *context->stats;
+    return context->error;
+}
+
+void swizContextResetStats(SwizContext *context) {
+    if (context->stats != NULL) {
+        memset(context->stats, 0, sizeof(SwizStats));
+        context->stats->kernel_variant = SWIZ_KERNEL_AUTO;
+    }
+}
+
 SwizError swizContextGetLastError(SwizContext *context) {
     return context->error;
 }
 
-static SwizError swizContextValidate(SwizContext *context) {
+SwizError swizContextValidate(SwizContext *context) {
     if (context->platform == SWIZ_PLATFORM_UNK)
         context->error = SWIZ_ERROR_UNKNOWN_PLATFORM;
 
@@ -137,67 +297,64 @@ static SwizError swizContextValidate(SwizContext *context) {
     return context->error;
 }
 
-static int log2_int(int n) {
-    int ret = 0;
-    while (n >>= 1) ++ret;
-    return ret;
+const SwizPlan *swizContextGetPlan(SwizContext *context) {
+    if (context->error != SWIZ_OK)
+        return NULL;
+
+    // Build the layout only when the context has changed.
+    if (context->plan_is_dirty) {
+        if (context->plan == NULL) {
+            context->plan = (SwizPlan *)malloc(sizeof(SwizPlan));
+            if (context->plan == NULL) {
+                context->error = SWIZ_ERROR_MEMORY_ALLOC;
+                return NULL;
+            }
+            if (context->stats != NULL)
+                context->stats->allocation_count++;
+        }
+        if (swizPlanInit(context->plan, context) != SWIZ_OK)
+            return NULL;
+        context->plan_is_dirty = 0;
+    }
+    return context->plan;
 }
 
-static int count_mips(int width, int height) {
-    return MAX(log2_int(width), log2_int(height)) + 1;
+static uint64_t get_data_size_base(SwizContext *context, int swizzle) {
+    const SwizPlan *plan = swizContextGetPlan(context);
+    if (plan == NULL)
+        return 0;
+
+    if (swizzle)
+        return swizPlanGetSwizzledSize64(plan);
+    return swizPlanGetUnswizzledSize64(plan);
 }
 
-static MipContext context_to_mipcontext(SwizContext *context) {
-    MipContext mc = { 0 };
-    mc.width = context->width;
-    mc.height = context->height;
-    mc.block_width = context->block_width;
-    mc.block_height = context->block_height;
-    mc.block_data_size = context->block_data_size;
-    mc.gobs_height = context->gobs_height;
-    return mc;
+// Gets a data size for 32-bit functions.
+// Large textures should fail here. Otherwise, callers will allocate wrapped-around sizes.
+static uint32_t get_data_size_base32(SwizContext *context, int swizzle) {
+    uint64_t data_size = get_data_size_base(context, swizzle);
+    if (data_size > UINT32_MAX) {
+        context->error = SWIZ_ERROR_SIZE_OVERFLOW;
+        return 0;
+    }
+    return (uint32_t)data_size;
 }
 
-static uint32_t get_mip_data_size(MipContext *context) {
-    uint32_t block_count_x = CEIL_DIV(context->width, context->block_width);
-    uint32_t block_count_y = CEIL_DIV(context->height, context->block_height);
-    return block_count_x * block_count_y * context->block_data_size;
+int swizGetMipCount(SwizContext *context) {
+    const SwizPlan *plan = swizContextGetPlan(context);
+    if (plan == NULL)
+        return 0;
+    return swizPlanGetMipCount(plan);
 }
 
-static uint32_t get_data_size_base(SwizContext *context, int swizzle) {
-    MipContext mc = context_to_mipcontext(context);
-    GetSwizzleBlockSizeFuncPtr GetSwizzleBlockSizeFunc;
-    GetPaddedSizeFuncPtr GetPaddedSizeFunc;
-    if (swizzle) {
-        GetSwizzleBlockSizeFunc = context->GetSwizzleBlockSizeFunc;
-        GetPaddedSizeFunc = context->GetPaddedSizeFunc;
-    } else {
-        GetSwizzleBlockSizeFunc = getSwizzleBlockSizeDefault;
-        GetPaddedSizeFunc = getPaddedSizeDefault;
-    }
+SwizError swizGetSubresourceInfo(SwizContext *context, int mip, int slice,
+                                 SwizSubresourceInfo *info) {
+    const SwizPlan *plan = swizContextGetPlan(context);
+    if (plan == NULL)
+        return context->error;
 
-    // Swizzling blocks are not the same as compression blocks on some platforms.
-    // So, we need to update block info here.
-    GetSwizzleBlockSizeFunc(&mc);
-
-    int mip_count = 1;
-    int width = context->width;
-    int height = context->height;
-
-    if (context->has_mips)
-        mip_count = count_mips(width, height);
-
-    uint32_t data_size = 0;
-    for (int i = 0; i < mip_count; i++) {
-        mc.width = width;
-        mc.height = height;
-        // some platforms requires padding. so, we need to resize mipmaps here.
-        GetPaddedSizeFunc(&mc);
-        data_size += get_mip_data_size(&mc);
-        width = MAX(1, width / 2);
-        height = MAX(1, height / 2);
-    }
-    return data_size * context->array_size;
+    // Invalid arguments don't affect the context.
+    return swizPlanGetSubresourceInfo(plan, mip, slice, info);
 }
 
 uint32_t swizGetSwizzledSize(SwizContext *context) {
@@ -205,7 +362,7 @@ uint32_t swizGetSwizzledSize(SwizContext *context) {
     if (context->error != SWIZ_OK)
         return 0;
 
-    return get_data_size_base(context, 1);
+    return get_data_size_base32(context, 1);
 }
 
 uint32_t swizGetUnswizzledSize(SwizContext *context) {
@@ -213,12 +370,33 @@ uint32_t swizGetUnswizzledSize(SwizContext *context) {
     if (context->error != SWIZ_OK)
         return 0;
 
+    return get_data_size_base32(context, 0);
+}
+
+uint64_t swizGetSwizzledSize64(SwizContext *context) {
+    swizContextValidate(context);
+    if (context->error != SWIZ_OK)
+        return 0;
+
+    return get_data_size_base(context, 1);
+}
+
+uint64_t swizGetUnswizzledSize64(SwizContext *context) {
+    swizContextValidate(context);
+    if (context->error != SWIZ_OK)
+        return 0;
+
     return get_data_size_base(context, 0);
 }
 
 static uint8_t *alloc_data_base(SwizContext *context, int swizzle) {
-    uint32_t data_size = get_data_size_base(context, swizzle);
-    uint8_t *data = (uint8_t *)calloc(data_size, sizeof(uint8_t));
+    uint64_t data_size = get_data_size_base(context, swizzle);
+    if (data_size > SIZE_MAX) {
+        // 32-bit processes can't allocate it.
+        context->error = SWIZ_ERROR_MEMORY_ALLOC;
+        return NULL;
+    }
+    uint8_t *data = (uint8_t *)calloc((size_t)data_size, sizeof(uint8_t));
     if (data == NULL)
         context->error = SWIZ_ERROR_MEMORY_ALLOC;
     return data;
@@ -240,139 +418,148 @@ uint8_t *swizAllocUnswizzledData(SwizContext *context) {
     return alloc_data_base(context, 0);
 }
 
-static void copy_mip(const uint8_t *src, uint8_t *dst,
-                     int src_pitch, int dst_pitch, int copy_pitch, int block_count_y) {
-    for (int i = 0; i < block_count_y; i++) {
-        memcpy(dst, src, copy_pitch);
-        src += src_pitch;
-        dst += dst_pitch;
+static SwizError do_swizzle_base(const uint8_t *src, uint8_t *dst,
+                                 SwizContext *context, int swizzle) {
+    const SwizPlan *plan = swizContextGetPlan(context);
+    if (plan == NULL)
+        return context->error;
+
+    if (src == NULL || dst == NULL) {
+        context->error = SWIZ_ERROR_NULL_POINTER;
+        return context->error;
     }
+
+    SwizThreadPool *pool = swizContextGetThreadPool(context);
+    if (context->stats != NULL)
+        context->error = swizPlanDoSwizzleWithStats(src, dst, plan, swizzle, pool,
+                                                    context->stats);
+    else
+        context->error = swizPlanDoSwizzleBase(src, dst, plan, swizzle, pool);
+    return context->error;
 }
 
-static void copy_padded_mips(const uint8_t *src, uint8_t *dst,
-                             SwizContext *context, int mip_count,
-                             MipContext* mc, MipContext* padded_mc, int swizzle) {
-    for (int i = 0; i < context->array_size; i++) {
-        mc->width = context->width;
-        mc->height = context->height;
-
-        // swizzle mipmaps of a texture.
-        for (int j = 0; j < mip_count; j++) {
-            // some platforms requires padding. so, we need to resize mipmaps here.
-            padded_mc->width = mc->width;
-            padded_mc->height = mc->height;
-            context->GetPaddedSizeFunc(padded_mc);
-
-            int pitch = CEIL_DIV(mc->width, mc->block_width) * mc->block_data_size;
-            int padded_pitch = padded_mc->width / padded_mc->block_width *
-                               padded_mc->block_data_size;
-            int block_count_y = CEIL_DIV(mc->height, mc->block_height);
-            // data size of an unswizzled mipmap.
-            uint32_t data_size = get_mip_data_size(mc);
-            uint32_t padded_data_size = get_mip_data_size(padded_mc);
-
-            if (swizzle) {
-                copy_mip(src, dst, pitch, padded_pitch, pitch, block_count_y);
-                src += data_size;
-                dst += padded_data_size;
-            } else {
-                copy_mip(src, dst, padded_pitch, pitch, pitch, block_count_y);
-                src += padded_data_size;
-                dst += data_size;
-            }
+SwizError swizDoSwizzle(const uint8_t *data, uint8_t *swizzled, SwizContext *context) {
+    return do_swizzle_base(data, swizzled, context, 1);
+}
 
-            mc->width = MAX(1, mc->width / 2);
-            mc->height = MAX(1, mc->height / 2);
-        }
-    }
+SwizError swizDoUnswizzle(const uint8_t *data, uint8_t *unswizzled, SwizContext *context) {
+    return do_swizzle_base(data, unswizzled, context, 0);
 }
 
-static void swizzle_padded_mips(const uint8_t *src, uint8_t *dst,
-                                SwizContext *context, int mip_count,
-                                MipContext* mc, MipContext* padded_mc, int swizzle) {
-    SwizFuncPtr SwizFunc;
-    if (swizzle) {
-        SwizFunc = context->SwizFunc;
-    } else {
-        SwizFunc = context->UnswizFunc;
+static SwizError do_swizzle_batch_base(SwizJob *jobs, int job_count,
+                                       SwizContext *context, int swizzle) {
+    if (context->error != SWIZ_OK || job_count <= 0)
+        return context->error;
+
+    if (jobs == NULL) {
+        context->error = SWIZ_ERROR_NULL_POINTER;
+        return context->error;
     }
 
-    for (int i = 0; i < context->array_size; i++) {
-        mc->width = context->width;
-        mc->height = context->height;
+    uint8_t *workspace = swizContextReserveWorkspace(context,
+                                                     swizGetBatchWorkspaceSize(job_count));
+    if (workspace == NULL)
+        return context->error;
 
-        // swizzle mipmaps of a texture.
-        for (int j = 0; j < mip_count; j++) {
-            // some platforms requires padding. so, we need to resize mipmaps here.
-            padded_mc->width = mc->width;
-            padded_mc->height = mc->height;
-            context->GetPaddedSizeFunc(padded_mc);
+    // Errors of jobs don't affect the context.
+    return swizPlanDoSwizzleBatch(jobs, job_count, swizzle,
+                                  swizContextGetThreadPool(context), workspace);
+}
 
-            // Do swizzling for a mipmap
-            SwizFunc(src, dst, padded_mc);
+SwizError swizDoSwizzleBatch(SwizJob *jobs, int job_count, SwizContext *context) {
+    return do_swizzle_batch_base(jobs, job_count, context, 1);
+}
 
-            // data size of a swizzled mipmap.
-            uint32_t padded_data_size = get_mip_data_size(padded_mc);
+SwizError swizDoUnswizzleBatch(SwizJob *jobs, int job_count, SwizContext *context) {
+    return do_swizzle_batch_base(jobs, job_count, context, 0);
+}
 
-            src += padded_data_size;
-            dst += padded_data_size;
+static SwizError do_swizzle_rect_base(const uint8_t *src, uint8_t *dst, const SwizRect *rect,
+                                      SwizContext *context, int swizzle) {
+    const SwizPlan *plan = swizContextGetPlan(context);
+    if (plan == NULL)
+        return context->error;
 
-            mc->width = MAX(1, mc->width / 2);
-            mc->height = MAX(1, mc->height / 2);
-        }
-    }
+    context->error = swizPlanDoSwizzleRectBase(src, dst, rect, plan, swizzle);
+    return context->error;
 }
 
-static SwizError do_swizzle_base(const uint8_t *src, uint8_t *dst,
-                                 SwizContext *context, int swizzle) {
-    swizContextValidate(context);
+SwizError swizDoSwizzleRect(const uint8_t *data, uint8_t *swizzled,
+                            const SwizRect *rect, SwizContext *context) {
+    return do_swizzle_rect_base(data, swizzled, rect, context, 1);
+}
 
-    if (context->error != SWIZ_OK)
-        return context->error;
+SwizError swizDoUnswizzleRect(const uint8_t *data, uint8_t *unswizzled,
+                              const SwizRect *rect, SwizContext *context) {
+    return do_swizzle_rect_base(data, unswizzled, rect, context, 0);
+}
 
-    if (src == NULL || dst == NULL) {
-        context->error = SWIZ_ERROR_NULL_POINTER;
+static SwizError do_swizzle_subresource_base(const uint8_t *src, uint8_t *dst,
+                                             int mip, int slice,
+                                             SwizContext *context, int swizzle) {
+    const SwizPlan *plan = swizContextGetPlan(context);
+    if (plan == NULL)
         return context->error;
+
+    uint64_t start = context->stats != NULL ? swizGetTimeNs() : 0;
+    context->error = swizPlanDoSwizzleSubresourceBase(src, dst, plan, mip, slice, swizzle,
+                                                      swizContextGetThreadPool(context));
+    if (context->stats != NULL && context->error == SWIZ_OK) {
+        swizStatsAddCall(context->stats, plan);
+        swizStatsAddMip(context->stats, mip, plan->mips[mip].data_size,
+                        plan->mips[mip].swizzled_size, swizzle, swizGetTimeNs() - start);
     }
+    return context->error;
+}
 
-    uint8_t* padded_buffer;
-    padded_buffer = alloc_data_base(context, 1);
+SwizError swizDoSwizzleSubresource(const uint8_t *data, uint8_t *swizzled,
+                                   int mip, int slice, SwizContext *context) {
+    return do_swizzle_subresource_base(data, swizzled, mip, slice, context, 1);
+}
 
-    if (context->error != SWIZ_OK) {  // padded_buffer == NULL
-        return context->error;
-    }
+SwizError swizDoUnswizzleSubresource(const uint8_t *data, uint8_t *unswizzled,
+                                     int mip, int slice, SwizContext *context) {
+    return do_swizzle_subresource_base(data, unswizzled, mip, slice, context, 0);
+}
 
-    MipContext mc = context_to_mipcontext(context);
+int swizGetChunkCount(SwizContext *context, size_t memory_budget) {
+    const SwizPlan *plan = swizContextGetPlan(context);
+    if (plan == NULL)
+        return 0;
+    return swizPlanGetChunkCount(plan, memory_budget);
+}
 
-    // Swizzling blocks are not the same as compression blocks on some platforms.
-    // So, we need to update block info here.
-    MipContext padded_mc = context_to_mipcontext(context);
-    context->GetSwizzleBlockSizeFunc(&padded_mc);
+SwizError swizGetChunk(SwizContext *context, size_t memory_budget, int chunk_index,
+                       SwizChunk *chunk) {
+    const SwizPlan *plan = swizContextGetPlan(context);
+    if (plan == NULL)
+        return context->error;
+    return swizPlanGetChunk(plan, memory_budget, chunk_index, chunk);
+}
 
-    int mip_count = 1;
-    if (context->has_mips)
-        mip_count = count_mips(mc.width, mc.height);
+static SwizError do_swizzle_chunk_base(const uint8_t *src, uint8_t *dst, const SwizChunk *chunk,
+                                       SwizContext *context, int swizzle) {
+    const SwizPlan *plan = swizContextGetPlan(context);
+    if (plan == NULL)
+        return context->error;
 
-    if (swizzle) {
-        // copy src to padded buffer.
-        copy_padded_mips(src, padded_buffer, context, mip_count, &mc, &padded_mc, swizzle);
-        // swizzle padded buffer.
-        swizzle_padded_mips(padded_buffer, dst, context, mip_count, &mc, &padded_mc, swizzle);
-    } else {
-        // unswizzle src.
-        swizzle_padded_mips(src, padded_buffer, context, mip_count, &mc, &padded_mc, swizzle);
-        // copy padded buffer to dst.
-        copy_padded_mips(padded_buffer, dst, context, mip_count, &mc, &padded_mc, swizzle);
+    uint64_t start = context->stats != NULL ? swizGetTimeNs() : 0;
+    context->error = swizPlanDoSwizzleChunkBase(src, dst, chunk, plan, swizzle,
+                                                swizContextGetThreadPool(context));
+    if (context->stats != NULL && context->error == SWIZ_OK) {
+        swizStatsAddCall(context->stats, plan);
+        swizStatsAddMip(context->stats, chunk->mip, chunk->data_size, chunk->swizzled_size,
+                        swizzle, swizGetTimeNs() - start);
     }
-
-    free(padded_buffer);
     return context->error;
 }
 
-SwizError swizDoSwizzle(const uint8_t *data, uint8_t *swizzled, SwizContext *context) {
-    return do_swizzle_base(data, swizzled, context, 1);
+SwizError swizDoSwizzleChunk(const uint8_t *data, uint8_t *swizzled,
+                             const SwizChunk *chunk, SwizContext *context) {
+    return do_swizzle_chunk_base(data, swizzled, chunk, context, 1);
 }
 
-SwizError swizDoUnswizzle(const uint8_t *data, uint8_t *unswizzled, SwizContext *context) {
-    return do_swizzle_base(data, unswizzled, context, 0);
+SwizError swizDoUnswizzleChunk(const uint8_t *data, uint8_t *unswizzled,
+                               const SwizChunk *chunk, SwizContext *context) {
+    return do_swizzle_chunk_base(data, unswizzled, chunk, context, 0);
 }
@@ -0,0 +1,415 @@
+#include <string.h>
+#include "console-swizzler.h"
+#include "priv.h"
+
+#define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
+#define MAX(X, Y) (((X) > (Y)) ? (X) : (Y))
+#define CEIL_DIV(X, PAD) (((X) + (PAD) - 1) / (PAD))
+
+// Mipmaps larger than this will be split into multiple tasks.
+#define TASK_SWIZZLED_SIZE (256 * 1024)
+
+static int log2_int(int n) {
+    int ret = 0;
+    while (n >>= 1) ++ret;
+    return ret;
+}
+
+static int count_mips(int width, int height) {
+    return MAX(log2_int(width), log2_int(height)) + 1;
+}
+
+static uint64_t get_mip_data_size(const MipContext *context) {
+    uint64_t block_count_x = CEIL_DIV(context->width, context->block_width);
+    uint64_t block_count_y = CEIL_DIV(context->height, context->block_height);
+    return block_count_x * block_count_y * context->block_data_size;
+}
+
+SwizError swizPlanInit(SwizPlan *plan, SwizContext *context) {
+    if (swizContextValidate(context) != SWIZ_OK)
+        return context->error;
+
+    plan->platform = context->platform;
+    plan->block_width = context->block_width;
+    plan->block_height = context->block_height;
+    plan->block_data_size = context->block_data_size;
+    plan->array_size = context->array_size;
+    plan->SwizFunc = context->SwizFunc;
+    plan->UnswizFunc = context->UnswizFunc;
+    plan->GetBlockAddressFunc = context->GetBlockAddressFunc;
+    plan->GetBlockPositionFunc = context->GetBlockPositionFunc;
+    plan->InitRectTileContextFunc = context->InitRectTileContextFunc;
+
+    plan->mip_count = 1;
+    if (context->has_mips)
+        plan->mip_count = count_mips(context->width, context->height);
+
+    MipContext mc = { 0 };
+    mc.block_width = context->block_width;
+    mc.block_height = context->block_height;
+    mc.block_data_size = context->block_data_size;
+    mc.gobs_height = context->gobs_height;
+    mc.kernel_variant = swizResolveKernelVariant(context->kernel_variant);
+
+    // Swizzling blocks are not the same as compression blocks on some platforms.
+    // So, we need to update block info here.
+    MipContext swizzle_mc = mc;
+    context->GetSwizzleBlockSizeFunc(&swizzle_mc);
+
+    int width = context->width;
+    int height = context->height;
+    uint64_t data_offset = 0;
+    uint64_t swizzled_offset = 0;
+    plan->slice_task_count = 0;
+    for (int i = 0; i < plan->mip_count; i++) {
+        MipPlan *mip = &plan->mips[i];
+        mc.width = width;
+        mc.height = height;
+
+        // Swizzling functions handle padding by themselves.
+        // So, they need the unpadded size and the pitch of unswizzled data.
+        mip->context = swizzle_mc;
+        mip->context.width = width;
+        mip->context.height = height;
+        mip->context.pitch = CEIL_DIV(width, mc.block_width) * mc.block_data_size;
+
+        // some platforms requires padding. so, we need to resize mipmaps here.
+        MipContext padded_mc = mip->context;
+        context->GetPaddedSizeFunc(&padded_mc);
+
+        mip->data_offset = data_offset;
+        mip->data_size = get_mip_data_size(&mc);
+        mip->swizzled_offset = swizzled_offset;
+        mip->swizzled_size = get_mip_data_size(&padded_mc);
+
+        // Stripes are rows of tiles. Each stripe can be swizzled independently.
+        context->GetStripeHeightFunc(&mip->context);
+        int stripe_height = mip->context.stripe_height;
+        mip->stripe_count = CEIL_DIV(CEIL_DIV(height, mip->context.block_height), stripe_height);
+        mip->stripe_data_size = (uint64_t)stripe_height * mip->context.pitch;
+        mip->stripe_swizzled_size = 0;
+        mip->task_count = 0;
+        if (mip->stripe_count > 0) {
+            mip->stripe_swizzled_size = mip->swizzled_size / mip->stripe_count;
+            mip->task_count = MIN(mip->stripe_count,
+                                  MAX(1, (int)(mip->swizzled_size / TASK_SWIZZLED_SIZE)));
+        }
+        plan->slice_task_count += mip->task_count;
+
+        data_offset += mip->data_size;
+        swizzled_offset += mip->swizzled_size;
+
+        width = MAX(1, width / 2);
+        height = MAX(1, height / 2);
+    }
+    plan->slice_data_size = data_offset;
+    plan->slice_swizzled_size = swizzled_offset;
+    return SWIZ_OK;
+}
+
+SwizPlan *swizNewPlan(SwizContext *context) {
+    SwizPlan *plan = (SwizPlan *)malloc(sizeof(SwizPlan));
+    if (plan == NULL) {
+        context->error = SWIZ_ERROR_MEMORY_ALLOC;
+        return NULL;
+    }
+    if (swizPlanInit(plan, context) != SWIZ_OK) {
+        free(plan);
+        return NULL;
+    }
+    return plan;
+}
+
+void swizFreePlan(SwizPlan *plan) {
+    free(plan);
+}
+
+uint64_t swizPlanGetSwizzledSize64(const SwizPlan *plan) {
+    return plan->slice_swizzled_size * plan->array_size;
+}
+
+uint64_t swizPlanGetUnswizzledSize64(const SwizPlan *plan) {
+    return plan->slice_data_size * plan->array_size;
+}
+
+uint32_t swizPlanGetSwizzledSize(const SwizPlan *plan) {
+    uint64_t size = swizPlanGetSwizzledSize64(plan);
+    return size > UINT32_MAX ? 0 : (uint32_t)size;
+}
+
+uint32_t swizPlanGetUnswizzledSize(const SwizPlan *plan) {
+    uint64_t size = swizPlanGetUnswizzledSize64(plan);
+    return size > UINT32_MAX ? 0 : (uint32_t)size;
+}
+
+static int get_task_count(const SwizPlan *plan) {
+    return plan->array_size * plan->slice_task_count;
+}
+
+// Swizzles a range of stripes in a mipmap. Each task writes to a separate range of dst.
+// src and dst should point to the mipmap.
+static void run_mip_task(const SwizPlan *plan, const MipPlan *mip,
+                         const uint8_t *src, uint8_t *dst, int swizzle, int task_index) {
+    // Split stripes evenly.
+    int stripe_begin = task_index * mip->stripe_count / mip->task_count;
+    int stripe_end = (task_index + 1) * mip->stripe_count / mip->task_count;
+    uint64_t data_offset = stripe_begin * mip->stripe_data_size;
+    uint64_t swizzled_offset = stripe_begin * mip->stripe_swizzled_size;
+
+    // Do swizzling for stripes
+    if (swizzle) {
+        plan->SwizFunc(src + data_offset, dst + swizzled_offset, &mip->context,
+                       stripe_begin, stripe_end - stripe_begin);
+    } else {
+        plan->UnswizFunc(src + swizzled_offset, dst + data_offset, &mip->context,
+                         stripe_begin, stripe_end - stripe_begin);
+    }
+}
+
+static void run_plan_task(const SwizPlan *plan, const uint8_t *src, uint8_t *dst,
+                          int swizzle, int task_index) {
+    int slice = task_index / plan->slice_task_count;
+    int mip_task_index = task_index % plan->slice_task_count;
+
+    // Find the mipmap of the task.
+    const MipPlan *mip = &plan->mips[0];
+    while (mip_task_index >= mip->task_count) {
+        mip_task_index -= mip->task_count;
+        mip++;
+    }
+
+    uint64_t data_offset = slice * plan->slice_data_size + mip->data_offset;
+    uint64_t swizzled_offset = slice * plan->slice_swizzled_size + mip->swizzled_offset;
+    if (swizzle)
+        run_mip_task(plan, mip, src + data_offset, dst + swizzled_offset, 1, mip_task_index);
+    else
+        run_mip_task(plan, mip, src + swizzled_offset, dst + data_offset, 0, mip_task_index);
+}
+
+typedef struct SwizzleTaskArg SwizzleTaskArg;
+struct SwizzleTaskArg {
+    const uint8_t *src;
+    uint8_t *dst;
+    const SwizPlan *plan;
+    int swizzle;
+};
+
+static void swizzle_task(void *arg, int task_index) {
+    SwizzleTaskArg *task = (SwizzleTaskArg *)arg;
+    run_plan_task(task->plan, task->src, task->dst, task->swizzle, task_index);
+}
+
+SwizError swizPlanDoSwizzleBase(const uint8_t *src, uint8_t *dst,
+                                const SwizPlan *plan, int swizzle, SwizThreadPool *pool) {
+    if (src == NULL || dst == NULL)
+        return SWIZ_ERROR_NULL_POINTER;
+
+    SwizzleTaskArg task;
+    task.src = src;
+    task.dst = dst;
+    task.plan = plan;
+    task.swizzle = swizzle;
+    swizThreadPoolRun(pool, get_task_count(plan), swizzle_task, &task);
+    return SWIZ_OK;
+}
+
+typedef struct MipTaskArg MipTaskArg;
+struct MipTaskArg {
+    const uint8_t *src;
+    uint8_t *dst;
+    const SwizPlan *plan;
+    const MipPlan *mip;
+    int swizzle;
+};
+
+static void mip_task(void *arg, int task_index) {
+    MipTaskArg *task = (MipTaskArg *)arg;
+    const SwizPlan *plan = task->plan;
+    const MipPlan *mip = task->mip;
+    int slice = task_index / mip->task_count;
+    uint64_t data_offset = slice * plan->slice_data_size + mip->data_offset;
+    uint64_t swizzled_offset = slice * plan->slice_swizzled_size + mip->swizzled_offset;
+    if (task->swizzle) {
+        run_mip_task(plan, mip, task->src + data_offset, task->dst + swizzled_offset, 1,
+                     task_index % mip->task_count);
+    } else {
+        run_mip_task(plan, mip, task->src + swizzled_offset, task->dst + data_offset, 0,
+                     task_index % mip->task_count);
+    }
+}
+
+void swizPlanDoSwizzleMipBase(const uint8_t *src, uint8_t *dst, const SwizPlan *plan,
+                              int mip, int swizzle, SwizThreadPool *pool) {
+    MipTaskArg task;
+    task.src = src;
+    task.dst = dst;
+    task.plan = plan;
+    task.mip = &plan->mips[mip];
+    task.swizzle = swizzle;
+    swizThreadPoolRun(pool, plan->array_size * task.mip->task_count, mip_task, &task);
+}
+
+SwizError swizPlanDoSwizzle(const uint8_t *data, uint8_t *swizzled, const SwizPlan *plan) {
+    return swizPlanDoSwizzleBase(data, swizzled, plan, 1, NULL);
+}
+
+SwizError swizPlanDoUnswizzle(const uint8_t *data, uint8_t *unswizzled, const SwizPlan *plan) {
+    return swizPlanDoSwizzleBase(data, unswizzled, plan, 0, NULL);
+}
+
+int swizPlanGetMipCount(const SwizPlan *plan) {
+    return plan->mip_count;
+}
+
+SwizError swizPlanGetSubresourceInfo(const SwizPlan *plan, int mip, int slice,
+                                     SwizSubresourceInfo *info) {
+    if (info == NULL)
+        return SWIZ_ERROR_NULL_POINTER;
+
+    if (mip < 0 || mip >= plan->mip_count || slice < 0 || slice >= plan->array_size)
+        return SWIZ_ERROR_OUT_OF_RANGE;
+
+    const MipPlan *mip_plan = &plan->mips[mip];
+    info->width = mip_plan->context.width;
+    info->height = mip_plan->context.height;
+    info->data_offset = slice * plan->slice_data_size + mip_plan->data_offset;
+    info->data_size = mip_plan->data_size;
+    info->swizzled_offset = slice * plan->slice_swizzled_size + mip_plan->swizzled_offset;
+    info->swizzled_size = mip_plan->swizzled_size;
+    return SWIZ_OK;
+}
+
+typedef struct SubresourceTaskArg SubresourceTaskArg;
+struct SubresourceTaskArg {
+    const uint8_t *src;
+    uint8_t *dst;
+    const SwizPlan *plan;
+    const MipPlan *mip;
+    int swizzle;
+};
+
+static void subresource_task(void *arg, int task_index) {
+    SubresourceTaskArg *task = (SubresourceTaskArg *)arg;
+    run_mip_task(task->plan, task->mip, task->src, task->dst, task->swizzle, task_index);
+}
+
+SwizError swizPlanDoSwizzleSubresourceBase(const uint8_t *src, uint8_t *dst,
+                                           const SwizPlan *plan, int mip, int slice,
+                                           int swizzle, SwizThreadPool *pool) {
+    if (src == NULL || dst == NULL)
+        return SWIZ_ERROR_NULL_POINTER;
+
+    if (mip < 0 || mip >= plan->mip_count || slice < 0 || slice >= plan->array_size)
+        return SWIZ_ERROR_OUT_OF_RANGE;
+
+    // Slices have the same layout. So, we only need the mipmap.
+    SubresourceTaskArg task;
+    task.src = src;
+    task.dst = dst;
+    task.plan = plan;
+    task.mip = &plan->mips[mip];
+    task.swizzle = swizzle;
+    swizThreadPoolRun(pool, task.mip->task_count, subresource_task, &task);
+    return SWIZ_OK;
+}
+
+SwizError swizPlanDoSwizzleSubresource(const uint8_t *data, uint8_t *swizzled,
+                                       int mip, int slice, const SwizPlan *plan) {
+    return swizPlanDoSwizzleSubresourceBase(data, swizzled, plan, mip, slice, 1, NULL);
+}
+
+SwizError swizPlanDoUnswizzleSubresource(const uint8_t *data, uint8_t *unswizzled,
+                                         int mip, int slice, const SwizPlan *plan) {
+    return swizPlanDoSwizzleSubresourceBase(data, unswizzled, plan, mip, slice, 0, NULL);
+}
+
+// batch functions
+
+typedef struct BatchEntry BatchEntry;
+struct BatchEntry {
+    uint64_t size;  // Swizzled size of the job
+    int job_index;
+    int task_offset;  // Index of the first task of the job
+};
+
+size_t swizGetBatchWorkspaceSize(int job_count) {
+    if (job_count <= 0)
+        return 0;
+    return sizeof(BatchEntry) * job_count;
+}
+
+// Sorts jobs in descending order of size.
+static int compare_batch_entries(const void *a, const void *b) {
+    const BatchEntry *entry_a = (const BatchEntry *)a;
+    const BatchEntry *entry_b = (const BatchEntry *)b;
+    if (entry_a->size != entry_b->size)
+        return entry_a->size > entry_b->size ? -1 : 1;
+    return entry_a->job_index - entry_b->job_index;
+}
+
+typedef struct BatchTaskArg BatchTaskArg;
+struct BatchTaskArg {
+    const SwizJob *jobs;
+    const BatchEntry *entries;
+    int entry_count;
+    int swizzle;
+};
+
+static void batch_task(void *arg, int task_index) {
+    BatchTaskArg *batch = (BatchTaskArg *)arg;
+
+    // Find the last job that starts at or before the task.
+    int lo = 0;
+    int hi = batch->entry_count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (batch->entries[mid].task_offset <= task_index)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+
+    const BatchEntry *entry = &batch->entries[lo];
+    const SwizJob *job = &batch->jobs[entry->job_index];
+    run_plan_task(job->plan, job->src, job->dst, batch->swizzle,
+                  task_index - entry->task_offset);
+}
+
+SwizError swizPlanDoSwizzleBatch(SwizJob *jobs, int job_count, int swizzle,
+                                 SwizThreadPool *pool, void *workspace) {
+    BatchEntry *entries = (BatchEntry *)workspace;
+    int entry_count = 0;
+    SwizError error = SWIZ_OK;
+    for (int i = 0; i < job_count; i++) {
+        SwizJob *job = &jobs[i];
+        if (job->plan == NULL || job->src == NULL || job->dst == NULL) {
+            job->error = SWIZ_ERROR_NULL_POINTER;
+            if (error == SWIZ_OK)
+                error = job->error;
+            continue;
+        }
+        job->error = SWIZ_OK;
+        if (get_task_count(job->plan) == 0)
+            continue;
+        entries[entry_count].size = swizPlanGetSwizzledSize64(job->plan);
+        entries[entry_count].job_index = i;
+        entry_count++;
+    }
+
+    // Large jobs go first, and small jobs fill the gaps at the end.
+    qsort(entries, entry_count, sizeof(BatchEntry), compare_batch_entries);
+    int task_count = 0;
+    for (int i = 0; i < entry_count; i++) {
+        entries[i].task_offset = task_count;
+        task_count += get_task_count(jobs[entries[i].job_index].plan);
+    }
+
+    // All jobs share the same task queue. So, idle threads take tasks of any job.
+    BatchTaskArg batch;
+    batch.jobs = jobs;
+    batch.entries = entries;
+    batch.entry_count = entry_count;
+    batch.swizzle = swizzle;
+    swizThreadPoolRun(pool, task_count, batch_task, &batch);
+    return error;
+}
@@ -16,41 +16,152 @@ struct MipContext {
     int block_height;
     int block_data_size;
     int gobs_height;
+    int pitch;  // data size of a row of blocks in unswizzled data
+    int stripe_height;  // The number of block rows in a stripe that can be swizzled independently
+    SwizKernelVariant kernel_variant;  // Instruction set for swizzling. It should not be AUTO.
 };
 
 // swizfunc.c
 
+typedef struct TileContext TileContext;
+
+// Copies all blocks of a tile (8x8 blocks for PS4, or a GOB for Switch).
+// data_index is the position of the tile in unswizzled data.
+// dest_index is the position of the tile in swizzled data.
+// The tile should be in the unswizzled texture.
+typedef void (*CopyTileFuncPtr)(const uint8_t *data, size_t data_index,
+                                uint8_t *dest, size_t dest_index, const TileContext *tc);
+
+#define MAX_TILE_BLOCK_COUNT 64
+
+// Info to swizzle tiles of a mipmap. It will be initialized once per mipmap.
+struct TileContext {
+    const int *order;  // Swizzling order of blocks in a tile
+    int tile_width;  // The number of blocks in a row of a tile
+    int tile_height;  // The number of blocks in a column of a tile
+    int block_count;  // The number of blocks in a tile
+    int block_data_size;
+    int pitch;
+    int full_block_count_x;  // The number of blocks that are fully in a row of the texture
+    int block_count_y;
+    int offsets[MAX_TILE_BLOCK_COUNT];  // Positions of swizzled blocks in unswizzled data
+    CopyTileFuncPtr copy_tile_func;
+    int swizzle;  // Non-zero to swizzle, or zero to unswizzle blocks of tiles with padding
+#ifdef SWIZ_DEBUG
+    size_t max_data_index;
+    size_t max_dest_index;
+#endif
+};
+
 void getSwizzleBlockSizeDefault(MipContext *context);
 
 void getPaddedSizeDefault(MipContext *context);
 
 void getPaddedSizePS4(MipContext *context);
 
+void getStripeHeightPS4(MipContext *context);
+
+uint64_t getBlockAddressPS4(const MipContext *context, int x, int y);
+
+void getBlockPositionPS4(const MipContext *context, uint64_t block_index, int *x, int *y);
+
+void initRectTileContextPS4(TileContext *tc, const MipContext *context, int pitch, int swizzle);
+
 void swizFuncPS4(const uint8_t *data, uint8_t *new_data,
-                 const MipContext *context);
+                 const MipContext *context, int stripe_begin, int stripe_count);
 
 void unswizFuncPS4(const uint8_t *data, uint8_t *new_data,
-                   const MipContext *context);
+                   const MipContext *context, int stripe_begin, int stripe_count);
 
 void getSwizzleBlockSizeSwitch(MipContext *context);
 
 void getPaddedSizeSwitch(MipContext *context);
 
+void getStripeHeightSwitch(MipContext *context);
+
+uint64_t getBlockAddressSwitch(const MipContext *context, int x, int y);
+
+void getBlockPositionSwitch(const MipContext *context, uint64_t block_index, int *x, int *y);
+
+void initRectTileContextSwitch(TileContext *tc, const MipContext *context,
+                               int pitch, int swizzle);
+
 void swizFuncSwitch(const uint8_t *data, uint8_t *new_data,
-                    const MipContext *context);
+                    const MipContext *context, int stripe_begin, int stripe_count);
 
 void unswizFuncSwitch(const uint8_t *data, uint8_t *new_data,
-                      const MipContext *context);
+                      const MipContext *context, int stripe_begin, int stripe_count);
+
+// swizfunc_simd.c
+
+// Gets a SIMD function to copy 8x8 blocks for PS4.
+// Returns NULL when SIMD functions don't support the block size or the variant.
+CopyTileFuncPtr getCopyTileFuncPS4SIMD(int block_data_size, int swizzle,
+                                       SwizKernelVariant variant);
+
+// Gets a SIMD function to copy a GOB for Switch.
+// Returns NULL when SIMD functions don't support the block size or the variant.
+CopyTileFuncPtr getCopyTileFuncSwitchSIMD(int block_data_size, int swizzle,
+                                          SwizKernelVariant variant);
+
+// Gets the fastest variant that the CPU supports.
+SwizKernelVariant swizGetBestKernelVariant();
+
+// Converts SWIZ_KERNEL_AUTO to an actual variant.
+// It uses the SWIZ_KERNEL_VARIANT environment variable when the variant is AUTO.
+// Variants that the CPU does not support fall back to the best one.
+SwizKernelVariant swizResolveKernelVariant(SwizKernelVariant variant);
+
+// thread.c
+
+typedef struct SwizThreadPool SwizThreadPool;
+
+// A function to run a task. task_index is in [0, task_count).
+typedef void (*SwizTaskFuncPtr)(void *arg, int task_index);
+
+// Gets the number of logical processors.
+int swizGetCPUCount();
+
+// Creates a pool with (thread_count - 1) worker threads.
+// The caller of swizThreadPoolRun() will be the last thread.
+SwizThreadPool *swizNewThreadPool(int thread_count);
+
+void swizFreeThreadPool(SwizThreadPool *pool);
+
+// Gets thread_count of swizNewThreadPool().
+// The pool can use fewer threads when the system could not create some of them.
+int swizThreadPoolGetThreadCount(const SwizThreadPool *pool);
+
+// Runs tasks on the pool and waits for them. It runs tasks on the caller if pool is NULL.
+void swizThreadPoolRun(SwizThreadPool *pool, int task_count,
+                       SwizTaskFuncPtr func, void *arg);
 
 // context.c
 
+// Swizzles (or unswizzles) stripes in [stripe_begin, stripe_begin + stripe_count) of a mipmap.
+// data and new_data should point to the first stripe.
 typedef void (*SwizFuncPtr)(const uint8_t *data, uint8_t *new_data,
-                            const MipContext *context);
+                            const MipContext *context, int stripe_begin, int stripe_count);
 
 typedef void (*GetSwizzleBlockSizeFuncPtr)(MipContext *context);
 
 typedef void (*GetPaddedSizeFuncPtr)(MipContext *context);
 
+typedef void (*GetStripeHeightFuncPtr)(MipContext *context);
+
+// Gets the offset of a swizzling block at (x, y) in a swizzled mipmap.
+// context should be the unpadded size of the mipmap.
+typedef uint64_t (*GetBlockAddressFuncPtr)(const MipContext *context, int x, int y);
+
+// Gets the position of the block_index-th swizzling block in a swizzled mipmap.
+typedef void (*GetBlockPositionFuncPtr)(const MipContext *context, uint64_t block_index,
+                                        int *x, int *y);
+
+// Initializes a tile context to copy whole tiles of a rectangle with copy_tile_func.
+// pitch is the size of a row of blocks in the rectangle.
+typedef void (*InitRectTileContextFuncPtr)(TileContext *tc, const MipContext *context,
+                                           int pitch, int swizzle);
+
 struct SwizContext {
     SwizPlatform platform;
     int width;
@@ -65,9 +176,123 @@ struct SwizContext {
     SwizFuncPtr UnswizFunc;
     GetSwizzleBlockSizeFuncPtr GetSwizzleBlockSizeFunc;
     GetPaddedSizeFuncPtr GetPaddedSizeFunc;
+    GetStripeHeightFuncPtr GetStripeHeightFunc;
+    GetBlockAddressFuncPtr GetBlockAddressFunc;
+    GetBlockPositionFuncPtr GetBlockPositionFunc;
+    InitRectTileContextFuncPtr InitRectTileContextFunc;
     SwizError error;
+    uint8_t *workspace;
+    size_t workspace_size;
+    int owns_workspace;  // Non-zero if the context allocated the workspace.
+    int thread_count;
+    SwizThreadPool *thread_pool;
+    SwizKernelVariant kernel_variant;
+    SwizPlan *plan;  // Cached layout of the context
+    int plan_is_dirty;  // Non-zero if the plan should be rebuilt
+    SwizStats *stats;  // NULL if statistics are disabled
+};
+
+// Gets a thread pool for swizContextSetThreadCount(). Returns NULL for single-threaded contexts.
+SwizThreadPool *swizContextGetThreadPool(SwizContext *context);
+
+SwizError swizContextValidate(SwizContext *context);
+
+// Gets the layout of the context. The plan will be rebuilt only when the context has changed.
+// Returns NULL and sets context->error when the context is invalid.
+const SwizPlan *swizContextGetPlan(SwizContext *context);
+
+// Gets a scratch buffer of the workspace. It allocates more memory if needed.
+// Returns NULL and sets context->error when the workspace is too small to use.
+uint8_t *swizContextReserveWorkspace(SwizContext *context, size_t size);
+
+// plan.c
+
+typedef struct MipPlan MipPlan;
+struct MipPlan {
+    MipContext context;  // Block info for swizzling and the unpadded size of a mipmap
+    uint64_t data_offset;  // Offset of unswizzled data in a slice
+    uint64_t data_size;  // Size of unswizzled data
+    uint64_t swizzled_offset;  // Offset of swizzled data in a slice
+    uint64_t swizzled_size;  // Size of swizzled data including padding
+    int stripe_count;
+    uint64_t stripe_data_size;  // Size of unswizzled data in a stripe
+    uint64_t stripe_swizzled_size;  // Size of swizzled data in a stripe
+    int task_count;  // The number of tasks that a mipmap is split into
+};
+
+struct SwizPlan {
+    SwizPlatform platform;
+    int block_width;  // Block info for compression
+    int block_height;
+    int block_data_size;
+    int array_size;
+    int mip_count;
+    SwizFuncPtr SwizFunc;
+    SwizFuncPtr UnswizFunc;
+    GetBlockAddressFuncPtr GetBlockAddressFunc;
+    GetBlockPositionFuncPtr GetBlockPositionFunc;
+    InitRectTileContextFuncPtr InitRectTileContextFunc;
+    uint64_t slice_data_size;
+    uint64_t slice_swizzled_size;
+    int slice_task_count;  // The number of tasks in a slice
+    MipPlan mips[SWIZ_MAX_MIP_COUNT];
 };
 
+// Validates a context and initializes a plan with it.
+SwizError swizPlanInit(SwizPlan *plan, SwizContext *context);
+
+// Swizzles or unswizzles a mipmap of a slice.
+// src and dst should point to the subresource, not to the whole texture.
+SwizError swizPlanDoSwizzleSubresourceBase(const uint8_t *src, uint8_t *dst,
+                                           const SwizPlan *plan, int mip, int slice,
+                                           int swizzle, SwizThreadPool *pool);
+
+// Swizzles or unswizzles data with a plan. This function does not modify the plan.
+// Mipmaps will be split into stripes and processed on the thread pool when pool is not NULL.
+SwizError swizPlanDoSwizzleBase(const uint8_t *src, uint8_t *dst,
+                                const SwizPlan *plan, int swizzle, SwizThreadPool *pool);
+
+// Swizzles or unswizzles textures of jobs. Jobs are split into tasks and processed on the pool.
+// workspace should have swizGetBatchWorkspaceSize(job_count) bytes.
+// Returns the first error of jobs.
+SwizError swizPlanDoSwizzleBatch(SwizJob *jobs, int job_count, int swizzle,
+                                 SwizThreadPool *pool, void *workspace);
+
+// Swizzles or unswizzles a mipmap of all slices.
+// src and dst should point to the whole texture.
+void swizPlanDoSwizzleMipBase(const uint8_t *src, uint8_t *dst, const SwizPlan *plan,
+                              int mip, int swizzle, SwizThreadPool *pool);
+
+// rect.c
+
+// Swizzles or unswizzles a rectangle of a mipmap with a plan.
+SwizError swizPlanDoSwizzleRectBase(const uint8_t *src, uint8_t *dst, const SwizRect *rect,
+                                    const SwizPlan *plan, int swizzle);
+
+// chunk.c
+
+// Swizzles or unswizzles a chunk with a plan.
+// src and dst should point to the chunk, not to the whole texture.
+SwizError swizPlanDoSwizzleChunkBase(const uint8_t *src, uint8_t *dst, const SwizChunk *chunk,
+                                     const SwizPlan *plan, int swizzle, SwizThreadPool *pool);
+
+// stats.c
+
+// Gets a monotonic time in nanoseconds.
+uint64_t swizGetTimeNs();
+
+// Counts a call that swizzled or unswizzled data with a plan.
+void swizStatsAddCall(SwizStats *stats, const SwizPlan *plan);
+
+// Adds sizes and time of a range of a mipmap to statistics.
+// data_size and swizzled_size are sizes of the range.
+void swizStatsAddMip(SwizStats *stats, int mip, uint64_t data_size, uint64_t swizzled_size,
+                     int swizzle, uint64_t ns);
+
+// Swizzles or unswizzles data like swizPlanDoSwizzleBase(), and measures each mipmap.
+SwizError swizPlanDoSwizzleWithStats(const uint8_t *src, uint8_t *dst, const SwizPlan *plan,
+                                     int swizzle, SwizThreadPool *pool, SwizStats *stats);
+
 #ifdef __cplusplus
 }
 #endif
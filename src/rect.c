@@ -0,0 +1,125 @@
+#include <string.h>
+#include "console-swizzler.h"
+#include "priv.h"
+
+#define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
+#define MAX(X, Y) (((X) > (Y)) ? (X) : (Y))
+#define CEIL_DIV(X, PAD) (((X) + (PAD) - 1) / (PAD))
+
+// Checks if a rectangle is aligned to blocks and in the mipmap.
+// The right and bottom edges can be unaligned when they are the edges of the mipmap.
+static int is_valid_rect(const SwizRect *rect, const SwizPlan *plan) {
+    if (rect->mip < 0 || rect->mip >= plan->mip_count ||
+        rect->slice < 0 || rect->slice >= plan->array_size)
+        return 0;
+
+    const MipContext *context = &plan->mips[rect->mip].context;
+    if (rect->x < 0 || rect->y < 0 || rect->width < 0 || rect->height < 0 ||
+        rect->x > context->width - rect->width || rect->y > context->height - rect->height)
+        return 0;
+
+    int right = rect->x + rect->width;
+    int bottom = rect->y + rect->height;
+    return rect->x % plan->block_width == 0 && rect->y % plan->block_height == 0 &&
+           (right % plan->block_width == 0 || right == context->width) &&
+           (bottom % plan->block_height == 0 || bottom == context->height);
+}
+
+// Info to copy a rectangle of a mipmap.
+typedef struct RectCopy {
+    const uint8_t *src;
+    uint8_t *dst;
+    const SwizPlan *plan;
+    const MipContext *context;
+    uint64_t mip_offset;  // Offset of the mipmap in swizzled data
+    int row_begin;  // Byte range of the rectangle in a row of unswizzled blocks
+    int row_end;
+    int rect_pitch;
+    int block_y;  // Range of block rows of the rectangle
+    int block_y_end;
+    int swizzle;
+} RectCopy;
+
+// Copies the part of a tile that is in the rectangle.
+// x_begin, x_end, y_begin, and y_end are the range of the tile.
+static void copy_partial_tile(const RectCopy *rc, int x_begin, int x_end,
+                              int y_begin, int y_end) {
+    int swizzle_block_data_size = rc->context->block_data_size;
+    x_begin = MAX(x_begin, rc->row_begin);
+    x_end = MIN(x_end, rc->row_end);
+    for (int y = MAX(y_begin, rc->block_y); y < MIN(y_end, rc->block_y_end); y++) {
+        size_t rect_index = (size_t)(y - rc->block_y) * rc->rect_pitch + x_begin - rc->row_begin;
+        int data_x = x_begin;
+        while (data_x < x_end) {
+            // A swizzling block can contain multiple blocks on Switch.
+            // So, we copy the part of the block that is in the rectangle.
+            int offset = data_x % swizzle_block_data_size;
+            int copy_size = MIN(swizzle_block_data_size - offset, x_end - data_x);
+            uint64_t swizzled_index = rc->mip_offset + offset +
+                rc->plan->GetBlockAddressFunc(rc->context, data_x / swizzle_block_data_size, y);
+            if (rc->swizzle)
+                memcpy(rc->dst + swizzled_index, rc->src + rect_index, copy_size);
+            else
+                memcpy(rc->dst + rect_index, rc->src + swizzled_index, copy_size);
+            data_x += copy_size;
+            rect_index += copy_size;
+        }
+    }
+}
+
+SwizError swizPlanDoSwizzleRectBase(const uint8_t *src, uint8_t *dst, const SwizRect *rect,
+                                    const SwizPlan *plan, int swizzle) {
+    if (src == NULL || dst == NULL || rect == NULL)
+        return SWIZ_ERROR_NULL_POINTER;
+
+    if (!is_valid_rect(rect, plan))
+        return SWIZ_ERROR_INVALID_RECT;
+
+    const MipPlan *mip = &plan->mips[rect->mip];
+    RectCopy rc;
+    rc.src = src;
+    rc.dst = dst;
+    rc.plan = plan;
+    rc.context = &mip->context;
+    rc.mip_offset = rect->slice * plan->slice_swizzled_size + mip->swizzled_offset;
+    rc.row_begin = rect->x / plan->block_width * plan->block_data_size;
+    rc.rect_pitch = CEIL_DIV(rect->width, plan->block_width) * plan->block_data_size;
+    rc.row_end = rc.row_begin + rc.rect_pitch;
+    rc.block_y = rect->y / plan->block_height;
+    rc.block_y_end = rc.block_y + CEIL_DIV(rect->height, plan->block_height);
+    rc.swizzle = swizzle;
+
+    // Tiles in the rectangle are copied with the same kernels as whole mipmaps.
+    // Only tiles on the edges of the rectangle are copied block by block.
+    TileContext tc;
+    plan->InitRectTileContextFunc(&tc, rc.context, rc.rect_pitch, swizzle);
+    int tile_pitch = tc.tile_width * tc.block_data_size;  // Data size of a row of a tile
+    int first_tile_x = rc.row_begin / tile_pitch * tile_pitch;
+    int first_tile_y = rc.block_y / tc.tile_height * tc.tile_height;
+    for (int y = first_tile_y; y < rc.block_y_end; y += tc.tile_height) {
+        int y_end = y + tc.tile_height;
+        for (int x = first_tile_x; x < rc.row_end; x += tile_pitch) {
+            int x_end = x + tile_pitch;
+            if (x < rc.row_begin || x_end > rc.row_end ||
+                y < rc.block_y || y_end > rc.block_y_end) {
+                copy_partial_tile(&rc, x, x_end, y, y_end);
+                continue;
+            }
+            size_t rect_index = (size_t)(y - rc.block_y) * rc.rect_pitch + x - rc.row_begin;
+            uint64_t swizzled_index = rc.mip_offset +
+                plan->GetBlockAddressFunc(rc.context, x / tc.block_data_size, y);
+            tc.copy_tile_func(src, rect_index, dst, swizzled_index, &tc);
+        }
+    }
+    return SWIZ_OK;
+}
+
+SwizError swizPlanDoSwizzleRect(const uint8_t *data, uint8_t *swizzled,
+                                const SwizRect *rect, const SwizPlan *plan) {
+    return swizPlanDoSwizzleRectBase(data, swizzled, rect, plan, 1);
+}
+
+SwizError swizPlanDoUnswizzleRect(const uint8_t *data, uint8_t *unswizzled,
+                                  const SwizRect *rect, const SwizPlan *plan) {
+    return swizPlanDoSwizzleRectBase(data, unswizzled, rect, plan, 0);
+}
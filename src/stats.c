@@ -0,0 +1,73 @@
+// clock_gettime is not in C99.
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "console-swizzler.h"
+#include "priv.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+uint64_t swizGetTimeNs() {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    // Split the division to avoid overflow of counter * 1e9.
+    uint64_t seconds = counter.QuadPart / frequency.QuadPart;
+    uint64_t remainder = counter.QuadPart % frequency.QuadPart;
+    return seconds * 1000000000 + remainder * 1000000000 / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void swizStatsAddCall(SwizStats *stats, const SwizPlan *plan) {
+    stats->call_count++;
+    stats->kernel_variant = plan->mips[0].context.kernel_variant;
+}
+
+void swizStatsAddMip(SwizStats *stats, int mip, uint64_t data_size, uint64_t swizzled_size,
+                     int swizzle, uint64_t ns) {
+    SwizMipStats *mip_stats = &stats->mips[mip];
+    uint64_t bytes_read = swizzle ? data_size : swizzled_size;
+    uint64_t bytes_written = swizzle ? swizzled_size : data_size;
+    // Unswizzling skips padding. So, it only produces padding when swizzling.
+    uint64_t padding_bytes = 0;
+    if (swizzle && swizzled_size > data_size)
+        padding_bytes = swizzled_size - data_size;
+
+    mip_stats->bytes_read += bytes_read;
+    mip_stats->bytes_written += bytes_written;
+    mip_stats->padding_bytes += padding_bytes;
+    mip_stats->kernel_ns += ns;
+    stats->bytes_read += bytes_read;
+    stats->bytes_written += bytes_written;
+    stats->padding_bytes += padding_bytes;
+    stats->kernel_ns += ns;
+    if (mip >= stats->mip_count)
+        stats->mip_count = mip + 1;
+}
+
+SwizError swizPlanDoSwizzleWithStats(const uint8_t *src, uint8_t *dst, const SwizPlan *plan,
+                                     int swizzle, SwizThreadPool *pool, SwizStats *stats) {
+    if (src == NULL || dst == NULL)
+        return SWIZ_ERROR_NULL_POINTER;
+
+    // Mipmaps run one by one, so that each of them gets its own time.
+    swizStatsAddCall(stats, plan);
+    for (int i = 0; i < plan->mip_count; i++) {
+        const MipPlan *mip = &plan->mips[i];
+        uint64_t start = swizGetTimeNs();
+        swizPlanDoSwizzleMipBase(src, dst, plan, i, swizzle, pool);
+        swizStatsAddMip(stats, i, mip->data_size * plan->array_size,
+                        mip->swizzled_size * plan->array_size, swizzle,
+                        swizGetTimeNs() - start);
+    }
+    return SWIZ_OK;
+}
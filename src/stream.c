@@ -0,0 +1,170 @@
+#include <string.h>
+#include "console-swizzler.h"
+#include "priv.h"
+
+#define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
+#define MAX(X, Y) (((X) > (Y)) ? (X) : (Y))
+#define CEIL_DIV(X, PAD) (((X) + (PAD) - 1) / (PAD))
+
+struct SwizStream {
+    SwizPlan plan;
+    SwizStreamWriteFuncPtr write_func;
+    void *user_data;
+    uint8_t *stripe_data;  // Unswizzled rows of the current stripe. The stream owns it.
+    uint8_t *stripe_swizzled;  // Swizzled data of the current stripe. It's in stripe_data.
+    int slice;  // The current slice. It's array_size when all rows are pushed.
+    int mip;
+    int stripe;
+    int row;  // The number of rows that the current stripe has
+    SwizError error;
+};
+
+static size_t get_max_stripe_data_size(const SwizPlan *plan) {
+    size_t size = 0;
+    for (int i = 0; i < plan->mip_count; i++)
+        size = MAX(size, plan->mips[i].stripe_data_size);
+    return size;
+}
+
+// Gets the size of buffers for a stripe of unswizzled data and a stripe of swizzled data.
+static size_t get_stripe_buffer_size(const SwizPlan *plan) {
+    // A buffer for unswizzled rows and a buffer for swizzled data
+    size_t size = 0;
+    for (int i = 0; i < plan->mip_count; i++)
+        size = MAX(size, plan->mips[i].stripe_swizzled_size);
+    return get_max_stripe_data_size(plan) + size;
+}
+
+static int get_stripe_row_count(const MipPlan *mip, int stripe) {
+    const MipContext *context = &mip->context;
+    int row_count = CEIL_DIV(context->height, context->block_height);
+    return MIN(context->stripe_height, row_count - stripe * context->stripe_height);
+}
+
+// Moves to the next mipmap that has rows.
+static void skip_empty_mips(SwizStream *stream) {
+    while (stream->slice < stream->plan.array_size &&
+           stream->plan.mips[stream->mip].stripe_count == 0) {
+        stream->mip++;
+        if (stream->mip == stream->plan.mip_count) {
+            stream->mip = 0;
+            stream->slice++;
+        }
+    }
+}
+
+// Swizzles the current stripe and moves to the next one.
+static void flush_stripe(SwizStream *stream, const uint8_t *stripe_data) {
+    const MipPlan *mip = &stream->plan.mips[stream->mip];
+    stream->plan.SwizFunc(stripe_data, stream->stripe_swizzled, &mip->context,
+                          stream->stripe, 1);
+    if (mip->stripe_swizzled_size > 0 &&
+        stream->write_func(stream->stripe_swizzled, mip->stripe_swizzled_size,
+                           stream->user_data) != 0) {
+        stream->error = SWIZ_ERROR_STREAM_WRITE;
+    }
+
+    stream->row = 0;
+    stream->stripe++;
+    if (stream->stripe == mip->stripe_count) {
+        stream->stripe = 0;
+        stream->mip++;
+        if (stream->mip == stream->plan.mip_count) {
+            stream->mip = 0;
+            stream->slice++;
+        }
+        skip_empty_mips(stream);
+    }
+}
+
+SwizStream *swizStreamBegin(SwizContext *context,
+                            SwizStreamWriteFuncPtr write_func, void *user_data) {
+    const SwizPlan *plan = swizContextGetPlan(context);
+    if (plan == NULL)
+        return NULL;
+    if (write_func == NULL) {
+        context->error = SWIZ_ERROR_NULL_POINTER;
+        return NULL;
+    }
+    SwizStream *stream = (SwizStream *)malloc(sizeof(SwizStream));
+    if (stream == NULL) {
+        context->error = SWIZ_ERROR_MEMORY_ALLOC;
+        return NULL;
+    }
+    stream->plan = *plan;
+
+    // The stream only buffers one stripe. It doesn't use the workspace of the context
+    // because other calls on the context can reallocate it while the stream is open.
+    size_t buffer_size = get_stripe_buffer_size(&stream->plan);
+    uint8_t *buffer = (uint8_t *)malloc(buffer_size > 0 ? buffer_size : 1);
+    if (buffer == NULL) {
+        free(stream);
+        context->error = SWIZ_ERROR_MEMORY_ALLOC;
+        return NULL;
+    }
+    if (context->stats != NULL) {
+        context->stats->scratch_bytes_allocated += buffer_size;
+        context->stats->allocation_count++;
+    }
+
+    stream->write_func = write_func;
+    stream->user_data = user_data;
+    stream->stripe_data = buffer;
+    stream->stripe_swizzled = buffer + get_max_stripe_data_size(&stream->plan);
+    stream->slice = 0;
+    stream->mip = 0;
+    stream->stripe = 0;
+    stream->row = 0;
+    stream->error = SWIZ_OK;
+    skip_empty_mips(stream);
+    return stream;
+}
+
+SwizError swizStreamPushRows(SwizStream *stream, const uint8_t *rows, int row_count) {
+    if (stream->error != SWIZ_OK)
+        return stream->error;
+
+    if (rows == NULL && row_count > 0) {
+        stream->error = SWIZ_ERROR_NULL_POINTER;
+        return stream->error;
+    }
+
+    while (row_count > 0 && stream->error == SWIZ_OK) {
+        if (stream->slice == stream->plan.array_size) {
+            // The texture does not have more rows.
+            stream->error = SWIZ_ERROR_INVALID_ROW_COUNT;
+            break;
+        }
+
+        const MipPlan *mip = &stream->plan.mips[stream->mip];
+        int pitch = mip->context.pitch;
+        int stripe_row_count = get_stripe_row_count(mip, stream->stripe);
+        int copy_row_count = MIN(row_count, stripe_row_count - stream->row);
+
+        // Swizzle rows without copying them when they make a whole stripe.
+        const uint8_t *stripe_data = rows;
+        if (stream->row != 0 || copy_row_count < stripe_row_count) {
+            memcpy(stream->stripe_data + stream->row * pitch, rows, copy_row_count * pitch);
+            stripe_data = stream->stripe_data;
+        }
+        stream->row += copy_row_count;
+        rows += copy_row_count * pitch;
+        row_count -= copy_row_count;
+
+        if (stream->row == stripe_row_count)
+            flush_stripe(stream, stripe_data);
+    }
+    return stream->error;
+}
+
+SwizError swizStreamEnd(SwizStream *stream) {
+    if (stream == NULL)
+        return SWIZ_ERROR_NULL_POINTER;
+
+    SwizError error = stream->error;
+    if (error == SWIZ_OK && stream->slice < stream->plan.array_size)
+        error = SWIZ_ERROR_INVALID_ROW_COUNT;
+    free(stream->stripe_data);
+    free(stream);
+    return error;
+}
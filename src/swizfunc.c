@@ -1,48 +1,207 @@
 #include <string.h>
 #include "priv.h"
 
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
 #define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
+#define MAX(X, Y) (((X) > (Y)) ? (X) : (Y))
 #define CEIL_DIV(X, PAD) (((X) + (PAD) - 1) / (PAD))
 #define ALIGN(X, PAD) (((X) + (PAD) - 1) / (PAD) * (PAD))
 
 #ifdef SWIZ_DEBUG
+#include <inttypes.h>
 #include <stdio.h>
-#define CHECK_MEMORY_INDEX_ON_DEBUG(data_index, dest_index, max_index, data_size) \
-    if (data_index + data_size > max_index) {\
+#define CHECK_MEMORY_INDEX_ON_DEBUG(data_index, copy_size, max_data_index, \
+                                    dest_index, data_size, max_dest_index) \
+    if (copy_size > 0 && data_index + copy_size > max_data_index) {\
         fprintf(stderr, \
                 "DEBUG ERROR: %s:%d:\n"\
-                "             'data_index + data_size' is outside the memory.\n"\
-                "             (data_index: %d, data_size: %d)\n", \
-                __FILE__, __LINE__, data_index, data_size);\
+                "             'data_index + copy_size' is outside the memory.\n"\
+                "             (data_index: %" PRIu64 ", copy_size: %d)\n", \
+                __FILE__, __LINE__, (uint64_t)(data_index), copy_size);\
         return;\
     }\
-    if (dest_index + data_size > max_index) {\
+    if (dest_index + data_size > max_dest_index) {\
         fprintf(stderr, \
                 "DEBUG ERROR: %s:%d:\n"\
                 "             'dest_index + data_size' is outside the memory.\n"\
-                "             (deta_index: %d, data_size: %d)\n", \
-                __FILE__, __LINE__, dest_index, data_size);\
+                "             (deta_index: %" PRIu64 ", data_size: %d)\n", \
+                __FILE__, __LINE__, (uint64_t)(dest_index), data_size);\
         return;\
     }
 #else
-#define CHECK_MEMORY_INDEX_ON_DEBUG(data_index, dest_index, max_index, data_size)
+#define CHECK_MEMORY_INDEX_ON_DEBUG(data_index, copy_size, max_data_index, \
+                                    dest_index, data_size, max_dest_index)
 #endif
 
-typedef void (*CopyBlockFuncPtr)(const uint8_t *data, int data_index,
-                                 uint8_t *dest, int dest_index, int block_data_size);
+// Copies a block from unswizzled data to swizzled data.
+// The block can be out of the texture (copy_size == 0) or at the right edge of the texture
+// (copy_size < block_data_size). Then, the rest of the block will be filled with zeros.
+static void copy_block(const uint8_t *data, size_t data_index,
+                       uint8_t *dest, size_t dest_index,
+                       int copy_size, int block_data_size) {
+    if (copy_size > 0)
+        memcpy(dest + dest_index, data + data_index, copy_size);
+    memset(dest + dest_index + copy_size, 0, block_data_size - copy_size);
+}
+
+// Copies a block from swizzled data to unswizzled data.
+// Padding bytes (out of the texture) will be skipped.
+static void copy_block_inverse(const uint8_t *data, size_t data_index,
+                               uint8_t *dest, size_t dest_index, int copy_size) {
+    if (copy_size > 0)
+        memcpy(dest + data_index, data + dest_index, copy_size);
+}
+
+// Returns how many bytes of a block at (x, y) are in the unswizzled texture.
+static int get_copy_size(int x, int y, int pitch, int block_count_y, int block_data_size) {
+    int data_x = x * block_data_size;
+    if (y >= block_count_y || data_x >= pitch)
+        return 0;
+    return MIN(block_data_size, pitch - data_x);
+}
 
-static void copy_block(const uint8_t *data, int data_index,
-                       uint8_t *dest, int dest_index, int block_data_size) {
-    memcpy(dest + dest_index, data + data_index, block_data_size);
+// Mipmaps can be larger than 2 GiB. So, we need 64-bit offsets here.
+static size_t block_pos_to_index(int x, int y, int pitch, int block_data_size) {
+    return (size_t)y * pitch + (size_t)x * block_data_size;
 }
 
-static void copy_block_inverse(const uint8_t *data, int data_index,
-                               uint8_t *dest, int dest_index, int block_data_size) {
-    memcpy(dest + data_index, data + dest_index, block_data_size);
+// Defines copy_tile_* and copy_tile_inverse_* for a block size. See CopyTileFuncPtr.
+// Compilers can replace memcpy with a single load and store when size is a constant.
+#define DEFINE_COPY_TILE_FUNCS(name, size) \
+static void copy_tile_##name(const uint8_t *data, size_t data_index, \
+                             uint8_t *dest, size_t dest_index, const TileContext *tc) { \
+    const uint8_t *src = data + data_index; \
+    uint8_t *dst = dest + dest_index; \
+    const int *offsets = tc->offsets; \
+    for (int i = 0; i < tc->block_count; i++) { \
+        memcpy(dst, src + offsets[i], size); \
+        dst += size; \
+    } \
+} \
+static void copy_tile_inverse_##name(const uint8_t *data, size_t data_index, \
+                                     uint8_t *dest, size_t dest_index, \
+                                     const TileContext *tc) { \
+    const uint8_t *src = data + dest_index; \
+    uint8_t *dst = dest + data_index; \
+    const int *offsets = tc->offsets; \
+    for (int i = 0; i < tc->block_count; i++) { \
+        memcpy(dst + offsets[i], src, size); \
+        src += size; \
+    } \
+}
+
+DEFINE_COPY_TILE_FUNCS(1, 1)
+DEFINE_COPY_TILE_FUNCS(2, 2)
+DEFINE_COPY_TILE_FUNCS(4, 4)
+DEFINE_COPY_TILE_FUNCS(8, 8)
+DEFINE_COPY_TILE_FUNCS(16, 16)
+DEFINE_COPY_TILE_FUNCS(generic, tc->block_data_size)
+
+static CopyTileFuncPtr get_copy_tile_func(int block_data_size, int swizzle) {
+    switch (block_data_size) {
+    case 1:
+        return swizzle ? copy_tile_1 : copy_tile_inverse_1;
+    case 2:
+        return swizzle ? copy_tile_2 : copy_tile_inverse_2;
+    case 4:
+        return swizzle ? copy_tile_4 : copy_tile_inverse_4;
+    case 8:
+        return swizzle ? copy_tile_8 : copy_tile_inverse_8;
+    case 16:
+        return swizzle ? copy_tile_16 : copy_tile_inverse_16;
+    default:
+        return swizzle ? copy_tile_generic : copy_tile_inverse_generic;
+    }
+}
+
+// Sets the fields that copy_tile_func uses. pitch is the row size of unswizzled data.
+static void init_tile_kernel(TileContext *tc, const int *order, int tile_width, int tile_height,
+                             int pitch, int block_data_size, int swizzle) {
+    tc->order = order;
+    tc->tile_width = tile_width;
+    tc->tile_height = tile_height;
+    tc->block_count = tile_width * tile_height;
+    tc->block_data_size = block_data_size;
+    tc->pitch = pitch;
+
+    // Precompute positions of blocks. So, we don't need % and / for each block.
+    for (int i = 0; i < tc->block_count; i++) {
+        tc->offsets[i] = (int)block_pos_to_index(order[i] % tile_width, order[i] / tile_width,
+                                                 pitch, block_data_size);
+    }
+
+    tc->copy_tile_func = get_copy_tile_func(block_data_size, swizzle);
+    tc->swizzle = swizzle;
+}
+
+// first_row and row_count are the range of block rows that the caller swizzles.
+// data should point to first_row, and new_data should point to the first tile of the range.
+static void init_tile_context(TileContext *tc, const MipContext *context,
+                              const int *order, int tile_width, int tile_height,
+                              int first_row, int row_count, int tile_count, int swizzle) {
+    int block_data_size = context->block_data_size;
+    int block_count_y = CEIL_DIV(context->height, context->block_height);
+    init_tile_kernel(tc, order, tile_width, tile_height, context->pitch, block_data_size,
+                     swizzle);
+    tc->full_block_count_x = context->pitch / block_data_size;
+    // The number of rows in the range.
+    tc->block_count_y = MAX(0, MIN(block_count_y - first_row, row_count));
+#ifdef SWIZ_DEBUG
+    tc->max_data_index = (size_t)tc->pitch * tc->block_count_y;
+    tc->max_dest_index = (size_t)tile_count * tc->block_count * block_data_size;
+#else
+    (void)tile_count;  // Only the debug build checks memory access.
+#endif
 }
 
-static int block_pos_to_index(int x, int y, int pitch, int block_data_size) {
-    return y * pitch + x * block_data_size;
+// Swizzles (or unswizzles) a tile at (x, y).
+// Blocks out of the texture will be filled with zeros when swizzling,
+// and will be skipped when unswizzling.
+static void copy_tile(const uint8_t *data, uint8_t *new_data,
+                      int x, int y, size_t dest_index, const TileContext *tc) {
+    int block_data_size = tc->block_data_size;
+    int pitch = tc->pitch;
+    if (x + tc->tile_width <= tc->full_block_count_x &&
+        y + tc->tile_height <= tc->block_count_y) {
+        // The whole tile is in the texture.
+        size_t data_index = block_pos_to_index(x, y, pitch, block_data_size);
+
+        // Check access violation in debug build.
+        CHECK_MEMORY_INDEX_ON_DEBUG(data_index + (size_t)(tc->tile_height - 1) * pitch,
+                                    tc->tile_width * block_data_size, tc->max_data_index,
+                                    dest_index, tc->block_count * block_data_size,
+                                    tc->max_dest_index)
+
+        tc->copy_tile_func(data, data_index, new_data, dest_index, tc);
+        return;
+    }
+
+    // The tile has padding.
+    for (const int *t = tc->order; t < tc->order + tc->block_count; ++t) {
+        int data_x = x + *t % tc->tile_width;
+        int data_y = y + *t / tc->tile_width;
+
+        // copy a block at (data_x, data_y) to dest_index,
+        // or copy a block at dest_index to (data_x, data_y)
+        size_t data_index = block_pos_to_index(data_x, data_y, pitch, block_data_size);
+        // The last block of a row can be smaller than block_data_size
+        // when getSwizzleBlockSizeSwitch() expanded the block.
+        int copy_size = get_copy_size(data_x, data_y, pitch,
+                                      tc->block_count_y, block_data_size);
+
+        // Check access violation in debug build.
+        CHECK_MEMORY_INDEX_ON_DEBUG(data_index, copy_size, tc->max_data_index,
+                                    dest_index, block_data_size, tc->max_dest_index)
+
+        if (tc->swizzle)
+            copy_block(data, data_index, new_data, dest_index, copy_size, block_data_size);
+        else
+            copy_block_inverse(data, data_index, new_data, dest_index, copy_size);
+        dest_index += block_data_size;
+    }
 }
 
 void getSwizzleBlockSizeDefault(MipContext *context) {
@@ -92,52 +251,99 @@ void getPaddedSizePS4(MipContext *context) {
     context->height = block_count_y_aligned * block_height;
 }
 
-static void swiz_func_ps4_base(const uint8_t *data, uint8_t *new_data,
-                               const MipContext *context,
-                               CopyBlockFuncPtr copy_block_func) {
-    int block_width = context->block_width;
-    int block_height = context->block_height;
-    int block_data_size = context->block_data_size;
-    int block_count_x = CEIL_DIV(context->width, block_width);
-    int block_count_y = CEIL_DIV(context->height, block_height);
-    int block_count_x_aligned = ALIGN(block_count_x, GOB_BLOCK_COUNT_X_PS4);
-    int block_count_y_aligned = ALIGN(block_count_y, GOB_BLOCK_COUNT_X_PS4);
-    int pitch = block_count_x * block_data_size;
-#ifdef SWIZ_DEBUG
-    int max_index = pitch * block_count_y;
+// Interleaves bits of x and y. It's the same as MORTON8x8.
+static int morton_encode8x8(int x, int y) {
+#ifdef __BMI2__
+    return _pdep_u32(x, 0x15) | _pdep_u32(y, 0x2A);
+#else
+    return (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) |
+           ((y & 2) << 2) | ((x & 4) << 2) | ((y & 4) << 3);
 #endif
+}
 
-    int dest_index = 0;
-    for (int y = 0; y < block_count_y_aligned; y += GOB_BLOCK_COUNT_X_PS4) {
-        for (int x = 0; x < block_count_x_aligned; x += GOB_BLOCK_COUNT_X_PS4) {
-            // swizzles an 8x8 matrix of blocks in morton order.
-            for (int *t = &MORTON8x8[0]; t < &MORTON8x8[0] + GOB_BLOCK_COUNT_PS4; ++t) {
-                int data_x = x + *t % GOB_BLOCK_COUNT_X_PS4;
-                int data_y = y + *t / GOB_BLOCK_COUNT_X_PS4;
+static void morton_decode8x8(int morton, int *x, int *y) {
+#ifdef __BMI2__
+    *x = _pext_u32(morton, 0x15);
+    *y = _pext_u32(morton, 0x2A);
+#else
+    *x = (morton & 1) | ((morton >> 1) & 2) | ((morton >> 2) & 4);
+    *y = ((morton >> 1) & 1) | ((morton >> 2) & 2) | ((morton >> 3) & 4);
+#endif
+}
 
-                // copy a block at (data_x, data_y) to dest_index,
-                // or copy a block at dest_index to (data_x, data_y)
-                int data_index = block_pos_to_index(data_x, data_y,
-                                                    pitch, block_data_size);
+// Gets the position of a block in a swizzled mipmap.
+uint64_t getBlockAddressPS4(const MipContext *context, int x, int y) {
+    int block_count_x = CEIL_DIV(context->width, context->block_width);
+    int tile_count_x = CEIL_DIV(block_count_x, GOB_BLOCK_COUNT_X_PS4);
+    uint64_t tile_index = (uint64_t)(y / GOB_BLOCK_COUNT_X_PS4) * tile_count_x +
+                          x / GOB_BLOCK_COUNT_X_PS4;
 
-                // Check access violation in debug build.
-                CHECK_MEMORY_INDEX_ON_DEBUG(data_index, dest_index, max_index, block_data_size)
+    int morton = morton_encode8x8(x & 7, y & 7);
+    return (tile_index * GOB_BLOCK_COUNT_PS4 + morton) * context->block_data_size;
+}
 
-                copy_block_func(data, data_index, new_data, dest_index, block_data_size);
-                dest_index += block_data_size;
-            }
+void getBlockPositionPS4(const MipContext *context, uint64_t block_index, int *x, int *y) {
+    int block_count_x = CEIL_DIV(context->width, context->block_width);
+    int tile_count_x = CEIL_DIV(block_count_x, GOB_BLOCK_COUNT_X_PS4);
+    uint64_t tile_index = block_index / GOB_BLOCK_COUNT_PS4;
+    morton_decode8x8((int)(block_index % GOB_BLOCK_COUNT_PS4), x, y);
+    *x += (int)(tile_index % tile_count_x) * GOB_BLOCK_COUNT_X_PS4;
+    *y += (int)(tile_index / tile_count_x) * GOB_BLOCK_COUNT_X_PS4;
+}
+
+// An 8x8 tile is a stripe of PS4. Swizzled data of a stripe is contiguous.
+void getStripeHeightPS4(MipContext *context) {
+    context->stripe_height = GOB_BLOCK_COUNT_X_PS4;
+}
+
+// Swizzles (or unswizzles) stripes of a mipmap without padded buffers.
+// context->width and context->height should be the unpadded size.
+static void swiz_func_ps4_base(const uint8_t *data, uint8_t *new_data,
+                               const MipContext *context,
+                               int stripe_begin, int stripe_count, int swizzle) {
+    int block_count_x = CEIL_DIV(context->width, context->block_width);
+    int block_count_x_aligned = ALIGN(block_count_x, GOB_BLOCK_COUNT_X_PS4);
+    int row_count = stripe_count * GOB_BLOCK_COUNT_X_PS4;
+    int tile_count = block_count_x_aligned / GOB_BLOCK_COUNT_X_PS4 * stripe_count;
+    int tile_size = GOB_BLOCK_COUNT_PS4 * context->block_data_size;
+
+    TileContext tc;
+    init_tile_context(&tc, context, MORTON8x8, GOB_BLOCK_COUNT_X_PS4, GOB_BLOCK_COUNT_X_PS4,
+                      stripe_begin * GOB_BLOCK_COUNT_X_PS4, row_count, tile_count, swizzle);
+
+    // Use SIMD functions when they support the block size.
+    CopyTileFuncPtr copy_tile_simd = getCopyTileFuncPS4SIMD(context->block_data_size, swizzle,
+                                                            context->kernel_variant);
+    if (copy_tile_simd != NULL)
+        tc.copy_tile_func = copy_tile_simd;
+
+    size_t dest_index = 0;
+    for (int y = 0; y < row_count; y += GOB_BLOCK_COUNT_X_PS4) {
+        for (int x = 0; x < block_count_x_aligned; x += GOB_BLOCK_COUNT_X_PS4) {
+            // swizzles an 8x8 matrix of blocks in morton order.
+            copy_tile(data, new_data, x, y, dest_index, &tc);
+            dest_index += tile_size;
         }
     }
 }
 
+void initRectTileContextPS4(TileContext *tc, const MipContext *context, int pitch, int swizzle) {
+    init_tile_kernel(tc, MORTON8x8, GOB_BLOCK_COUNT_X_PS4, GOB_BLOCK_COUNT_X_PS4, pitch,
+                     context->block_data_size, swizzle);
+    CopyTileFuncPtr copy_tile_simd = getCopyTileFuncPS4SIMD(context->block_data_size, swizzle,
+                                                            context->kernel_variant);
+    if (copy_tile_simd != NULL)
+        tc->copy_tile_func = copy_tile_simd;
+}
+
 void swizFuncPS4(const uint8_t *data, uint8_t *new_data,
-                 const MipContext *context) {
-    swiz_func_ps4_base(data, new_data, context, copy_block);
+                 const MipContext *context, int stripe_begin, int stripe_count) {
+    swiz_func_ps4_base(data, new_data, context, stripe_begin, stripe_count, 1);
 }
 
 void unswizFuncPS4(const uint8_t *data, uint8_t *new_data,
-                   const MipContext *context) {
-    swiz_func_ps4_base(data, new_data, context, copy_block_inverse);
+                   const MipContext *context, int stripe_begin, int stripe_count) {
+    swiz_func_ps4_base(data, new_data, context, stripe_begin, stripe_count, 0);
 }
 
 // switch swizzling functions
@@ -164,7 +370,7 @@ static int get_gobs_per_block(int block_width, int block_height,
         // uncompressed format should use 16.
         return 16;
     }
-    return MIN(gob_count_y, gobs_height);
+    return MAX(1, MIN(gob_count_y, gobs_height));
 }
 
 void getPaddedSizeSwitch(MipContext *context) {
@@ -205,60 +411,113 @@ static int SWIZ_ORDER_SWITCH[32] = {
     26, 30, 27, 31
 };
 
+// Gets the position of a block in a swizzled mipmap.
+uint64_t getBlockAddressSwitch(const MipContext *context, int x, int y) {
+    int block_count_x = CEIL_DIV(context->width, context->block_width);
+    int block_count_y = CEIL_DIV(context->height, context->block_height);
+    int gob_count_x = CEIL_DIV(block_count_x, GOB_BLOCK_COUNT_X_SWITCH);
+    int gob_count_y = CEIL_DIV(block_count_y, GOB_BLOCK_COUNT_Y_SWITCH);
+    int gobs_per_block = get_gobs_per_block(context->block_width, context->block_height,
+                                            gob_count_y, context->gobs_height);
+
+    // GOBs are stacked vertically in a GOB block.
+    int gob_y = y / GOB_BLOCK_COUNT_Y_SWITCH;
+    uint64_t gob_index = ((uint64_t)(gob_y / gobs_per_block) * gob_count_x +
+                          x / GOB_BLOCK_COUNT_X_SWITCH) * gobs_per_block +
+                         gob_y % gobs_per_block;
+
+    // It's the same as SWIZ_ORDER_SWITCH.
+    int block_index = (y & 1) | ((x & 1) << 1) | ((y & 6) << 1) | ((x & 2) << 3);
+    return (gob_index * GOB_BLOCK_COUNT_SWITCH + block_index) * context->block_data_size;
+}
+
+void getBlockPositionSwitch(const MipContext *context, uint64_t block_index, int *x, int *y) {
+    int block_count_x = CEIL_DIV(context->width, context->block_width);
+    int block_count_y = CEIL_DIV(context->height, context->block_height);
+    int gob_count_x = CEIL_DIV(block_count_x, GOB_BLOCK_COUNT_X_SWITCH);
+    int gob_count_y = CEIL_DIV(block_count_y, GOB_BLOCK_COUNT_Y_SWITCH);
+    int gobs_per_block = get_gobs_per_block(context->block_width, context->block_height,
+                                            gob_count_y, context->gobs_height);
+
+    uint64_t gob_index = block_index / GOB_BLOCK_COUNT_SWITCH;
+    int index = (int)(block_index % GOB_BLOCK_COUNT_SWITCH);
+    uint64_t gob_block_index = gob_index / gobs_per_block;
+    int gob_x = (int)(gob_block_index % gob_count_x);
+    int gob_y = (int)(gob_block_index / gob_count_x) * gobs_per_block +
+                (int)(gob_index % gobs_per_block);
+    *x = gob_x * GOB_BLOCK_COUNT_X_SWITCH + (((index >> 1) & 1) | ((index >> 3) & 2));
+    *y = gob_y * GOB_BLOCK_COUNT_Y_SWITCH + ((index & 1) | ((index >> 1) & 6));
+}
+
+// A row of GOB blocks is a stripe of Switch. Swizzled data of a stripe is contiguous.
+void getStripeHeightSwitch(MipContext *context) {
+    int block_count_y = CEIL_DIV(context->height, context->block_height);
+    int gob_count_y = CEIL_DIV(block_count_y, GOB_BLOCK_COUNT_Y_SWITCH);
+    int gobs_per_block = get_gobs_per_block(context->block_width, context->block_height,
+                                            gob_count_y, context->gobs_height);
+    context->stripe_height = gobs_per_block * GOB_BLOCK_COUNT_Y_SWITCH;
+}
+
+// Swizzles (or unswizzles) stripes of a mipmap without padded buffers.
+// context->width and context->height should be the unpadded size.
 static void swiz_func_switch_base(const uint8_t *data, uint8_t *new_data,
                                   const MipContext *context,
-                                  CopyBlockFuncPtr copy_block_func) {
+                                  int stripe_begin, int stripe_count, int swizzle) {
     int block_width = context->block_width;
     int block_height = context->block_height;
-    int block_data_size = context->block_data_size;
     int block_count_x = CEIL_DIV(context->width, block_width);
     int block_count_y = CEIL_DIV(context->height, block_height);
-    int pitch = block_count_x * block_data_size;
 
     int gob_count_x = CEIL_DIV(block_count_x, GOB_BLOCK_COUNT_X_SWITCH);
     int gob_count_y = CEIL_DIV(block_count_y, GOB_BLOCK_COUNT_Y_SWITCH);
 
-#ifdef SWIZ_DEBUG
-    int max_index = pitch * block_count_y;
-#endif
     int gobs_per_block = get_gobs_per_block(block_width, block_height,
                                             gob_count_y, context->gobs_height);
-
-    int dest_index = 0;
-    for (int i = 0; i < CEIL_DIV(gob_count_y, gobs_per_block); i++) {
+    int stripe_height = gobs_per_block * GOB_BLOCK_COUNT_Y_SWITCH;
+    int gob_size = GOB_BLOCK_COUNT_SWITCH * context->block_data_size;
+
+    TileContext tc;
+    init_tile_context(&tc, context, SWIZ_ORDER_SWITCH,
+                      GOB_BLOCK_COUNT_X_SWITCH, GOB_BLOCK_COUNT_Y_SWITCH,
+                      stripe_begin * stripe_height, stripe_count * stripe_height,
+                      stripe_count * gob_count_x * gobs_per_block, swizzle);
+
+    // Use SIMD functions to copy a whole GOB at once.
+    CopyTileFuncPtr copy_tile_simd = getCopyTileFuncSwitchSIMD(context->block_data_size,
+                                                               swizzle, context->kernel_variant);
+    if (copy_tile_simd != NULL)
+        tc.copy_tile_func = copy_tile_simd;
+
+    size_t dest_index = 0;
+    for (int i = 0; i < stripe_count; i++) {
         for (int x = 0; x < gob_count_x * GOB_BLOCK_COUNT_X_SWITCH; x += GOB_BLOCK_COUNT_X_SWITCH) {
             for (int k = 0; k < gobs_per_block; k++) {
                 int y = (i * gobs_per_block + k) * GOB_BLOCK_COUNT_Y_SWITCH;
 
                 // swizzles a 4x8 matrix of blocks.
-                for (int *l = &SWIZ_ORDER_SWITCH[0];
-                     l < &SWIZ_ORDER_SWITCH[0] + GOB_BLOCK_COUNT_SWITCH; ++l) {
-                    int data_x = x + *l % GOB_BLOCK_COUNT_X_SWITCH;
-                    int data_y = y + *l / GOB_BLOCK_COUNT_X_SWITCH;
-                    int data_index = block_pos_to_index(data_x, data_y,
-                                                        pitch, block_data_size);
-
-                    // Check access violation in debug build.
-                    CHECK_MEMORY_INDEX_ON_DEBUG(data_index, dest_index,
-                                                max_index, block_data_size)
-
-                    // copy a block at (data_x, data_y) to dest_index,
-                    // or copy a block at dest_index to (data_x, data_y)
-                    copy_block_func(data, data_index,
-                                    new_data, dest_index, block_data_size);
-                    dest_index += block_data_size;
-                }
+                copy_tile(data, new_data, x, y, dest_index, &tc);
+                dest_index += gob_size;
             }
         }
     }
 }
 
+void initRectTileContextSwitch(TileContext *tc, const MipContext *context,
+                               int pitch, int swizzle) {
+    init_tile_kernel(tc, SWIZ_ORDER_SWITCH, GOB_BLOCK_COUNT_X_SWITCH, GOB_BLOCK_COUNT_Y_SWITCH,
+                     pitch, context->block_data_size, swizzle);
+    CopyTileFuncPtr copy_tile_simd = getCopyTileFuncSwitchSIMD(context->block_data_size,
+                                                               swizzle, context->kernel_variant);
+    if (copy_tile_simd != NULL)
+        tc->copy_tile_func = copy_tile_simd;
+}
+
 void swizFuncSwitch(const uint8_t *data, uint8_t *new_data,
-                    const MipContext *context) {
-    swiz_func_switch_base(data, new_data, context, copy_block);
+                    const MipContext *context, int stripe_begin, int stripe_count) {
+    swiz_func_switch_base(data, new_data, context, stripe_begin, stripe_count, 1);
 }
 
 void unswizFuncSwitch(const uint8_t *data, uint8_t *new_data,
-                      const MipContext *context) {
-    swiz_func_switch_base(data, new_data, context, copy_block_inverse);
+                      const MipContext *context, int stripe_begin, int stripe_count) {
+    swiz_func_switch_base(data, new_data, context, stripe_begin, stripe_count, 0);
 }
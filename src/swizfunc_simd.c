@@ -0,0 +1,576 @@
+#include <string.h>
+#include "priv.h"
+
+// Kernels are compiled for every instruction set and selected at runtime.
+// So, the library does not need -mavx2 or /arch:AVX2 to use AVX2 kernels.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SWIZ_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SWIZ_TARGET(isa) __attribute__((target(isa)))
+#else
+// MSVC can use intrinsics without compiler options.
+#define SWIZ_TARGET(isa)
+#endif
+
+#define SWIZ_TARGET_SSE2 SWIZ_TARGET("sse2")
+#define SWIZ_TARGET_AVX2 SWIZ_TARGET("avx2")
+#define SWIZ_TARGET_AVX512 SWIZ_TARGET("avx512f")
+
+// ps4 swizzling functions
+
+/**
+ * An 8x8 tile of PS4 is a 4x4 matrix of 2x2 blocks (quads) in morton order.
+ * Blocks of a quad are contiguous in swizzled data.
+ *  0  1 |  4  5 | 16 17 | 20 21
+ *  2  3 |  6  7 | 18 19 | 22 23
+ * So, we can copy 2 rows of a tile to 4 quads at once.
+ * QUAD_ROW_PS4[y] + QUAD_COL_PS4[x] is the index of the quad at (x, y).
+ */
+static const int QUAD_COL_PS4[4] = { 0, 1, 4, 5 };
+static const int QUAD_ROW_PS4[4] = { 0, 2, 8, 10 };
+
+#ifdef SWIZ_X86
+
+#define LOAD128(p) _mm_loadu_si128((const __m128i *)(p))
+#define STORE128(p, v) _mm_storeu_si128((__m128i *)(p), v)
+
+// 4-byte blocks: a quad is 8 bytes from a row and 8 bytes from the next row.
+SWIZ_TARGET_SSE2
+static void copy_tile_ps4_4_sse2(const uint8_t *data, size_t data_index,
+                                 uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    for (int y = 0; y < 4; y++) {
+        const uint8_t *row0 = data + data_index + y * 2 * pitch;
+        const uint8_t *row1 = row0 + pitch;
+        uint8_t *quads = dest + dest_index + QUAD_ROW_PS4[y] * 16;
+        for (int x = 0; x < 2; x++) {
+            // 4 blocks of 2 rows. It's 2 quads.
+            __m128i a = LOAD128(row0 + x * 16);
+            __m128i b = LOAD128(row1 + x * 16);
+            STORE128(quads + QUAD_COL_PS4[x * 2] * 16, _mm_unpacklo_epi64(a, b));
+            STORE128(quads + QUAD_COL_PS4[x * 2 + 1] * 16, _mm_unpackhi_epi64(a, b));
+        }
+    }
+}
+
+SWIZ_TARGET_SSE2
+static void copy_tile_inverse_ps4_4_sse2(const uint8_t *data, size_t data_index,
+                                         uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    for (int y = 0; y < 4; y++) {
+        uint8_t *row0 = dest + data_index + y * 2 * pitch;
+        uint8_t *row1 = row0 + pitch;
+        const uint8_t *quads = data + dest_index + QUAD_ROW_PS4[y] * 16;
+        for (int x = 0; x < 2; x++) {
+            __m128i a = LOAD128(quads + QUAD_COL_PS4[x * 2] * 16);
+            __m128i b = LOAD128(quads + QUAD_COL_PS4[x * 2 + 1] * 16);
+            STORE128(row0 + x * 16, _mm_unpacklo_epi64(a, b));
+            STORE128(row1 + x * 16, _mm_unpackhi_epi64(a, b));
+        }
+    }
+}
+
+// 8-byte blocks: a quad is 16 bytes from a row and 16 bytes from the next row.
+SWIZ_TARGET_SSE2
+static void copy_tile_ps4_8_sse2(const uint8_t *data, size_t data_index,
+                                 uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    for (int y = 0; y < 4; y++) {
+        const uint8_t *row0 = data + data_index + y * 2 * pitch;
+        const uint8_t *row1 = row0 + pitch;
+        uint8_t *quads = dest + dest_index + QUAD_ROW_PS4[y] * 32;
+        for (int x = 0; x < 4; x++) {
+            uint8_t *quad = quads + QUAD_COL_PS4[x] * 32;
+            STORE128(quad, LOAD128(row0 + x * 16));
+            STORE128(quad + 16, LOAD128(row1 + x * 16));
+        }
+    }
+}
+
+SWIZ_TARGET_SSE2
+static void copy_tile_inverse_ps4_8_sse2(const uint8_t *data, size_t data_index,
+                                         uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    for (int y = 0; y < 4; y++) {
+        uint8_t *row0 = dest + data_index + y * 2 * pitch;
+        uint8_t *row1 = row0 + pitch;
+        const uint8_t *quads = data + dest_index + QUAD_ROW_PS4[y] * 32;
+        for (int x = 0; x < 4; x++) {
+            const uint8_t *quad = quads + QUAD_COL_PS4[x] * 32;
+            STORE128(row0 + x * 16, LOAD128(quad));
+            STORE128(row1 + x * 16, LOAD128(quad + 16));
+        }
+    }
+}
+
+// 16-byte blocks: a quad is 32 bytes from a row and 32 bytes from the next row.
+SWIZ_TARGET_SSE2
+static void copy_tile_ps4_16_sse2(const uint8_t *data, size_t data_index,
+                                  uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    for (int y = 0; y < 4; y++) {
+        const uint8_t *row0 = data + data_index + y * 2 * pitch;
+        const uint8_t *row1 = row0 + pitch;
+        uint8_t *quads = dest + dest_index + QUAD_ROW_PS4[y] * 64;
+        for (int x = 0; x < 4; x++) {
+            uint8_t *quad = quads + QUAD_COL_PS4[x] * 64;
+            STORE128(quad, LOAD128(row0 + x * 32));
+            STORE128(quad + 16, LOAD128(row0 + x * 32 + 16));
+            STORE128(quad + 32, LOAD128(row1 + x * 32));
+            STORE128(quad + 48, LOAD128(row1 + x * 32 + 16));
+        }
+    }
+}
+
+SWIZ_TARGET_SSE2
+static void copy_tile_inverse_ps4_16_sse2(const uint8_t *data, size_t data_index,
+                                          uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    for (int y = 0; y < 4; y++) {
+        uint8_t *row0 = dest + data_index + y * 2 * pitch;
+        uint8_t *row1 = row0 + pitch;
+        const uint8_t *quads = data + dest_index + QUAD_ROW_PS4[y] * 64;
+        for (int x = 0; x < 4; x++) {
+            const uint8_t *quad = quads + QUAD_COL_PS4[x] * 64;
+            STORE128(row0 + x * 32, LOAD128(quad));
+            STORE128(row0 + x * 32 + 16, LOAD128(quad + 16));
+            STORE128(row1 + x * 32, LOAD128(quad + 32));
+            STORE128(row1 + x * 32 + 16, LOAD128(quad + 48));
+        }
+    }
+}
+
+#define LOAD256(p) _mm256_loadu_si256((const __m256i *)(p))
+#define STORE256(p, v) _mm256_storeu_si256((__m256i *)(p), v)
+
+// 4-byte blocks: a whole row of a tile is 32 bytes.
+SWIZ_TARGET_AVX2
+static void copy_tile_ps4_4_avx2(const uint8_t *data, size_t data_index,
+                                 uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    for (int y = 0; y < 4; y++) {
+        const uint8_t *row0 = data + data_index + y * 2 * pitch;
+        __m256i a = LOAD256(row0);
+        __m256i b = LOAD256(row0 + pitch);
+        // lo: quad 0 and quad 2, hi: quad 1 and quad 3
+        __m256i lo = _mm256_unpacklo_epi64(a, b);
+        __m256i hi = _mm256_unpackhi_epi64(a, b);
+        uint8_t *quads = dest + dest_index + QUAD_ROW_PS4[y] * 16;
+        STORE256(quads, _mm256_permute2x128_si256(lo, hi, 0x20));
+        STORE256(quads + QUAD_COL_PS4[2] * 16, _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+}
+
+SWIZ_TARGET_AVX2
+static void copy_tile_inverse_ps4_4_avx2(const uint8_t *data, size_t data_index,
+                                         uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    for (int y = 0; y < 4; y++) {
+        const uint8_t *quads = data + dest_index + QUAD_ROW_PS4[y] * 16;
+        __m256i q01 = LOAD256(quads);
+        __m256i q23 = LOAD256(quads + QUAD_COL_PS4[2] * 16);
+        __m256i lo = _mm256_permute2x128_si256(q01, q23, 0x20);
+        __m256i hi = _mm256_permute2x128_si256(q01, q23, 0x31);
+        uint8_t *row0 = dest + data_index + y * 2 * pitch;
+        STORE256(row0, _mm256_unpacklo_epi64(lo, hi));
+        STORE256(row0 + pitch, _mm256_unpackhi_epi64(lo, hi));
+    }
+}
+
+// 8-byte blocks: 32 bytes of a row are the upper halves of 2 quads.
+SWIZ_TARGET_AVX2
+static void copy_tile_ps4_8_avx2(const uint8_t *data, size_t data_index,
+                                 uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    for (int y = 0; y < 4; y++) {
+        const uint8_t *row0 = data + data_index + y * 2 * pitch;
+        const uint8_t *row1 = row0 + pitch;
+        uint8_t *quads = dest + dest_index + QUAD_ROW_PS4[y] * 32;
+        for (int x = 0; x < 2; x++) {
+            __m256i a = LOAD256(row0 + x * 32);
+            __m256i b = LOAD256(row1 + x * 32);
+            STORE256(quads + QUAD_COL_PS4[x * 2] * 32, _mm256_permute2x128_si256(a, b, 0x20));
+            STORE256(quads + QUAD_COL_PS4[x * 2 + 1] * 32,
+                     _mm256_permute2x128_si256(a, b, 0x31));
+        }
+    }
+}
+
+SWIZ_TARGET_AVX2
+static void copy_tile_inverse_ps4_8_avx2(const uint8_t *data, size_t data_index,
+                                         uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    for (int y = 0; y < 4; y++) {
+        uint8_t *row0 = dest + data_index + y * 2 * pitch;
+        uint8_t *row1 = row0 + pitch;
+        const uint8_t *quads = data + dest_index + QUAD_ROW_PS4[y] * 32;
+        for (int x = 0; x < 2; x++) {
+            __m256i a = LOAD256(quads + QUAD_COL_PS4[x * 2] * 32);
+            __m256i b = LOAD256(quads + QUAD_COL_PS4[x * 2 + 1] * 32);
+            STORE256(row0 + x * 32, _mm256_permute2x128_si256(a, b, 0x20));
+            STORE256(row1 + x * 32, _mm256_permute2x128_si256(a, b, 0x31));
+        }
+    }
+}
+
+// 16-byte blocks: 32 bytes of a row are the upper half of a quad.
+SWIZ_TARGET_AVX2
+static void copy_tile_ps4_16_avx2(const uint8_t *data, size_t data_index,
+                                  uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    for (int y = 0; y < 4; y++) {
+        const uint8_t *row0 = data + data_index + y * 2 * pitch;
+        const uint8_t *row1 = row0 + pitch;
+        uint8_t *quads = dest + dest_index + QUAD_ROW_PS4[y] * 64;
+        for (int x = 0; x < 4; x++) {
+            uint8_t *quad = quads + QUAD_COL_PS4[x] * 64;
+            STORE256(quad, LOAD256(row0 + x * 32));
+            STORE256(quad + 32, LOAD256(row1 + x * 32));
+        }
+    }
+}
+
+SWIZ_TARGET_AVX2
+static void copy_tile_inverse_ps4_16_avx2(const uint8_t *data, size_t data_index,
+                                          uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    for (int y = 0; y < 4; y++) {
+        uint8_t *row0 = dest + data_index + y * 2 * pitch;
+        uint8_t *row1 = row0 + pitch;
+        const uint8_t *quads = data + dest_index + QUAD_ROW_PS4[y] * 64;
+        for (int x = 0; x < 4; x++) {
+            const uint8_t *quad = quads + QUAD_COL_PS4[x] * 64;
+            STORE256(row0 + x * 32, LOAD256(quad));
+            STORE256(row1 + x * 32, LOAD256(quad + 32));
+        }
+    }
+}
+
+
+#define LOAD512(p) _mm512_loadu_si512((const void *)(p))
+#define STORE512(p, v) _mm512_storeu_si512((void *)(p), v)
+
+// Joins 32 bytes from a row and 32 bytes from the next row.
+#define JOIN256(lo, hi) _mm512_inserti64x4(_mm512_castsi256_si512(lo), hi, 1)
+
+// 8-byte blocks: a whole row of a tile is 64 bytes. Quads 0 and 1 are contiguous.
+SWIZ_TARGET_AVX512
+static void copy_tile_ps4_8_avx512(const uint8_t *data, size_t data_index,
+                                   uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    // Indices of 8-byte lanes. 0-7 are from a row, and 8-15 are from the next row.
+    __m512i quad01 = _mm512_set_epi64(11, 10, 3, 2, 9, 8, 1, 0);
+    __m512i quad23 = _mm512_set_epi64(15, 14, 7, 6, 13, 12, 5, 4);
+    for (int y = 0; y < 4; y++) {
+        const uint8_t *row0 = data + data_index + y * 2 * pitch;
+        __m512i a = LOAD512(row0);
+        __m512i b = LOAD512(row0 + pitch);
+        uint8_t *quads = dest + dest_index + QUAD_ROW_PS4[y] * 32;
+        STORE512(quads, _mm512_permutex2var_epi64(a, quad01, b));
+        STORE512(quads + QUAD_COL_PS4[2] * 32, _mm512_permutex2var_epi64(a, quad23, b));
+    }
+}
+
+SWIZ_TARGET_AVX512
+static void copy_tile_inverse_ps4_8_avx512(const uint8_t *data, size_t data_index,
+                                           uint8_t *dest, size_t dest_index,
+                                           const TileContext *tc) {
+    int pitch = tc->pitch;
+    __m512i upper = _mm512_set_epi64(13, 12, 9, 8, 5, 4, 1, 0);
+    __m512i lower = _mm512_set_epi64(15, 14, 11, 10, 7, 6, 3, 2);
+    for (int y = 0; y < 4; y++) {
+        const uint8_t *quads = data + dest_index + QUAD_ROW_PS4[y] * 32;
+        __m512i q01 = LOAD512(quads);
+        __m512i q23 = LOAD512(quads + QUAD_COL_PS4[2] * 32);
+        uint8_t *row0 = dest + data_index + y * 2 * pitch;
+        STORE512(row0, _mm512_permutex2var_epi64(q01, upper, q23));
+        STORE512(row0 + pitch, _mm512_permutex2var_epi64(q01, lower, q23));
+    }
+}
+
+// 16-byte blocks: a quad is a 64-byte vector.
+SWIZ_TARGET_AVX512
+static void copy_tile_ps4_16_avx512(const uint8_t *data, size_t data_index,
+                                    uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    for (int y = 0; y < 4; y++) {
+        const uint8_t *row0 = data + data_index + y * 2 * pitch;
+        const uint8_t *row1 = row0 + pitch;
+        uint8_t *quads = dest + dest_index + QUAD_ROW_PS4[y] * 64;
+        for (int x = 0; x < 4; x++) {
+            __m512i quad = JOIN256(LOAD256(row0 + x * 32), LOAD256(row1 + x * 32));
+            STORE512(quads + QUAD_COL_PS4[x] * 64, quad);
+        }
+    }
+}
+
+SWIZ_TARGET_AVX512
+static void copy_tile_inverse_ps4_16_avx512(const uint8_t *data, size_t data_index,
+                                            uint8_t *dest, size_t dest_index,
+                                            const TileContext *tc) {
+    int pitch = tc->pitch;
+    for (int y = 0; y < 4; y++) {
+        uint8_t *row0 = dest + data_index + y * 2 * pitch;
+        uint8_t *row1 = row0 + pitch;
+        const uint8_t *quads = data + dest_index + QUAD_ROW_PS4[y] * 64;
+        for (int x = 0; x < 4; x++) {
+            __m512i quad = LOAD512(quads + QUAD_COL_PS4[x] * 64);
+            STORE256(row0 + x * 32, _mm512_castsi512_si256(quad));
+            STORE256(row1 + x * 32, _mm512_extracti64x4_epi64(quad, 1));
+        }
+    }
+}
+
+#endif  // SWIZ_X86
+
+// switch swizzling functions
+
+/**
+ * A GOB of Switch is 4x8 blocks (512 bytes) when blocks are 16 bytes.
+ * Swizzled data consists of 64-byte chunks. Each chunk is 2x2 blocks.
+ *  0  2 | 16 18
+ *  1  3 | 17 19
+ *  -----+------
+ *  4  6 | 20 22
+ *  5  7 | 21 23
+ *  ...
+ * A chunk is 32 bytes from a row and 32 bytes from the next row,
+ * but columns come first in a chunk.
+ */
+
+#ifdef SWIZ_X86
+
+SWIZ_TARGET_SSE2
+static void copy_tile_switch_16_sse2(const uint8_t *data, size_t data_index,
+                                     uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    uint8_t *chunk = dest + dest_index;
+    for (int x = 0; x < 2; x++) {
+        for (int y = 0; y < 4; y++) {
+            const uint8_t *row0 = data + data_index + y * 2 * pitch + x * 32;
+            const uint8_t *row1 = row0 + pitch;
+            __m128i a0 = LOAD128(row0);
+            __m128i a1 = LOAD128(row0 + 16);
+            __m128i b0 = LOAD128(row1);
+            __m128i b1 = LOAD128(row1 + 16);
+            STORE128(chunk, a0);
+            STORE128(chunk + 16, b0);
+            STORE128(chunk + 32, a1);
+            STORE128(chunk + 48, b1);
+            chunk += 64;
+        }
+    }
+}
+
+SWIZ_TARGET_SSE2
+static void copy_tile_inverse_switch_16_sse2(const uint8_t *data, size_t data_index,
+                                             uint8_t *dest, size_t dest_index,
+                                             const TileContext *tc) {
+    int pitch = tc->pitch;
+    const uint8_t *chunk = data + dest_index;
+    for (int x = 0; x < 2; x++) {
+        for (int y = 0; y < 4; y++) {
+            uint8_t *row0 = dest + data_index + y * 2 * pitch + x * 32;
+            uint8_t *row1 = row0 + pitch;
+            __m128i a0 = LOAD128(chunk);
+            __m128i b0 = LOAD128(chunk + 16);
+            __m128i a1 = LOAD128(chunk + 32);
+            __m128i b1 = LOAD128(chunk + 48);
+            STORE128(row0, a0);
+            STORE128(row0 + 16, a1);
+            STORE128(row1, b0);
+            STORE128(row1 + 16, b1);
+            chunk += 64;
+        }
+    }
+}
+
+SWIZ_TARGET_AVX2
+static void copy_tile_switch_16_avx2(const uint8_t *data, size_t data_index,
+                                     uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    uint8_t *chunk = dest + dest_index;
+    for (int x = 0; x < 2; x++) {
+        for (int y = 0; y < 4; y++) {
+            const uint8_t *row0 = data + data_index + y * 2 * pitch + x * 32;
+            __m256i a = LOAD256(row0);
+            __m256i b = LOAD256(row0 + pitch);
+            STORE256(chunk, _mm256_permute2x128_si256(a, b, 0x20));
+            STORE256(chunk + 32, _mm256_permute2x128_si256(a, b, 0x31));
+            chunk += 64;
+        }
+    }
+}
+
+SWIZ_TARGET_AVX2
+static void copy_tile_inverse_switch_16_avx2(const uint8_t *data, size_t data_index,
+                                             uint8_t *dest, size_t dest_index,
+                                             const TileContext *tc) {
+    int pitch = tc->pitch;
+    const uint8_t *chunk = data + dest_index;
+    for (int x = 0; x < 2; x++) {
+        for (int y = 0; y < 4; y++) {
+            uint8_t *row0 = dest + data_index + y * 2 * pitch + x * 32;
+            __m256i lo = LOAD256(chunk);
+            __m256i hi = LOAD256(chunk + 32);
+            STORE256(row0, _mm256_permute2x128_si256(lo, hi, 0x20));
+            STORE256(row0 + pitch, _mm256_permute2x128_si256(lo, hi, 0x31));
+            chunk += 64;
+        }
+    }
+}
+
+// A chunk is a 64-byte vector. Swapping the middle 16-byte lanes makes columns come first.
+#define SWAP_MIDDLE_LANES(v) _mm512_shuffle_i64x2(v, v, _MM_SHUFFLE(3, 1, 2, 0))
+
+SWIZ_TARGET_AVX512
+static void copy_tile_switch_16_avx512(const uint8_t *data, size_t data_index,
+                                       uint8_t *dest, size_t dest_index, const TileContext *tc) {
+    int pitch = tc->pitch;
+    uint8_t *chunk = dest + dest_index;
+    for (int x = 0; x < 2; x++) {
+        for (int y = 0; y < 4; y++) {
+            const uint8_t *row0 = data + data_index + y * 2 * pitch + x * 32;
+            __m512i rows = JOIN256(LOAD256(row0), LOAD256(row0 + pitch));
+            STORE512(chunk, SWAP_MIDDLE_LANES(rows));
+            chunk += 64;
+        }
+    }
+}
+
+SWIZ_TARGET_AVX512
+static void copy_tile_inverse_switch_16_avx512(const uint8_t *data, size_t data_index,
+                                               uint8_t *dest, size_t dest_index,
+                                               const TileContext *tc) {
+    int pitch = tc->pitch;
+    const uint8_t *chunk = data + dest_index;
+    for (int x = 0; x < 2; x++) {
+        for (int y = 0; y < 4; y++) {
+            uint8_t *row0 = dest + data_index + y * 2 * pitch + x * 32;
+            __m512i rows = SWAP_MIDDLE_LANES(LOAD512(chunk));
+            STORE256(row0, _mm512_castsi512_si256(rows));
+            STORE256(row0 + pitch, _mm512_extracti64x4_epi64(rows, 1));
+            chunk += 64;
+        }
+    }
+}
+
+#endif  // SWIZ_X86
+
+CopyTileFuncPtr getCopyTileFuncPS4SIMD(int block_data_size, int swizzle,
+                                       SwizKernelVariant variant) {
+#ifdef SWIZ_X86
+    if (variant >= SWIZ_KERNEL_AVX512) {
+        if (block_data_size == 8)
+            return swizzle ? copy_tile_ps4_8_avx512 : copy_tile_inverse_ps4_8_avx512;
+        if (block_data_size == 16)
+            return swizzle ? copy_tile_ps4_16_avx512 : copy_tile_inverse_ps4_16_avx512;
+    }
+    if (variant >= SWIZ_KERNEL_AVX2) {
+        switch (block_data_size) {
+        case 4:
+            return swizzle ? copy_tile_ps4_4_avx2 : copy_tile_inverse_ps4_4_avx2;
+        case 8:
+            return swizzle ? copy_tile_ps4_8_avx2 : copy_tile_inverse_ps4_8_avx2;
+        case 16:
+            return swizzle ? copy_tile_ps4_16_avx2 : copy_tile_inverse_ps4_16_avx2;
+        default:
+            return NULL;
+        }
+    }
+    if (variant >= SWIZ_KERNEL_SSE2) {
+        switch (block_data_size) {
+        case 4:
+            return swizzle ? copy_tile_ps4_4_sse2 : copy_tile_inverse_ps4_4_sse2;
+        case 8:
+            return swizzle ? copy_tile_ps4_8_sse2 : copy_tile_inverse_ps4_8_sse2;
+        case 16:
+            return swizzle ? copy_tile_ps4_16_sse2 : copy_tile_inverse_ps4_16_sse2;
+        default:
+            return NULL;
+        }
+    }
+#endif
+    return NULL;
+}
+
+CopyTileFuncPtr getCopyTileFuncSwitchSIMD(int block_data_size, int swizzle,
+                                          SwizKernelVariant variant) {
+    // getSwizzleBlockSizeSwitch() makes most blocks 16 bytes.
+    if (block_data_size != 16)
+        return NULL;
+#ifdef SWIZ_X86
+    if (variant >= SWIZ_KERNEL_AVX512)
+        return swizzle ? copy_tile_switch_16_avx512 : copy_tile_inverse_switch_16_avx512;
+    if (variant >= SWIZ_KERNEL_AVX2)
+        return swizzle ? copy_tile_switch_16_avx2 : copy_tile_inverse_switch_16_avx2;
+    if (variant >= SWIZ_KERNEL_SSE2)
+        return swizzle ? copy_tile_switch_16_sse2 : copy_tile_inverse_switch_16_sse2;
+#endif
+    return NULL;
+}
+
+// cpu features
+
+SwizKernelVariant swizGetBestKernelVariant() {
+#if defined(SWIZ_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+    __cpuid(info, 1);
+    int has_sse2 = (info[3] >> 26) & 1;
+    int has_osxsave = (info[2] >> 27) & 1;
+    int has_avx2 = 0;
+    int has_avx512 = 0;
+    if (max_leaf >= 7 && has_osxsave) {
+        // The OS should save YMM (and ZMM) registers on context switches.
+        uint64_t xcr0 = _xgetbv(0);
+        __cpuidex(info, 7, 0);
+        has_avx2 = ((info[1] >> 5) & 1) && (xcr0 & 0x06) == 0x06;
+        has_avx512 = ((info[1] >> 16) & 1) && (xcr0 & 0xe6) == 0xe6;
+    }
+#elif defined(SWIZ_X86)
+    // The builtins also check the OS support for AVX registers.
+    __builtin_cpu_init();
+    int has_sse2 = __builtin_cpu_supports("sse2");
+    int has_avx2 = __builtin_cpu_supports("avx2");
+    int has_avx512 = __builtin_cpu_supports("avx512f");
+#endif
+#ifdef SWIZ_X86
+    if (has_avx512)
+        return SWIZ_KERNEL_AVX512;
+    if (has_avx2)
+        return SWIZ_KERNEL_AVX2;
+    if (has_sse2)
+        return SWIZ_KERNEL_SSE2;
+#endif
+    return SWIZ_KERNEL_SCALAR;
+}
+
+static const char *KERNEL_VARIANT_NAMES[SWIZ_KERNEL_MAX] = {
+    "auto", "scalar", "sse2", "avx2", "avx512"
+};
+
+SwizKernelVariant swizResolveKernelVariant(SwizKernelVariant variant) {
+    SwizKernelVariant best = swizGetBestKernelVariant();
+    if (variant == SWIZ_KERNEL_AUTO) {
+        // SWIZ_KERNEL_VARIANT=avx2 forces a variant for A/B testing.
+        const char *name = getenv("SWIZ_KERNEL_VARIANT");
+        if (name != NULL) {
+            for (int i = 0; i < SWIZ_KERNEL_MAX; i++) {
+                if (strcmp(name, KERNEL_VARIANT_NAMES[i]) == 0)
+                    variant = (SwizKernelVariant)i;
+            }
+        }
+    }
+    // Unknown or unsupported variants fall back to the best one.
+    if (variant == SWIZ_KERNEL_AUTO || variant > best)
+        return best;
+    return variant;
+}
@@ -0,0 +1,187 @@
+#include "priv.h"
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE SwizThread;
+typedef CRITICAL_SECTION SwizMutex;
+typedef CONDITION_VARIABLE SwizCond;
+#define MUTEX_INIT(m) InitializeCriticalSection(m)
+#define MUTEX_DESTROY(m) DeleteCriticalSection(m)
+#define MUTEX_LOCK(m) EnterCriticalSection(m)
+#define MUTEX_UNLOCK(m) LeaveCriticalSection(m)
+#define COND_INIT(c) InitializeConditionVariable(c)
+#define COND_DESTROY(c)
+#define COND_WAIT(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#define COND_BROADCAST(c) WakeAllConditionVariable(c)
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_t SwizThread;
+typedef pthread_mutex_t SwizMutex;
+typedef pthread_cond_t SwizCond;
+#define MUTEX_INIT(m) pthread_mutex_init(m, NULL)
+#define MUTEX_DESTROY(m) pthread_mutex_destroy(m)
+#define MUTEX_LOCK(m) pthread_mutex_lock(m)
+#define MUTEX_UNLOCK(m) pthread_mutex_unlock(m)
+#define COND_INIT(c) pthread_cond_init(c, NULL)
+#define COND_DESTROY(c) pthread_cond_destroy(c)
+#define COND_WAIT(c, m) pthread_cond_wait(c, m)
+#define COND_BROADCAST(c) pthread_cond_broadcast(c)
+#endif
+
+struct SwizThreadPool {
+    int thread_count;  // The requested number of threads including the caller
+    int worker_count;  // The number of threads that the pool created
+    SwizThread *workers;
+    SwizMutex mutex;
+    SwizCond work_cond;  // Signaled when tasks are added or the pool is freed
+    SwizCond done_cond;  // Signaled when all tasks are finished
+    SwizTaskFuncPtr func;  // NULL when there are no tasks
+    void *arg;
+    int task_count;
+    int next_task;
+    int finished_task_count;
+    int quit;
+};
+
+// Runs tasks until no tasks remain. The mutex should be locked.
+static void run_tasks(SwizThreadPool *pool) {
+    while (pool->func != NULL && pool->next_task < pool->task_count) {
+        SwizTaskFuncPtr func = pool->func;
+        void *arg = pool->arg;
+        int task_index = pool->next_task++;
+        MUTEX_UNLOCK(&pool->mutex);
+
+        func(arg, task_index);
+
+        MUTEX_LOCK(&pool->mutex);
+        pool->finished_task_count++;
+        if (pool->finished_task_count == pool->task_count)
+            COND_BROADCAST(&pool->done_cond);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_main(LPVOID arg) {
+#else
+static void *worker_main(void *arg) {
+#endif
+    SwizThreadPool *pool = (SwizThreadPool *)arg;
+    MUTEX_LOCK(&pool->mutex);
+    while (!pool->quit) {
+        run_tasks(pool);
+        if (!pool->quit)
+            COND_WAIT(&pool->work_cond, &pool->mutex);
+    }
+    MUTEX_UNLOCK(&pool->mutex);
+    return 0;
+}
+
+static int create_thread(SwizThread *thread, SwizThreadPool *pool) {
+#ifdef _WIN32
+    *thread = CreateThread(NULL, 0, worker_main, pool, 0, NULL);
+    return *thread != NULL;
+#else
+    return pthread_create(thread, NULL, worker_main, pool) == 0;
+#endif
+}
+
+static void join_thread(SwizThread thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+int swizGetCPUCount() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? count : 1;
+#endif
+}
+
+SwizThreadPool *swizNewThreadPool(int thread_count) {
+    SwizThreadPool *pool = (SwizThreadPool *)malloc(sizeof(SwizThreadPool));
+    if (pool == NULL)
+        return NULL;
+    pool->workers = NULL;
+    pool->worker_count = 0;
+    if (thread_count > 1) {
+        pool->workers = (SwizThread *)malloc(sizeof(SwizThread) * (thread_count - 1));
+        if (pool->workers == NULL) {
+            free(pool);
+            return NULL;
+        }
+    }
+    pool->thread_count = thread_count;
+    MUTEX_INIT(&pool->mutex);
+    COND_INIT(&pool->work_cond);
+    COND_INIT(&pool->done_cond);
+    pool->func = NULL;
+    pool->arg = NULL;
+    pool->task_count = 0;
+    pool->next_task = 0;
+    pool->finished_task_count = 0;
+    pool->quit = 0;
+
+    for (int i = 0; i < thread_count - 1; i++) {
+        if (!create_thread(&pool->workers[i], pool)) {
+            // Use the threads we could create.
+            break;
+        }
+        pool->worker_count++;
+    }
+    return pool;
+}
+
+void swizFreeThreadPool(SwizThreadPool *pool) {
+    if (pool == NULL)
+        return;
+    MUTEX_LOCK(&pool->mutex);
+    pool->quit = 1;
+    COND_BROADCAST(&pool->work_cond);
+    MUTEX_UNLOCK(&pool->mutex);
+    for (int i = 0; i < pool->worker_count; i++)
+        join_thread(pool->workers[i]);
+    COND_DESTROY(&pool->work_cond);
+    COND_DESTROY(&pool->done_cond);
+    MUTEX_DESTROY(&pool->mutex);
+    free(pool->workers);
+    free(pool);
+}
+
+int swizThreadPoolGetThreadCount(const SwizThreadPool *pool) {
+    return pool->thread_count;
+}
+
+void swizThreadPoolRun(SwizThreadPool *pool, int task_count,
+                       SwizTaskFuncPtr func, void *arg) {
+    if (pool == NULL || pool->worker_count == 0 || task_count <= 1) {
+        for (int i = 0; i < task_count; i++)
+            func(arg, i);
+        return;
+    }
+
+    MUTEX_LOCK(&pool->mutex);
+    pool->func = func;
+    pool->arg = arg;
+    pool->task_count = task_count;
+    pool->next_task = 0;
+    pool->finished_task_count = 0;
+    COND_BROADCAST(&pool->work_cond);
+
+    // The caller also runs tasks.
+    run_tasks(pool);
+    while (pool->finished_task_count < pool->task_count)
+        COND_WAIT(&pool->done_cond, &pool->mutex);
+
+    pool->func = NULL;
+    pool->arg = NULL;
+    MUTEX_UNLOCK(&pool->mutex);
+}
@@ -26,6 +26,20 @@ const char* swizGetErrorMessage(SwizError error) {
         return "Memory allocation error.";
     case SWIZ_ERROR_NULL_POINTER:
         return "De-referencing a null pointer.";
+    case SWIZ_ERROR_INVALID_THREAD_COUNT:
+        return "Thread count should be a non-negative number.";
+    case SWIZ_ERROR_UNSUPPORTED_KERNEL_VARIANT:
+        return "The CPU does not support the kernel variant.";
+    case SWIZ_ERROR_INVALID_ROW_COUNT:
+        return "The number of rows does not match the texture.";
+    case SWIZ_ERROR_STREAM_WRITE:
+        return "Failed to write swizzled data.";
+    case SWIZ_ERROR_INVALID_RECT:
+        return "The rectangle should be aligned to blocks and in the mipmap.";
+    case SWIZ_ERROR_OUT_OF_RANGE:
+        return "The position is out of the texture.";
+    case SWIZ_ERROR_SIZE_OVERFLOW:
+        return "The data size does not fit in 32 bits. Use 64-bit functions.";
     default:
         return "Unexpected error.";
     }
@@ -0,0 +1,362 @@
+// opendir, readdir, and mkdir are not in C99.
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "batch.h"
+#include "threads.h"
+#include "trace.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#endif
+
+// The max number of arguments in a manifest line.
+#define MAX_LINE_ARGS 5
+
+static char *copy_string(const char *str) {
+    size_t size = strlen(str) + 1;
+    char *copy = (char *)malloc(size);
+    if (copy != NULL)
+        memcpy(copy, str, size);
+    return copy;
+}
+
+// Joins a directory and a file name with a separator.
+static char *join_path(const char *dir, const char *name) {
+    size_t dir_len = strlen(dir);
+    size_t name_len = strlen(name);
+    char *path = (char *)malloc(dir_len + name_len + 2);
+    if (path == NULL)
+        return NULL;
+    memcpy(path, dir, dir_len);
+    if (dir_len > 0 && dir[dir_len - 1] != '/' && dir[dir_len - 1] != '\\')
+        path[dir_len++] = '/';
+    memcpy(path + dir_len, name, name_len + 1);
+    return path;
+}
+
+void initBatchList(BatchList *list) {
+    list->entries = NULL;
+    list->count = 0;
+    list->capacity = 0;
+    list->error_count = 0;
+}
+
+void freeBatchList(BatchList *list) {
+    for (int i = 0; i < list->count; i++) {
+        free((char *)list->entries[i].input_filename);
+        free((char *)list->entries[i].output_filename);
+    }
+    free(list->entries);
+    initBatchList(list);
+}
+
+// Adds an entry. The list takes ownership of the file names.
+static int add_entry(BatchList *list, const ConvertArgs *args,
+                     char *input_filename, char *output_filename) {
+    if (input_filename == NULL || output_filename == NULL) {
+        free(input_filename);
+        free(output_filename);
+        return 0;
+    }
+    if (list->count == list->capacity) {
+        int capacity = list->capacity == 0 ? 16 : list->capacity * 2;
+        ConvertArgs *entries =
+            (ConvertArgs *)realloc(list->entries, sizeof(ConvertArgs) * capacity);
+        if (entries == NULL) {
+            free(input_filename);
+            free(output_filename);
+            return 0;
+        }
+        list->entries = entries;
+        list->capacity = capacity;
+    }
+    ConvertArgs *entry = &list->entries[list->count];
+    *entry = *args;
+    entry->input_filename = input_filename;
+    entry->output_filename = output_filename;
+    list->count++;
+    return 1;
+}
+
+// Splits a line into arguments in place. Arguments can be quoted with double quotes.
+// Returns the number of arguments, or -1 when the line is invalid.
+static int split_line(char *line, char *args[MAX_LINE_ARGS]) {
+    int count = 0;
+    char *p = line;
+    while (1) {
+        while (isspace((unsigned char)*p))
+            p++;
+        if (*p == '\0')
+            break;
+        if (count == MAX_LINE_ARGS)
+            return -1;
+        if (*p == '"') {
+            p++;
+            args[count++] = p;
+            while (*p != '"' && *p != '\0')
+                p++;
+            if (*p == '\0')
+                return -1;  // Unclosed quote
+            *p++ = '\0';
+            if (*p != '\0' && !isspace((unsigned char)*p))
+                return -1;
+        } else {
+            args[count++] = p;
+            while (*p != '\0' && !isspace((unsigned char)*p))
+                p++;
+            if (*p == '\0')
+                break;
+            *p++ = '\0';
+        }
+    }
+    return count;
+}
+
+// Parses arguments of a manifest line. Returns an error message, or NULL.
+static const char *parse_line_args(int argc, char *argv[], ConvertArgs *args) {
+    if (argc < 3)
+        return "Too few arguments.";
+    if (argc > MAX_LINE_ARGS)
+        return "Too many arguments.";
+    if (!parseCommand(argv[0], &args->swizzle))
+        return "Unknown command.";
+    const char *invalid_arg;
+    return parseTarget(argc - 3, argv + 3, args, &invalid_arg);
+}
+
+int loadBatchManifest(BatchList *list, const char *filename) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL)
+        return 0;
+
+    char *line;
+    int line_number = 0;
+    while ((line = readLine(file)) != NULL) {
+        line_number++;
+        char *argv[MAX_LINE_ARGS];
+        int argc = split_line(line, argv);
+        if (argc == 0 || (argc > 0 && argv[0][0] == '#')) {
+            free(line);
+            continue;
+        }
+
+        ConvertArgs args;
+        const char *error = argc < 0 ? "Invalid quotes or too many arguments." :
+                                       parse_line_args(argc, argv, &args);
+        if (error == NULL &&
+            !add_entry(list, &args, copy_string(argv[1]), copy_string(argv[2])))
+            error = "Memory allocation error.";
+        if (error != NULL) {
+            printf("Failed: %s:%d (%s)\n", filename, line_number, error);
+            list->error_count++;
+        }
+        free(line);
+    }
+    fclose(file);
+    return 1;
+}
+
+// Returns non-zero if the file name ends with ".dds". It's case-insensitive.
+static int has_dds_extension(const char *name) {
+    size_t len = strlen(name);
+    if (len <= 4)
+        return 0;
+    const char *ext = name + len - 4;
+    return ext[0] == '.' && tolower((unsigned char)ext[1]) == 'd' &&
+           tolower((unsigned char)ext[2]) == 'd' && tolower((unsigned char)ext[3]) == 's';
+}
+
+static int compare_entries(const void *a, const void *b) {
+    return strcmp(((const ConvertArgs *)a)->input_filename,
+                  ((const ConvertArgs *)b)->input_filename);
+}
+
+static void add_dds_file(BatchList *list, const char *name, const char *input_dir,
+                         const char *output_dir, const ConvertArgs *args) {
+    if (!has_dds_extension(name))
+        return;
+    if (!add_entry(list, args, join_path(input_dir, name), join_path(output_dir, name))) {
+        printf("Failed: %s (Memory allocation error.)\n", name);
+        list->error_count++;
+    }
+}
+
+#ifdef _WIN32
+
+static int make_directory(const char *dir) {
+    if (_mkdir(dir) == 0)
+        return 1;
+    DWORD attributes = GetFileAttributesA(dir);
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+static int add_dds_files(BatchList *list, const char *input_dir, const char *output_dir,
+                         const ConvertArgs *args) {
+    char *pattern = join_path(input_dir, "*");
+    if (pattern == NULL)
+        return 0;
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA(pattern, &data);
+    free(pattern);
+    if (find == INVALID_HANDLE_VALUE)
+        return 0;
+    do {
+        if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+            add_dds_file(list, data.cFileName, input_dir, output_dir, args);
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+    return 1;
+}
+
+#else  // _WIN32
+
+static int make_directory(const char *dir) {
+    return mkdir(dir, 0755) == 0 || errno == EEXIST;
+}
+
+static int add_dds_files(BatchList *list, const char *input_dir, const char *output_dir,
+                         const ConvertArgs *args) {
+    DIR *dir = opendir(input_dir);
+    if (dir == NULL)
+        return 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL)
+        add_dds_file(list, entry->d_name, input_dir, output_dir, args);
+    closedir(dir);
+    return 1;
+}
+
+#endif  // _WIN32
+
+int loadBatchDirectory(BatchList *list, const char *input_dir, const char *output_dir,
+                       const ConvertArgs *args) {
+    int first = list->count;
+    if (!add_dds_files(list, input_dir, output_dir, args))
+        return 0;
+    if (list->count > first && !make_directory(output_dir)) {
+        printf("Failed to make the output directory. (%s)\n", output_dir);
+        return 0;
+    }
+    // Directory entries are not sorted. Sort them to make the order stable.
+    qsort(list->entries + first, list->count - first, sizeof(ConvertArgs), compare_entries);
+    return 1;
+}
+
+// States that workers share while converting a list.
+typedef struct Batch {
+    const BatchList *list;
+    PlanCache cache;
+    Mutex mutex;  // Guards the fields below and the output of failures
+    int next_entry;
+    int failed;
+    uint64_t input_size;
+    uint64_t output_size;
+} Batch;
+
+static void convert_file(Batch *batch, const ConvertArgs *args) {
+    ConvertJob job;
+    if (beginConvertJob(&job, args, &batch->cache))
+        runConvertJob(&job);
+    // Sizes are cleared when files are unmapped.
+    uint64_t input_size = job.error == NULL ? job.input.size : 0;
+    uint64_t output_size = job.error == NULL ? job.output.size : 0;
+    endConvertJob(&job);
+
+    MUTEX_LOCK(&batch->mutex);
+    if (job.error == NULL) {
+        batch->input_size += input_size;
+        batch->output_size += output_size;
+    } else {
+        printf("Failed: %s (%s)\n", args->input_filename, job.error);
+        batch->failed++;
+    }
+    MUTEX_UNLOCK(&batch->mutex);
+}
+
+// Takes files from the list until all files are taken.
+static void convert_files(void *arg) {
+    Batch *batch = (Batch *)arg;
+    while (1) {
+        MUTEX_LOCK(&batch->mutex);
+        int index = batch->next_entry < batch->list->count ? batch->next_entry++ : -1;
+        MUTEX_UNLOCK(&batch->mutex);
+        if (index < 0)
+            break;
+        convert_file(batch, &batch->list->entries[index]);
+    }
+}
+
+static void worker_main(void *arg) {
+    setTraceThreadName("worker");
+    convert_files(arg);
+}
+
+int runBatch(const BatchList *list, int thread_count) {
+    int worker_count = thread_count > 0 ? thread_count : getProcessorCount();
+    if (worker_count > list->count)
+        worker_count = list->count > 0 ? list->count : 1;
+    Batch *batch = (Batch *)malloc(sizeof(Batch));
+    Thread *workers = (Thread *)malloc(sizeof(Thread) * worker_count);
+    if (batch == NULL || workers == NULL) {
+        printf("Memory allocation error.\n");
+        free(batch);
+        free(workers);
+        return list->count + list->error_count;
+    }
+    batch->list = list;
+    initPlanCache(&batch->cache);
+    MUTEX_INIT(&batch->mutex);
+    batch->next_entry = 0;
+    batch->failed = 0;
+    batch->input_size = 0;
+    batch->output_size = 0;
+    if (thread_count > 0)
+        printf("Converting %d files with %d threads...\n", list->count, thread_count);
+    else
+        printf("Converting %d files with all processors...\n", list->count);
+
+    // Each worker maps, converts, and unmaps a file at a time, so I/O of a file overlaps
+    // with conversions of others. The calling thread is also a worker.
+    // When a thread can't be created, the other workers take its files.
+    double start = getTime();
+    int thread_created = 0;
+    for (int i = 1; i < worker_count; i++) {
+        if (!createThread(&workers[thread_created], worker_main, batch))
+            break;
+        thread_created++;
+    }
+    convert_files(batch);
+    for (int i = 0; i < thread_created; i++)
+        joinThread(workers[i]);
+    double elapsed = getTime() - start;
+
+    int failed = batch->failed;
+    uint64_t input_size = batch->input_size;
+    uint64_t output_size = batch->output_size;
+    freePlanCache(&batch->cache);
+    MUTEX_DESTROY(&batch->mutex);
+    free(batch);
+    free(workers);
+
+    // Avoid division by zero for empty lists.
+    double seconds = elapsed > 0 ? elapsed : 1e-9;
+    double input_mib = (double)input_size / (1024 * 1024);
+    double output_mib = (double)output_size / (1024 * 1024);
+    int succeeded = list->count - failed;
+    failed += list->error_count;
+    printf("Converted %d files. (%d failed)\n", succeeded, failed);
+    printf("Time: %.3f s (%.1f files/s)\n", elapsed, succeeded / seconds);
+    printf("Read: %.1f MiB (%.1f MiB/s)\n", input_mib, input_mib / seconds);
+    printf("Written: %.1f MiB (%.1f MiB/s)\n", output_mib, output_mib / seconds);
+    return failed;
+}
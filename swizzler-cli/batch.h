@@ -0,0 +1,34 @@
+#ifndef __SWIZZLER_CLI_BATCH_H__
+#define __SWIZZLER_CLI_BATCH_H__
+#include "convert.h"
+
+// A list of files to convert.
+typedef struct BatchList {
+    ConvertArgs *entries;
+    int count;
+    int capacity;
+    int error_count;  // The number of entries that could not be added
+} BatchList;
+
+void initBatchList(BatchList *list);
+
+// Frees entries and their file names.
+void freeBatchList(BatchList *list);
+
+// Adds entries from a manifest file.
+// Each line should be "<command> <input> <output> [<platform> [<gobs_height>]]".
+// Paths with spaces should be quoted. Empty lines and lines starting with # are ignored.
+// Invalid lines are reported and counted as errors. Returns zero if it can't read the file.
+int loadBatchManifest(BatchList *list, const char *filename);
+
+// Adds all dds files in a directory. Outputs will have the same names in output_dir.
+// Returns zero if it can't read the directory.
+int loadBatchDirectory(BatchList *list, const char *input_dir, const char *output_dir,
+                       const ConvertArgs *args);
+
+// Converts files on worker threads and prints a summary.
+// Failures are reported for each file and don't stop the run.
+// Returns the number of failed files including errors of the list.
+int runBatch(const BatchList *list, int thread_count);
+
+#endif  // __SWIZZLER_CLI_BATCH_H__
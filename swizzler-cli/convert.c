@@ -0,0 +1,402 @@
+// clock_gettime is not in C99.
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "convert.h"
+#include "trace.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+int parseCommand(const char *str, int *swizzle) {
+    if (strcmp(str, "swizzle") == 0) {
+        *swizzle = 1;
+    } else if (strcmp(str, "unswizzle") == 0) {
+        *swizzle = 0;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+int parsePlatform(const char *str, SwizPlatform *platform) {
+    if (strcmp(str, "ps4") == 0) {
+        *platform = SWIZ_PLATFORM_PS4;
+    } else if (strcmp(str, "switch") == 0) {
+        *platform = SWIZ_PLATFORM_SWITCH;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+int parseGobsHeight(const char *str, int *gobs_height) {
+    const char *values[] = { "1", "2", "4", "8", "16", "32" };
+    for (int i = 0; i < 6; i++) {
+        if (strcmp(str, values[i]) == 0) {
+            *gobs_height = 1 << i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+const char *parseTarget(int argc, char *argv[], ConvertArgs *args, const char **invalid_arg) {
+    args->platform = SWIZ_PLATFORM_PS4;
+    if (argc >= 1 && !parsePlatform(argv[0], &args->platform)) {
+        *invalid_arg = argv[0];
+        return "Unknown platform.";
+    }
+    args->gobs_height = 16;
+    if (argc >= 2 && args->platform == SWIZ_PLATFORM_SWITCH &&
+        !parseGobsHeight(argv[1], &args->gobs_height)) {
+        *invalid_arg = argv[1];
+        return "The max height of GOB blocks should be 1, 2, 4, 8, 16, or 32.";
+    }
+    return NULL;
+}
+
+int getDDSArraySize(dds_image_t image) {
+    int array_size = 1;
+    int is_cube = (image->header.caps2 & DDSCAPS2_CUBEMAP) != 0;
+    if ((image->header.pixel_format.flags & DDPF_FOURCC) &&
+        image->header.pixel_format.four_cc == 0x30315844) {  // FOURCC("DX10")
+        // Old writers store zero for non-array textures.
+        // Too large values are left invalid for swizContextSetArraySize().
+        if (image->header10.array_size > INT_MAX / 6)
+            return -1;
+        if (image->header10.array_size > 1)
+            array_size = (int)image->header10.array_size;
+        is_cube |= (image->header10.misc_flag & DDS_RESOURCE_MISC_TEXTURECUBE) != 0;
+    }
+    return is_cube ? array_size * 6 : array_size;
+}
+
+SwizContext *newContextForDDS(dds_image_t image, SwizPlatform platform, int gobs_height) {
+    int block_width, block_height, block_data_size;
+    dds_get_block_info(image, &block_width, &block_height, &block_data_size);
+    if (block_data_size == 0)
+        return NULL;
+
+    SwizContext *context = swizNewContext();
+    swizContextSetPlatform(context, platform);
+    swizContextSetTextureSize(context, image->header.width, image->header.height);
+    swizContextSetGobsHeight(context, gobs_height);
+    swizContextSetHasMips(context, image->header.mipmap_count > 1);
+    swizContextSetBlockInfo(context, block_width, block_height, block_data_size);
+    swizContextSetArraySize(context, getDDSArraySize(image));
+    return context;
+}
+
+void initPlanCache(PlanCache *cache) {
+    cache->count = 0;
+    MUTEX_INIT(&cache->mutex);
+}
+
+void freePlanCache(PlanCache *cache) {
+    for (int i = 0; i < cache->count; i++)
+        swizFreePlan(cache->entries[i].plan);
+    cache->count = 0;
+    MUTEX_DESTROY(&cache->mutex);
+}
+
+// Gets a plan for a dds. The job owns the plan when the cache is NULL or full.
+// Plans are never evicted, so jobs can use them until the cache is freed.
+// The mutex of the cache should be locked.
+static SwizPlan *find_plan(ConvertJob *job, dds_image_t image, PlanCache *cache) {
+    int block_width, block_height, block_data_size;
+    dds_get_block_info(image, &block_width, &block_height, &block_data_size);
+    int has_mips = image->header.mipmap_count > 1;
+    int array_size = getDDSArraySize(image);
+    struct PlanCacheEntry *entry = NULL;
+    if (cache != NULL) {
+        for (int i = 0; i < cache->count; i++) {
+            entry = &cache->entries[i];
+            if (entry->platform == job->args.platform &&
+                entry->width == (int)image->header.width &&
+                entry->height == (int)image->header.height &&
+                entry->gobs_height == job->args.gobs_height &&
+                entry->has_mips == has_mips && entry->array_size == array_size &&
+                entry->block_width == block_width &&
+                entry->block_height == block_height &&
+                entry->block_data_size == block_data_size) {
+                job->owns_plan = 0;
+                return entry->plan;
+            }
+        }
+        entry = cache->count < PLAN_CACHE_SIZE ? &cache->entries[cache->count] : NULL;
+    }
+
+    SwizContext *context = newContextForDDS(image, job->args.platform, job->args.gobs_height);
+    if (context == NULL) {
+        job->error = "Unsupported pixel format.";
+        return NULL;
+    }
+    SwizPlan *plan = swizNewPlan(context);
+    swizFreeContext(context);
+    if (plan == NULL) {
+        job->error = "Failed to calculate data size.";
+        return NULL;
+    }
+
+    if (entry == NULL) {
+        job->owns_plan = 1;
+        return plan;
+    }
+    entry->platform = job->args.platform;
+    entry->width = (int)image->header.width;
+    entry->height = (int)image->header.height;
+    entry->gobs_height = job->args.gobs_height;
+    entry->has_mips = has_mips;
+    entry->array_size = array_size;
+    entry->block_width = block_width;
+    entry->block_height = block_height;
+    entry->block_data_size = block_data_size;
+    entry->plan = plan;
+    cache->count++;
+    job->owns_plan = 0;
+    return plan;
+}
+
+static SwizPlan *get_plan(ConvertJob *job, dds_image_t image, PlanCache *cache) {
+    if (cache == NULL)
+        return find_plan(job, image, NULL);
+    MUTEX_LOCK(&cache->mutex);
+    SwizPlan *plan = find_plan(job, image, cache);
+    MUTEX_UNLOCK(&cache->mutex);
+    return plan;
+}
+
+static uint64_t get_data_size(const SwizPlan *plan, int swizzle) {
+    if (swizzle)
+        return swizPlanGetUnswizzledSize64(plan);
+    return swizPlanGetSwizzledSize64(plan);
+}
+
+static uint64_t get_new_data_size(const SwizPlan *plan, int swizzle) {
+    if (swizzle)
+        return swizPlanGetSwizzledSize64(plan);
+    return swizPlanGetUnswizzledSize64(plan);
+}
+
+static void init_job(ConvertJob *job, const ConvertArgs *args) {
+    job->args = *args;
+    job->input.data = NULL;
+    job->output.data = NULL;
+    job->plan = NULL;
+    job->owns_plan = 0;
+    job->header_size = 0;
+    job->error = NULL;
+}
+
+int beginConvertJob(ConvertJob *job, const ConvertArgs *args, PlanCache *cache) {
+    init_job(job, args);
+    if (strcmp(args->input_filename, args->output_filename) == 0) {
+        job->error = "The output file should be different from the input file.";
+        return 0;
+    }
+
+    // Swizzle the mapped input into the mapped output.
+    // The OS pages data in and out, so we don't need copies of the texture in the heap.
+    double start = getTime();
+    if (!mapFileForRead(&job->input, args->input_filename)) {
+        job->error = "Failed to load dds.";
+        return 0;
+    }
+    double load_end = getTime();
+    traceSpan("load", start, load_end, args->input_filename);
+    struct dds_image image;
+    size_t header_size = dds_parse_header(&image, job->input.data, job->input.size);
+    if (header_size == 0) {
+        job->error = "Failed to load dds.";
+        return 0;
+    }
+    double parse_end = getTime();
+    traceSpan("parse header", load_end, parse_end, NULL);
+
+    job->plan = get_plan(job, &image, cache);
+    if (job->plan == NULL)
+        return 0;
+    double setup_end = getTime();
+    traceSpan("context setup", parse_end, setup_end, NULL);
+
+    // Textures can be larger than 4 GiB. So, we don't use pixels_size (long) here.
+    uint64_t data_size = get_data_size(job->plan, args->swizzle);
+    uint64_t new_data_size = get_new_data_size(job->plan, args->swizzle);
+    if (data_size == 0 || job->input.size - header_size < data_size ||
+        new_data_size > SIZE_MAX - header_size) {
+        job->error = "Failed to calculate data size.";
+        return 0;
+    }
+
+    if (!mapFileForWrite(&job->output, args->output_filename,
+                         (size_t)(header_size + new_data_size))) {
+        job->error = "Failed to save a dds file.";
+        return 0;
+    }
+    dds_write_header(&image, job->output.data);
+    job->header_size = header_size;
+    traceSpan("create output", setup_end, getTime(), args->output_filename);
+    return 1;
+}
+
+// Max size of input and output data of a chunk when a job is converted in chunks.
+// Chunks are split into stripes for the threads, so it's large enough to keep them busy.
+#define RESIDENT_CHUNK_SIZE ((size_t)64 << 20)
+
+// Converts a job chunk by chunk on the threads of the context.
+// When the context is NULL, the plan of the job converts chunks on the calling thread.
+// Chunks are in the order of offsets. So, pages before a chunk are released after it.
+// Each chunk gets a span when tracing.
+static void convert_in_chunks(ConvertJob *job, SwizContext *context) {
+    int chunk_count;
+    SwizError ret = SWIZ_OK;
+    if (context != NULL) {
+        chunk_count = swizGetChunkCount(context, RESIDENT_CHUNK_SIZE);
+        ret = swizContextGetLastError(context);
+    } else {
+        chunk_count = swizPlanGetChunkCount(job->plan, RESIDENT_CHUNK_SIZE);
+    }
+
+    const uint8_t *src = job->input.data + job->header_size;
+    uint8_t *dst = job->output.data + job->header_size;
+    for (int i = 0; i < chunk_count && ret == SWIZ_OK; i++) {
+        SwizChunk chunk;
+        if (context != NULL)
+            ret = swizGetChunk(context, RESIDENT_CHUNK_SIZE, i, &chunk);
+        else
+            ret = swizPlanGetChunk(job->plan, RESIDENT_CHUNK_SIZE, i, &chunk);
+        if (ret != SWIZ_OK)
+            break;
+        uint64_t data_end = chunk.data_offset + chunk.data_size;
+        uint64_t swizzled_end = chunk.swizzled_offset + chunk.swizzled_size;
+        double start = getTime();
+        if (job->args.swizzle) {
+            const uint8_t *data = src + chunk.data_offset;
+            uint8_t *swizzled = dst + chunk.swizzled_offset;
+            if (context != NULL)
+                ret = swizDoSwizzleChunk(data, swizzled, &chunk, context);
+            else
+                ret = swizPlanDoSwizzleChunk(data, swizzled, &chunk, job->plan);
+            releaseMappedPages(&job->input, job->header_size + (size_t)data_end);
+            releaseMappedPages(&job->output, job->header_size + (size_t)swizzled_end);
+        } else {
+            const uint8_t *data = src + chunk.swizzled_offset;
+            uint8_t *unswizzled = dst + chunk.data_offset;
+            if (context != NULL)
+                ret = swizDoUnswizzleChunk(data, unswizzled, &chunk, context);
+            else
+                ret = swizPlanDoUnswizzleChunk(data, unswizzled, &chunk, job->plan);
+            releaseMappedPages(&job->input, job->header_size + (size_t)swizzled_end);
+            releaseMappedPages(&job->output, job->header_size + (size_t)data_end);
+        }
+        if (isTracing()) {
+            traceSubresourceSpan(job->args.swizzle ? "swizzle" : "unswizzle", start, getTime(),
+                                 chunk.mip, chunk.slice, chunk.swizzled_size);
+        }
+    }
+    if (ret != SWIZ_OK)
+        job->error = swizGetErrorMessage(ret);
+}
+
+void runConvertJob(ConvertJob *job) {
+    if (job->error == NULL)
+        convert_in_chunks(job, NULL);
+}
+
+void runConvertJobInChunks(ConvertJob *job, int thread_count) {
+    if (job->error != NULL)
+        return;
+
+    // The plan of the job has no threads. So, we make a context for the same layout.
+    struct dds_image image;
+    dds_parse_header(&image, job->input.data, job->input.size);
+    SwizContext *context = newContextForDDS(&image, job->args.platform, job->args.gobs_height);
+    if (context == NULL) {
+        job->error = "Unsupported pixel format.";
+        return;
+    }
+    swizContextSetThreadCount(context, thread_count);
+    convert_in_chunks(job, context);
+    swizFreeContext(context);
+}
+
+void endConvertJob(ConvertJob *job) {
+    if (job->input.data != NULL)
+        unmapFile(&job->input);
+    if (job->output.data != NULL) {
+        double start = getTime();
+        unmapFile(&job->output);
+        if (job->error != NULL)
+            remove(job->args.output_filename);
+        else
+            traceSpan("save", start, getTime(), job->args.output_filename);
+    }
+    if (job->owns_plan)
+        swizFreePlan(job->plan);
+    job->plan = NULL;
+}
+
+char *readLine(FILE *file) {
+    size_t size = 0;
+    size_t capacity = 256;
+    char *line = (char *)malloc(capacity);
+    if (line == NULL)
+        return NULL;
+    int c;
+    while ((c = fgetc(file)) != EOF && c != '\n') {
+        if (size + 1 == capacity) {
+            char *new_line = (char *)realloc(line, capacity * 2);
+            if (new_line == NULL) {
+                free(line);
+                return NULL;
+            }
+            line = new_line;
+            capacity *= 2;
+        }
+        line[size++] = (char)c;
+    }
+    if (c == EOF && size == 0) {
+        free(line);
+        return NULL;
+    }
+    // Remove CR of CRLF.
+    if (size > 0 && line[size - 1] == '\r')
+        size--;
+    line[size] = '\0';
+    return line;
+}
+
+void writeJsonString(FILE *output, const char *str) {
+    fputc('"', output);
+    for (; *str != '\0'; str++) {
+        unsigned char c = (unsigned char)*str;
+        if (c == '"' || c == '\\')
+            fprintf(output, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(output, "\\u%04x", c);
+        else
+            fputc(c, output);
+    }
+    fputc('"', output);
+}
+
+double getTime(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
@@ -0,0 +1,105 @@
+#ifndef __SWIZZLER_CLI_CONVERT_H__
+#define __SWIZZLER_CLI_CONVERT_H__
+#include <stdio.h>
+#include "console-swizzler.h"
+#include "dds.h"
+#include "mapped_file.h"
+#include "threads.h"
+
+// Settings to convert a dds file.
+typedef struct ConvertArgs {
+    int swizzle;  // Non-zero for swizzling, zero for unswizzling
+    const char *input_filename;
+    const char *output_filename;
+    SwizPlatform platform;
+    int gobs_height;
+} ConvertArgs;
+
+// Parses "swizzle" or "unswizzle". Returns zero for unknown commands.
+int parseCommand(const char *str, int *swizzle);
+
+// Parses "ps4" or "switch". Returns zero for unknown platforms.
+int parsePlatform(const char *str, SwizPlatform *platform);
+
+// Parses the max height of GOB blocks. Returns zero for unsupported values.
+int parseGobsHeight(const char *str, int *gobs_height);
+
+// Parses the optional platform and gobs_height arguments. gobs_height is ignored for ps4.
+// Returns an error message, or NULL. The invalid argument will be stored in *invalid_arg.
+const char *parseTarget(int argc, char *argv[], ConvertArgs *args, const char **invalid_arg);
+
+// DDS_RESOURCE_MISC_TEXTURECUBE of dds_header_dxt10::misc_flag
+#define DDS_RESOURCE_MISC_TEXTURECUBE 0x4
+
+// Gets the number of slices in a dds. A cubemap has 6 faces for each element.
+int getDDSArraySize(dds_image_t image);
+
+// Makes a context for a dds. Returns NULL when the pixel format is unsupported.
+SwizContext *newContextForDDS(dds_image_t image, SwizPlatform platform, int gobs_height);
+
+// The max number of plans in a cache.
+#define PLAN_CACHE_SIZE 64
+
+// Plans for texture layouts that have been converted.
+// Files of the same layout reuse a plan, so the layout is calculated only once.
+// Threads can share a cache.
+typedef struct PlanCache {
+    struct PlanCacheEntry {
+        SwizPlatform platform;
+        int width;
+        int height;
+        int gobs_height;
+        int has_mips;
+        int array_size;
+        int block_width;
+        int block_height;
+        int block_data_size;
+        SwizPlan *plan;
+    } entries[PLAN_CACHE_SIZE];
+    int count;
+    Mutex mutex;
+} PlanCache;
+
+void initPlanCache(PlanCache *cache);
+
+// Frees all plans in the cache. The cache can't be used after it.
+void freePlanCache(PlanCache *cache);
+
+// A dds file that is converted from a memory-mapped file to another.
+typedef struct ConvertJob {
+    ConvertArgs args;
+    MappedFile input;
+    MappedFile output;
+    SwizPlan *plan;
+    int owns_plan;  // Zero if the plan is in a cache
+    size_t header_size;  // Offset of pixels in both files
+    const char *error;  // Error message. NULL if the job has no errors.
+} ConvertJob;
+
+// Maps the input file, and creates the output file with the dds header.
+// The plan will be taken from the cache if it's not NULL.
+// Returns zero and sets job->error when it failed.
+int beginConvertJob(ConvertJob *job, const ConvertArgs *args, PlanCache *cache);
+
+// Converts pixels of a job chunk by chunk on the calling thread with the plan of the job.
+// Pages of both files are released behind the chunks like runConvertJobInChunks().
+void runConvertJob(ConvertJob *job);
+
+// Converts pixels of a single job chunk by chunk on the threads.
+// Pages of both files are released behind the chunks, so the RSS stays around the chunk size.
+void runConvertJobInChunks(ConvertJob *job, int thread_count);
+
+// Unmaps the files. The output file will be removed when the job has an error.
+void endConvertJob(ConvertJob *job);
+
+// Reads a line of any length without the line break. Returns NULL at the end of the file.
+// The line should be freed with free().
+char *readLine(FILE *file);
+
+// Writes a string as a JSON string literal.
+void writeJsonString(FILE *output, const char *str);
+
+// Gets the time in seconds from a monotonic clock.
+double getTime(void);
+
+#endif  // __SWIZZLER_CLI_CONVERT_H__
@@ -2,6 +2,7 @@
 
 #include "dds.h"
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -226,52 +227,99 @@ void dds_get_block_info(dds_image_t image, int *block_width, int *block_height,
     return;
 }
 
-dds_image_t dds_load_from_memory(const char* data, long data_length)
+size_t dds_parse_header(dds_image_t image, const dds_byte* data, size_t data_length)
 {
-    const char* data_loc = data;
+    const dds_byte* data_loc = data;
+
+    if (data_length < 4 + sizeof(struct dds_header))
+        return 0;
 
     dds_uint magic = 0x00;
     memcpy(&magic, data_loc, sizeof(magic));
     data_loc += 4;
 
     if (magic != 0x20534444) // 'DDS '
-        return NULL;
-
-    dds_image_t ret = (dds_image_t)malloc(sizeof(struct dds_image));
+        return 0;
 
     // read the header
-    memcpy(&ret->header, data_loc, sizeof(struct dds_header));
+    memcpy(&image->header, data_loc, sizeof(struct dds_header));
     data_loc += sizeof(struct dds_header);
 
     // check if the dds_header::dwSize (must be equal to 124)
-    if (ret->header.size != 124) {
-        dds_image_free(ret);
-        return NULL;
-    }
+    if (image->header.size != 124)
+        return 0;
 
     // check the dds_header::flags (DDSD_CAPS, DDSD_HEIGHT, DDSD_WIDTH, DDSD_PIXELFORMAT must be set)
-    if (!((ret->header.flags & DDSD_CAPS) && (ret->header.flags & DDSD_HEIGHT) && (ret->header.flags & DDSD_WIDTH) && (ret->header.flags & DDSD_PIXELFORMAT))) {
-        dds_image_free(ret);
-        return NULL;
-    }
+    if (!((image->header.flags & DDSD_CAPS) && (image->header.flags & DDSD_HEIGHT) && (image->header.flags & DDSD_WIDTH) && (image->header.flags & DDSD_PIXELFORMAT)))
+        return 0;
 
     // check the dds_header::caps
-    if ((ret->header.caps & DDSCAPS_TEXTURE) == 0) {
-        dds_image_free(ret);
-        return NULL;
-    }
+    if ((image->header.caps & DDSCAPS_TEXTURE) == 0)
+        return 0;
 
     // check if we need to load dds_header_dxt10
-    if ((ret->header.pixel_format.flags & DDPF_FOURCC) && ret->header.pixel_format.four_cc == FOURCC("DX10")) {
+    memset(&image->header10, 0, sizeof(struct dds_header_dxt10));
+    if ((image->header.pixel_format.flags & DDPF_FOURCC) && image->header.pixel_format.four_cc == FOURCC("DX10")) {
+        if (data_length < (size_t)(data_loc - data) + sizeof(struct dds_header_dxt10))
+            return 0;
         // read the header10
-        memcpy(&ret->header10, data_loc, sizeof(struct dds_header_dxt10));
+        memcpy(&image->header10, data_loc, sizeof(struct dds_header_dxt10));
         data_loc += sizeof(struct dds_header_dxt10);
     }
 
+    // pixels are not loaded here
+    image->pixels = NULL;
+    // pixels_size is clamped when long can't hold it. Use data_length for large files.
+    size_t header_size = (size_t)(data_loc - data);
+    size_t pixels_size = data_length - header_size;
+    image->pixels_size = pixels_size > LONG_MAX ? LONG_MAX : (long)pixels_size;
+
+    return header_size;
+}
+
+long dds_get_header_size(dds_image_t image)
+{
+    long size = 4 + sizeof(struct dds_header);
+    if ((image->header.pixel_format.flags & DDPF_FOURCC) && image->header.pixel_format.four_cc == FOURCC("DX10"))
+        size += sizeof(struct dds_header_dxt10);
+    return size;
+}
+
+void dds_write_header(dds_image_t image, dds_byte* dest)
+{
+    dds_uint magic = 0x20534444;
+    memcpy(dest, &magic, sizeof(magic));
+    dest += sizeof(magic);
+    memcpy(dest, &image->header, sizeof(struct dds_header));
+    dest += sizeof(struct dds_header);
+
+    if ((image->header.pixel_format.flags & DDPF_FOURCC) && image->header.pixel_format.four_cc == FOURCC("DX10"))
+        memcpy(dest, &image->header10, sizeof(struct dds_header_dxt10));
+}
+
+dds_image_t dds_load_from_memory(const char* data, long data_length)
+{
+    dds_image_t ret = (dds_image_t)malloc(sizeof(struct dds_image));
+    if (ret == NULL)
+        return NULL;
+
+    if (data_length < 0) {
+        free(ret);
+        return NULL;
+    }
+    size_t header_size = dds_parse_header(ret, (const dds_byte*)data, (size_t)data_length);
+    if (header_size == 0) {
+        free(ret);
+        return NULL;
+    }
+
     // allocate pixel data
-    ret->pixels_size = data_length - (long)(data_loc - data);
     ret->pixels = (dds_byte*)malloc(ret->pixels_size);
-    memcpy(ret->pixels, data_loc, ret->pixels_size);
+    if (ret->pixels == NULL) {
+        free(ret);
+        return NULL;
+    }
+    memcpy(ret->pixels, data + header_size, ret->pixels_size);
 
     return ret;
 }
@@ -1,6 +1,7 @@
 #ifndef __DFRANX_DDS_H__
 #define __DFRANX_DDS_H__
 // from https://github.com/dfranx/DDS
+#include <stddef.h>
 
 typedef unsigned int dds_uint;
 typedef unsigned char dds_byte;
@@ -92,6 +93,12 @@ struct dds_image {
 };
 typedef struct dds_image* dds_image_t;
 
+// Reads the headers without copying pixels. image->pixels will be NULL.
+// Returns the offset of pixels in data, or 0 if the data is not a valid dds.
+size_t dds_parse_header(dds_image_t image, const dds_byte* data, size_t data_length);
+long dds_get_header_size(dds_image_t image);
+// Writes the magic and headers. dest should have dds_get_header_size() bytes.
+void dds_write_header(dds_image_t image, dds_byte* dest);
 dds_image_t dds_load(const char* filename);
 int dds_save(dds_image_t image, const char* filename);
 void dds_get_block_info(dds_image_t image, int *block_width, int *block_height, int *block_data_size);
@@ -1,16 +1,49 @@
+#include <inttypes.h>
+#include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
-#include "console-swizzler.h"
-#include "dds.h"
+#include "batch.h"
+#include "convert.h"
+#include "pipeline.h"
+#include "serve.h"
+#include "trace.h"
 
 void printUsage() {
     const char* usage =
-        "Usage: swizzler-cli <command> <input> <output> [<platform> [<gobs_height>]]\n"
+        "Usage: swizzler-cli [<options>] <command> <input> <output> [<platform> [<gobs_height>]]\n"
+        "       swizzler-cli [<options>] batch <manifest>\n"
+        "       swizzler-cli [<options>] batch <command> <input_dir> <output_dir>"
+        " [<platform> [<gobs_height>]]\n"
+        "       swizzler-cli [<options>] serve [<socket_path>]\n"
+        "\n"
+        "    options:\n"
+        "        --memory-budget <MiB> : converts data chunk by chunk within the budget.\n"
+        "                                It can convert files larger than RAM.\n"
+        "                                Reading, converting, and writing overlap.\n"
+        "        --threads <count> : the number of threads. 0 means all processors.\n"
+        "                            The default value is 1, or 0 for batch and serve.\n"
+        "        --timings : prints times of loading, swizzling, and saving a file.\n"
+        "        --trace <path> : writes a timeline as a Chrome trace (JSON).\n"
+        "                         Perfetto (ui.perfetto.dev) can open it.\n"
         "\n"
         "    command:\n"
         "        swizzle : swizzles an input dds.\n"
         "        unswizzle : unswizzles an input dds.\n"
         "\n"
+        "    batch: converts dds files in parallel, and prints the throughput.\n"
+        "           A manifest has a line per file. Each line is the same as the arguments\n"
+        "           of a single file: <command> <input> <output> [<platform> [<gobs_height>]]\n"
+        "           Quote paths with spaces. Lines starting with # are ignored.\n"
+        "           The directory mode converts all .dds files in <input_dir>.\n"
+        "\n"
+        "    serve: reads jobs as JSON lines from stdin or a Unix domain socket.\n"
+        "           It keeps threads and layouts warm, and writes a JSON record per job.\n"
+        "           A job is {\"id\": 1, \"command\": \"swizzle\", \"input\": \"a.dds\",\n"
+        "           \"output\": \"b.dds\", \"platform\": \"switch\", \"gobs_height\": 8}\n"
+        "           A line can also be an array of jobs. Jobs are converted concurrently.\n"
+        "\n"
         "    platform: ps4 or switch\n"
         "\n"
         "    gobs_height: The max height of GOBs blocks for switch.\n"
@@ -21,155 +54,298 @@ void printUsage() {
         "    swizzler-cli swizzle raw.dds swizzled.dds\n"
         "    swizzler-cli unswizzle swizzled.dds raw.dds ps4\n"
         "    swizzler-cli unswizzle swizzled.dds raw.dds switch 8\n"
+        "    swizzler-cli --memory-budget 256 swizzle raw.dds swizzled.dds\n"
+        "    swizzler-cli --trace trace.json swizzle raw.dds swizzled.dds\n"
+        "    swizzler-cli batch files.txt\n"
+        "    swizzler-cli --threads 4 batch unswizzle swizzled/ raw/ switch 8\n"
         "\n";
     printf("%s", usage);
 }
 
-int main(int argc, char* argv[]) {
-    printf("Console Swizzler v%s\n", swizGetVersion());
-    if (argc < 4 || argc > 6) {
-        printUsage();
+// Prints times of stages in seconds.
+static void printTimings(double load, double swizzle, double save) {
+    printf("Timings: load %.6f s, swizzle %.6f s, save %.6f s\n", load, swizzle, save);
+}
+
+// Swizzles the mapped input into the mapped output.
+static int convertMappedFile(const ConvertArgs *args, int thread_count, int print_timings) {
+    printf("Loading %s...\n", args->input_filename);
+    double start = getTime();
+    double load_end = start;
+    double swizzle_end = start;
+    ConvertJob job;
+    if (beginConvertJob(&job, args, NULL)) {
+        load_end = getTime();
+        printf("Saving %s...\n", args->output_filename);
+        runConvertJobInChunks(&job, thread_count);
+        swizzle_end = getTime();
+    }
+    endConvertJob(&job);
+
+    if (job.error != NULL) {
+        printf("%s\n", job.error);
         return 1;
     }
-    const char* command = argv[1];
-    int swizzle = 0;
-    if (strcmp(command, "swizzle") == 0) {
-        swizzle = 1;
-    } else if (strcmp(command, "unswizzle") != 0) {
-        printUsage();
-        printf("Unknown command. (%s)\n", command);
+    printf("Done.\n");
+    if (print_timings)
+        printTimings(load_end - start, swizzle_end - load_end, getTime() - swizzle_end);
+    return 0;
+}
+
+// Reads the headers of a dds file. The file position will be at the pixels.
+static size_t readHeader(FILE* file, dds_image_t image) {
+    dds_byte header[4 + sizeof(struct dds_header) + sizeof(struct dds_header_dxt10)];
+    size_t read_size = fread(header, 1, sizeof(header), file);
+    size_t header_size = dds_parse_header(image, header, read_size);
+    // The header is at most 148 bytes, so it fits in the offset of fseek().
+    if (header_size == 0 || fseek(file, (int)header_size, SEEK_SET) != 0)
+        return 0;
+    return header_size;
+}
+
+// Chunks are read and written while they are converted.
+// So, the time of the swizzle stage includes most of reading and writing.
+static int convertFileInChunks(const ConvertArgs *args, size_t memory_budget,
+                               int thread_count, int print_timings) {
+    printf("Loading %s...\n", args->input_filename);
+    double start = getTime();
+    FILE* input = fopen(args->input_filename, "rb");
+    double open_end = getTime();
+    traceSpan("load", start, open_end, args->input_filename);
+    struct dds_image image;
+    size_t header_size = 0;
+    if (input != NULL)
+        header_size = readHeader(input, &image);
+    if (header_size == 0) {
+        printf("Failed to load dds.\n");
+        if (input != NULL)
+            fclose(input);
         return 1;
     }
+    double parse_end = getTime();
+    traceSpan("parse header", open_end, parse_end, NULL);
 
-    const char* input_filename = argv[2];
-    const char* output_filename = argv[3];
-    const char* platform_name;
-    SwizPlatform platform = SWIZ_PLATFORM_PS4;
+    SwizContext *context = newContextForDDS(&image, args->platform, args->gobs_height);
+    if (context == NULL) {
+        printf("Unsupported pixel format.\n");
+        fclose(input);
+        return 1;
+    }
+    swizContextSetThreadCount(context, thread_count);
+    traceSpan("context setup", parse_end, getTime(), NULL);
 
-    if (argc >= 5) {
-        platform_name = argv[4];
-        if (strcmp(platform_name, "switch") == 0) {
-            platform = SWIZ_PLATFORM_SWITCH;
-        } else if (strcmp(platform_name, "ps4") != 0) {
-            printUsage();
-            printf("Unknown platform. (%s)\n", platform_name);
-            return 1;
-        }
-        printf("Platform: %s\n", platform_name);
+    FILE* output = fopen(args->output_filename, "wb");
+    if (output == NULL) {
+        printf("Failed to save a dds file.\n");
+        swizFreeContext(context);
+        fclose(input);
+        return 1;
+    }
+
+    double load_end = getTime();
+    printf("Saving %s...\n", args->output_filename);
+    dds_byte header[4 + sizeof(struct dds_header) + sizeof(struct dds_header_dxt10)];
+    dds_write_header(&image, header);
+    int failed = 0;
+    if (fwrite(header, 1, header_size, output) != header_size) {
+        printf("Failed to save a dds file.\n");
+        failed = 1;
     } else {
-        printf("Platform: ps4\n");
-    }
-
-    int gobs_height = 16;
-
-    if (platform == SWIZ_PLATFORM_SWITCH) {
-        if (argc == 6) {
-            const char* gobs_height_str = argv[5];
-            if (strcmp(gobs_height_str, "1") == 0) {
-                gobs_height = 1;
-            } else if (strcmp(gobs_height_str, "2") == 0) {
-                gobs_height = 2;
-            } else if (strcmp(gobs_height_str, "4") == 0) {
-                gobs_height = 4;
-            } else if (strcmp(gobs_height_str, "8") == 0) {
-                gobs_height = 8;
-            } else if (strcmp(gobs_height_str, "16") == 0) {
-                gobs_height = 16;
-            } else if (strcmp(gobs_height_str, "32") == 0) {
-                gobs_height = 32;
-            } else {
-                printUsage();
-                printf("The max height of GOB blocks should be 1, 2, 4, 8, 16, or 32. (%s)\n",
-                       gobs_height_str);
-                return 1;
-            }
-            printf("GOBs height: %s\n", gobs_height_str);
-        } else {
-            printf("GOBs height: 16\n");
+        const char *error = convertChunksPipelined(input, output, context, memory_budget,
+                                                   args->swizzle);
+        if (error != NULL) {
+            printf("%s\n", error);
+            failed = 1;
         }
     }
 
-    int width, height, block_width, block_height, block_data_size;
-    SwizContext *context;
-    SwizError ret;
-
-    printf("Loading %s...\n", input_filename);
-    dds_image_t image = dds_load(input_filename);
-    if (image == NULL) {
-        printf("Failed to load dds.\n");
+    double swizzle_end = getTime();
+    swizFreeContext(context);
+    fclose(input);
+    if (fclose(output) != 0 && !failed) {
+        printf("Failed to save a dds file.\n");
+        failed = 1;
+    }
+    if (failed) {
+        remove(args->output_filename);
         return 1;
     }
-    dds_image_t out_image = dds_copy(image);
+    traceSpan("save", swizzle_end, getTime(), args->output_filename);
+    printf("Done.\n");
+    if (print_timings)
+        printTimings(load_end - start, swizzle_end - load_end, getTime() - swizzle_end);
+    return 0;
+}
 
-    width = image->header.width;
-    height = image->header.height;
-    dds_get_block_info(image, &block_width, &block_height, &block_data_size);
+// Parses a positive integer for an option. Returns -1 when it's not a number or too large.
+static int parseOptionValue(const char* str) {
+    char* end;
+    intmax_t value = strtoimax(str, &end, 10);
+    if (*end != '\0' || end == str || value < 0 || value > INT_MAX)
+        return -1;
+    return (int)value;
+}
 
-    if (block_data_size == 0) {
-        printf("Unsupported pixel format.\n");
-        return 1;
+// Parses the platform and gobs_height arguments, and prints them.
+static int parseAndPrintTarget(int argc, char* argv[], ConvertArgs *args) {
+    const char* invalid_arg;
+    const char* error = parseTarget(argc, argv, args, &invalid_arg);
+    if (error != NULL) {
+        printUsage();
+        printf("%s (%s)\n", error, invalid_arg);
+        return 0;
     }
+    printf("Platform: %s\n", args->platform == SWIZ_PLATFORM_SWITCH ? "switch" : "ps4");
+    if (args->platform == SWIZ_PLATFORM_SWITCH)
+        printf("GOBs height: %d\n", args->gobs_height);
+    return 1;
+}
 
-    context = swizNewContext();
-    swizContextSetPlatform(context, platform);
-    swizContextSetTextureSize(context, width, height);
-    swizContextSetGobsHeight(context, gobs_height);
-    swizContextSetHasMips(context, image->header.mipmap_count > 1);
-    swizContextSetBlockInfo(context, block_width, block_height, block_data_size);
-
-    uint32_t data_size;
-    uint8_t *new_data;
-    uint32_t new_data_size;
-    if (swizzle) {
-        data_size = swizGetUnswizzledSize(context);
-        new_data = swizAllocSwizzledData(context);
-        new_data_size = swizGetSwizzledSize(context);
+static int runBatchCommand(int argc, char* argv[], int thread_count) {
+    BatchList list;
+    initBatchList(&list);
+    if (argc == 3) {
+        if (!loadBatchManifest(&list, argv[2])) {
+            printf("Failed to read the manifest. (%s)\n", argv[2]);
+            freeBatchList(&list);
+            return 1;
+        }
+    } else if (argc >= 5 && argc <= 7) {
+        ConvertArgs args;
+        if (!parseCommand(argv[2], &args.swizzle)) {
+            printUsage();
+            printf("Unknown command. (%s)\n", argv[2]);
+            return 1;
+        }
+        if (!parseAndPrintTarget(argc - 5, argv + 5, &args))
+            return 1;
+        if (!loadBatchDirectory(&list, argv[3], argv[4], &args)) {
+            printf("Failed to read the directory. (%s)\n", argv[3]);
+            freeBatchList(&list);
+            return 1;
+        }
     } else {
-        data_size = swizGetSwizzledSize(context);
-        new_data = swizAllocUnswizzledData(context);
-        new_data_size = swizGetUnswizzledSize(context);
+        printUsage();
+        return 1;
     }
-    if (image->pixels_size < data_size) {
-        printf("Failed to calculate data size.\n");
-        swizFreeContext(context);
-        dds_image_free(image);
-        dds_image_free(out_image);
+
+    int failed = runBatch(&list, thread_count);
+    freeBatchList(&list);
+    return failed > 0;
+}
+
+// Returns non-zero if the command after options is "serve".
+static int isServeCommand(int argc, char* argv[]) {
+    int i = 1;
+    while (i < argc && strncmp(argv[i], "--", 2) == 0)
+        i += strcmp(argv[i], "--timings") == 0 ? 1 : 2;
+    return i < argc && strcmp(argv[i], "serve") == 0;
+}
+
+// Runs a command other than serve.
+static int runCommand(int argc, char* argv[], size_t memory_budget, int thread_count,
+                      int print_timings) {
+    if (argc >= 2 && strcmp(argv[1], "batch") == 0) {
+        if (memory_budget > 0) {
+            printf("The batch command doesn't support --memory-budget.\n");
+            return 1;
+        }
+        // Use all processors by default. Files are converted on the same threads.
+        return runBatchCommand(argc, argv, thread_count < 0 ? 0 : thread_count);
+    }
+
+    if (argc < 4 || argc > 6) {
+        printUsage();
         return 1;
     }
+    ConvertArgs args;
+    const char* command = argv[1];
+    if (!parseCommand(command, &args.swizzle)) {
+        printUsage();
+        printf("Unknown command. (%s)\n", command);
+        return 1;
+    }
+    args.input_filename = argv[2];
+    args.output_filename = argv[3];
+    if (!parseAndPrintTarget(argc - 4, argv + 4, &args))
+        return 1;
 
-    if (new_data == NULL) {
-        printf("Memory allocation error.\n");
-        swizFreeContext(context);
-        dds_image_free(image);
-        dds_image_free(out_image);
+    if (strcmp(args.input_filename, args.output_filename) == 0) {
+        printf("The output file should be different from the input file.\n");
         return 1;
     }
 
-    if (swizzle)
-        ret = swizDoSwizzle(image->pixels, new_data, context);
-    else
-        ret = swizDoUnswizzle(image->pixels, new_data, context);
-    free(out_image->pixels);
-    out_image->pixels = new_data;
-    out_image->pixels_size = new_data_size;
+    if (thread_count < 0)
+        thread_count = 1;
+    if (memory_budget > 0)
+        return convertFileInChunks(&args, memory_budget, thread_count, print_timings);
+    return convertMappedFile(&args, thread_count, print_timings);
+}
+
+int main(int argc, char* argv[]) {
+    // The server writes records to stdout. So, it should not print anything else there.
+    int serve = isServeCommand(argc, argv);
+    if (!serve)
+        printf("Console Swizzler v%s\n", swizGetVersion());
 
-    swizFreeContext(context);
-    dds_image_free(image);
+    size_t memory_budget = 0;
+    int thread_count = -1;
+    int print_timings = 0;
+    const char* trace_filename = NULL;
+    while (argc >= 2 && strncmp(argv[1], "--", 2) == 0) {
+        if (strcmp(argv[1], "--timings") == 0) {
+            print_timings = 1;
+            argc--;
+            argv++;
+            continue;
+        }
+        if (argc < 3) {
+            printUsage();
+            return 1;
+        }
+        int value = parseOptionValue(argv[2]);
+        if (strcmp(argv[1], "--trace") == 0) {
+            trace_filename = argv[2];
+        } else if (strcmp(argv[1], "--memory-budget") == 0) {
+            if (value <= 0 || (size_t)value > SIZE_MAX / (1024 * 1024)) {
+                printUsage();
+                printf("The memory budget should be a positive integer. (%s)\n", argv[2]);
+                return 1;
+            }
+            printf("Memory budget: %d MiB\n", value);
+            memory_budget = (size_t)value * 1024 * 1024;
+        } else if (strcmp(argv[1], "--threads") == 0) {
+            if (value < 0 || value > 1024) {
+                printUsage();
+                printf("The thread count should be an integer from 0 to 1024. (%s)\n", argv[2]);
+                return 1;
+            }
+            thread_count = (int)value;
+        } else {
+            printUsage();
+            printf("Unknown option. (%s)\n", argv[1]);
+            return 1;
+        }
+        argc -= 2;
+        argv += 2;
+    }
 
-    if (ret != SWIZ_OK) {
-        printf("%s\n", swizGetErrorMessage(ret));
-        dds_image_free(out_image);
-        return 1;
+    if (serve) {
+        if (memory_budget > 0 || trace_filename != NULL || argc > 3) {
+            printUsage();
+            return 1;
+        }
+        return runServer(argc == 3 ? argv[2] : NULL, thread_count < 0 ? 0 : thread_count);
     }
 
-    printf("Saving %s...\n", output_filename);
-    int saved = dds_save(out_image, output_filename);
-    if (!saved) {
-        printf("Failed to save a dds file.\n");
-        dds_image_free(out_image);
+    if (trace_filename != NULL && !openTrace(trace_filename)) {
+        printf("Failed to open the trace file. (%s)\n", trace_filename);
         return 1;
     }
-    printf("Done.\n");
-    dds_image_free(out_image);
-    return 0;
+    int ret = runCommand(argc, argv, memory_budget, thread_count, print_timings);
+    if (!closeTrace()) {
+        printf("Failed to write the trace file. (%s)\n", trace_filename);
+        ret = 1;
+    }
+    return ret;
 }
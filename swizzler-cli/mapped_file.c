@@ -0,0 +1,199 @@
+// mmap, posix_madvise, and posix_fallocate are not in C99. madvise is not even in POSIX.
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#define _DEFAULT_SOURCE
+#define _DARWIN_C_SOURCE
+#endif
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static void release_pages(uint8_t *data, size_t size);
+static size_t get_page_size(void);
+
+static void init_file(MappedFile *file) {
+    file->data = NULL;
+    file->size = 0;
+    file->released = 0;
+#ifdef _WIN32
+    file->file = INVALID_HANDLE_VALUE;
+    file->mapping = NULL;
+#else
+    file->fd = -1;
+#endif
+}
+
+void releaseMappedPages(MappedFile *file, size_t offset) {
+    // Keep the page at the offset. It can still be in use.
+    size_t end = offset >= file->size ? file->size : offset / get_page_size() * get_page_size();
+    if (end <= file->released)
+        return;
+    release_pages(file->data + file->released, end - file->released);
+    file->released = end;
+}
+
+#ifdef _WIN32
+
+static size_t get_page_size(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (size_t)info.dwPageSize;
+}
+
+static void release_pages(uint8_t *data, size_t size) {
+    // Unlocking pages that are not locked removes them from the working set.
+    // Dirty pages are written to the file by the cache manager.
+    VirtualUnlock(data, size);
+}
+
+static int map_file(MappedFile *file, int writable) {
+    DWORD protect = writable ? PAGE_READWRITE : PAGE_READONLY;
+    DWORD access = writable ? FILE_MAP_WRITE : FILE_MAP_READ;
+    uint64_t size = (uint64_t)file->size;
+    file->mapping = CreateFileMappingA(file->file, NULL, protect,
+                                       (DWORD)(size >> 32), (DWORD)size, NULL);
+    if (file->mapping == NULL)
+        return 0;
+    file->data = (uint8_t *)MapViewOfFile(file->mapping, access, 0, 0, file->size);
+    return file->data != NULL;
+}
+
+int mapFileForRead(MappedFile *file, const char *filename) {
+    init_file(file);
+    // FILE_FLAG_SEQUENTIAL_SCAN makes the cache manager read ahead aggressively.
+    file->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                             FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file->file == INVALID_HANDLE_VALUE)
+        return 0;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file->file, &size) || size.QuadPart == 0 ||
+        (uint64_t)size.QuadPart > (uint64_t)SIZE_MAX) {
+        unmapFile(file);
+        return 0;
+    }
+    file->size = (size_t)size.QuadPart;
+    if (!map_file(file, 0)) {
+        unmapFile(file);
+        return 0;
+    }
+    return 1;
+}
+
+int mapFileForWrite(MappedFile *file, const char *filename, size_t size) {
+    init_file(file);
+    file->file = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                             FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file->file == INVALID_HANDLE_VALUE)
+        return 0;
+
+    // The file mapping extends the file to the size.
+    file->size = size;
+    if (size == 0 || !map_file(file, 1)) {
+        unmapFile(file);
+        return 0;
+    }
+    return 1;
+}
+
+void unmapFile(MappedFile *file) {
+    if (file->data != NULL)
+        UnmapViewOfFile(file->data);
+    if (file->mapping != NULL)
+        CloseHandle(file->mapping);
+    if (file->file != INVALID_HANDLE_VALUE)
+        CloseHandle(file->file);
+    init_file(file);
+}
+
+#else  // _WIN32
+
+static size_t get_page_size(void) {
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+static void release_pages(uint8_t *data, size_t size) {
+    // Start writing dirty pages back, then unmap them from the process.
+    // MADV_DONTNEED on a shared file mapping keeps the data in the page cache and the file.
+    // posix_madvise(POSIX_MADV_DONTNEED) is a no-op on Linux, so we use madvise() here.
+    msync(data, size, MS_ASYNC);
+    madvise(data, size, MADV_DONTNEED);
+}
+
+static int map_file(MappedFile *file, int writable) {
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void *data = mmap(NULL, file->size, prot, MAP_SHARED, file->fd, 0);
+    if (data == MAP_FAILED)
+        return 0;
+    file->data = (uint8_t *)data;
+
+    // Pages will be read and written from the beginning to the end.
+    // The hint lets the kernel read ahead and drop pages that we have used.
+    posix_madvise(data, file->size, POSIX_MADV_SEQUENTIAL);
+    return 1;
+}
+
+int mapFileForRead(MappedFile *file, const char *filename) {
+    init_file(file);
+    file->fd = open(filename, O_RDONLY);
+    if (file->fd < 0)
+        return 0;
+
+    struct stat st;
+    if (fstat(file->fd, &st) != 0 || st.st_size <= 0 ||
+        (uint64_t)st.st_size > (uint64_t)SIZE_MAX) {
+        unmapFile(file);
+        return 0;
+    }
+    file->size = (size_t)st.st_size;
+    if (!map_file(file, 0)) {
+        unmapFile(file);
+        return 0;
+    }
+    return 1;
+}
+
+int mapFileForWrite(MappedFile *file, const char *filename, size_t size) {
+    init_file(file);
+    file->fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file->fd < 0)
+        return 0;
+
+    file->size = size;
+    if (size == 0 || ftruncate(file->fd, (off_t)size) != 0) {
+        unmapFile(file);
+        return 0;
+    }
+#ifdef __linux__
+    // Reserve disk blocks now. Otherwise, a full disk raises SIGBUS while we write the mapping.
+    // Some file systems don't support it, and ftruncate() is enough for them.
+    int err = posix_fallocate(file->fd, 0, (off_t)size);
+    if (err != 0 && err != EINVAL && err != EOPNOTSUPP) {
+        unmapFile(file);
+        return 0;
+    }
+#endif
+    if (!map_file(file, 1)) {
+        unmapFile(file);
+        return 0;
+    }
+    return 1;
+}
+
+void unmapFile(MappedFile *file) {
+    if (file->data != NULL)
+        munmap(file->data, file->size);
+    if (file->fd >= 0)
+        close(file->fd);
+    init_file(file);
+}
+
+#endif  // _WIN32
@@ -0,0 +1,36 @@
+#ifndef __SWIZZLER_CLI_MAPPED_FILE_H__
+#define __SWIZZLER_CLI_MAPPED_FILE_H__
+#include <stddef.h>
+#include <stdint.h>
+
+// A file that is mapped to memory.
+// It lets the OS page data in and out, so we don't need to hold the whole file in the heap.
+typedef struct MappedFile {
+    uint8_t *data;
+    size_t size;
+    size_t released;  // Pages before the offset have been released by releaseMappedPages()
+#ifdef _WIN32
+    void *file;  // HANDLE of the file
+    void *mapping;  // HANDLE of the file mapping
+#else
+    int fd;
+#endif
+} MappedFile;
+
+// Maps an existing file as read-only memory for sequential access.
+// Returns zero when it failed.
+int mapFileForRead(MappedFile *file, const char *filename);
+
+// Creates (or truncates) a file of the size and maps it as writable memory.
+// Returns zero when it failed.
+int mapFileForWrite(MappedFile *file, const char *filename, size_t size);
+
+// Drops pages before the offset from the memory of the process. Written data is kept.
+// Files that are converted in order can call it behind the cursor to keep the RSS small.
+// The pages can still be accessed, but they will be paged in again.
+void releaseMappedPages(MappedFile *file, size_t offset);
+
+// Unmaps and closes the file. Written data will be flushed to the file.
+void unmapFile(MappedFile *file);
+
+#endif  // __SWIZZLER_CLI_MAPPED_FILE_H__
@@ -0,0 +1,205 @@
+#include <stdlib.h>
+#include "convert.h"
+#include "pipeline.h"
+#include "threads.h"
+#include "trace.h"
+
+// A chunk goes through the states in this order, and then it's reused for another chunk.
+typedef enum SlotState {
+    SLOT_FREE,
+    SLOT_READ,
+    SLOT_CONVERTED,
+} SlotState;
+
+typedef struct Slot {
+    uint8_t *data;  // Input of the chunk
+    uint8_t *new_data;  // Output of the chunk
+    SwizChunk chunk;
+    SlotState state;
+} Slot;
+
+typedef struct Pipeline {
+    FILE *input;
+    FILE *output;
+    SwizContext *context;
+    size_t chunk_budget;
+    int chunk_count;
+    int swizzle;
+    Slot slots[PIPELINE_DEPTH];
+    Mutex mutex;
+    Cond cond;  // Signaled when a slot changes its state or a stage fails
+    const char *error;  // The first error. All stages stop when it's set.
+} Pipeline;
+
+// Waits until the slot of a chunk gets the state. Returns zero if a stage failed.
+static int wait_slot(Pipeline *p, int chunk_index, SlotState state) {
+    Slot *slot = &p->slots[chunk_index % PIPELINE_DEPTH];
+    MUTEX_LOCK(&p->mutex);
+    while (slot->state != state && p->error == NULL)
+        COND_WAIT(&p->cond, &p->mutex);
+    int ok = p->error == NULL;
+    MUTEX_UNLOCK(&p->mutex);
+    return ok;
+}
+
+static int set_slot(Pipeline *p, int chunk_index, SlotState state, const char *error) {
+    MUTEX_LOCK(&p->mutex);
+    if (error != NULL && p->error == NULL)
+        p->error = error;
+    p->slots[chunk_index % PIPELINE_DEPTH].state = state;
+    COND_BROADCAST(&p->cond);
+    MUTEX_UNLOCK(&p->mutex);
+    return error == NULL;
+}
+
+static size_t get_data_size(const SwizChunk *chunk, int swizzle) {
+    return (size_t)(swizzle ? chunk->data_size : chunk->swizzled_size);
+}
+
+static size_t get_new_data_size(const SwizChunk *chunk, int swizzle) {
+    return (size_t)(swizzle ? chunk->swizzled_size : chunk->data_size);
+}
+
+static void trace_chunk(const char *name, double start, const SwizChunk *chunk, size_t size) {
+    if (isTracing())
+        traceSubresourceSpan(name, start, getTime(), chunk->mip, chunk->slice, size);
+}
+
+static int read_chunk(Pipeline *p, int chunk_index) {
+    if (!wait_slot(p, chunk_index, SLOT_FREE))
+        return 0;
+    Slot *slot = &p->slots[chunk_index % PIPELINE_DEPTH];
+    double start = getTime();
+    SwizError ret = swizGetChunk(p->context, p->chunk_budget, chunk_index, &slot->chunk);
+    if (ret != SWIZ_OK)
+        return set_slot(p, chunk_index, SLOT_READ, swizGetErrorMessage(ret));
+    size_t data_size = get_data_size(&slot->chunk, p->swizzle);
+    const char *error = NULL;
+    if (fread(slot->data, 1, data_size, p->input) != data_size)
+        error = "Failed to load dds.";
+    trace_chunk("read", start, &slot->chunk, data_size);
+    return set_slot(p, chunk_index, SLOT_READ, error);
+}
+
+static int convert_chunk(Pipeline *p, int chunk_index) {
+    if (!wait_slot(p, chunk_index, SLOT_READ))
+        return 0;
+    Slot *slot = &p->slots[chunk_index % PIPELINE_DEPTH];
+    double start = getTime();
+    SwizError ret;
+    if (p->swizzle)
+        ret = swizDoSwizzleChunk(slot->data, slot->new_data, &slot->chunk, p->context);
+    else
+        ret = swizDoUnswizzleChunk(slot->data, slot->new_data, &slot->chunk, p->context);
+    trace_chunk(p->swizzle ? "swizzle" : "unswizzle", start, &slot->chunk,
+                get_new_data_size(&slot->chunk, p->swizzle));
+    const char *error = ret == SWIZ_OK ? NULL : swizGetErrorMessage(ret);
+    return set_slot(p, chunk_index, SLOT_CONVERTED, error);
+}
+
+static int write_chunk(Pipeline *p, int chunk_index) {
+    if (!wait_slot(p, chunk_index, SLOT_CONVERTED))
+        return 0;
+    Slot *slot = &p->slots[chunk_index % PIPELINE_DEPTH];
+    double start = getTime();
+    size_t new_data_size = get_new_data_size(&slot->chunk, p->swizzle);
+    const char *error = NULL;
+    if (fwrite(slot->new_data, 1, new_data_size, p->output) != new_data_size)
+        error = "Failed to save a dds file.";
+    trace_chunk("write", start, &slot->chunk, new_data_size);
+    return set_slot(p, chunk_index, SLOT_FREE, error);
+}
+
+static void read_chunks(void *arg) {
+    Pipeline *p = (Pipeline *)arg;
+    setTraceThreadName("reader");
+    for (int i = 0; i < p->chunk_count && read_chunk(p, i); i++) {}
+}
+
+static void write_chunks(void *arg) {
+    Pipeline *p = (Pipeline *)arg;
+    setTraceThreadName("writer");
+    for (int i = 0; i < p->chunk_count && write_chunk(p, i); i++) {}
+}
+
+// Allocates buffers for the largest chunk. Returns an error message, or NULL.
+static const char *alloc_slots(Pipeline *p) {
+    for (int i = 0; i < PIPELINE_DEPTH; i++) {
+        p->slots[i].data = NULL;
+        p->slots[i].new_data = NULL;
+        p->slots[i].state = SLOT_FREE;
+    }
+    size_t data_buffer_size = 0;
+    size_t new_data_buffer_size = 0;
+    for (int i = 0; i < p->chunk_count; i++) {
+        SwizChunk chunk;
+        SwizError ret = swizGetChunk(p->context, p->chunk_budget, i, &chunk);
+        if (ret != SWIZ_OK)
+            return swizGetErrorMessage(ret);
+        size_t data_size = get_data_size(&chunk, p->swizzle);
+        size_t new_data_size = get_new_data_size(&chunk, p->swizzle);
+        if (data_size > data_buffer_size)
+            data_buffer_size = data_size;
+        if (new_data_size > new_data_buffer_size)
+            new_data_buffer_size = new_data_size;
+    }
+    for (int i = 0; i < PIPELINE_DEPTH; i++) {
+        p->slots[i].data = (uint8_t *)malloc(data_buffer_size);
+        p->slots[i].new_data = (uint8_t *)malloc(new_data_buffer_size);
+        if (p->slots[i].data == NULL || p->slots[i].new_data == NULL)
+            return "Memory allocation error.";
+    }
+    return NULL;
+}
+
+static void free_slots(Pipeline *p) {
+    for (int i = 0; i < PIPELINE_DEPTH; i++) {
+        free(p->slots[i].data);
+        free(p->slots[i].new_data);
+    }
+}
+
+const char *convertChunksPipelined(FILE *input, FILE *output, SwizContext *context,
+                                   size_t memory_budget, int swizzle) {
+    Pipeline p;
+    p.input = input;
+    p.output = output;
+    p.context = context;
+    // All in-flight chunks share the budget.
+    p.chunk_budget = memory_budget / PIPELINE_DEPTH;
+    p.chunk_count = swizGetChunkCount(context, p.chunk_budget);
+    p.swizzle = swizzle;
+    p.error = NULL;
+    if (p.chunk_count == 0)
+        return "Failed to calculate data size.";
+    const char *error = alloc_slots(&p);
+    if (error != NULL) {
+        free_slots(&p);
+        return error;
+    }
+    MUTEX_INIT(&p.mutex);
+    COND_INIT(&p.cond);
+
+    // The reader and the writer work on other threads while this thread converts chunks.
+    // When a thread can't be created, this thread does its work instead.
+    Thread reader, writer;
+    int has_reader = createThread(&reader, read_chunks, &p);
+    int has_writer = createThread(&writer, write_chunks, &p);
+    for (int i = 0; i < p.chunk_count; i++) {
+        if (!has_reader && !read_chunk(&p, i))
+            break;
+        if (!convert_chunk(&p, i))
+            break;
+        if (!has_writer && !write_chunk(&p, i))
+            break;
+    }
+    if (has_reader)
+        joinThread(reader);
+    if (has_writer)
+        joinThread(writer);
+
+    COND_DESTROY(&p.cond);
+    MUTEX_DESTROY(&p.mutex);
+    free_slots(&p);
+    return p.error;
+}
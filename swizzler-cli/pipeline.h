@@ -0,0 +1,16 @@
+#ifndef __SWIZZLER_CLI_PIPELINE_H__
+#define __SWIZZLER_CLI_PIPELINE_H__
+#include <stdio.h>
+#include "console-swizzler.h"
+
+// The number of chunks that can be in flight at the same time.
+#define PIPELINE_DEPTH 3
+
+// Converts pixels chunk by chunk. Chunks are contiguous in both files.
+// While a chunk is converted, the next chunk is read and the previous one is written
+// on other threads. Buffers of all in-flight chunks fit in the memory budget.
+// The file positions should be at the pixels. Returns an error message, or NULL.
+const char *convertChunksPipelined(FILE *input, FILE *output, SwizContext *context,
+                                   size_t memory_budget, int swizzle);
+
+#endif  // __SWIZZLER_CLI_PIPELINE_H__
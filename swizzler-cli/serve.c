@@ -0,0 +1,644 @@
+// Sockets, fdopen, and dup are not in C99.
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "convert.h"
+#include "serve.h"
+#include "threads.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// A client that sends lines of jobs. Records are written to the output as jobs complete.
+typedef struct Client {
+    FILE *output;
+    Mutex mutex;  // Guards output and pending_jobs
+    Cond cond;  // Signaled when a job of the client completes
+    int pending_jobs;  // The number of jobs in the queue or on workers
+} Client;
+
+// A job that is parsed from a line.
+typedef struct ServeJob {
+    ConvertArgs args;  // File names are owned by the job
+    char *id;  // Raw JSON value of "id", or NULL
+    const char *error;  // Error of the request
+    Client *client;
+    double start;  // Time when the line was read
+    struct ServeJob *next;  // Next job in the line or the queue
+} ServeJob;
+
+// States that are kept while serving.
+// Jobs of all lines and clients go to a queue. Workers take a job at a time from it.
+typedef struct Server {
+    PlanCache cache;
+    Mutex mutex;  // Guards the queue, client_count, and stopping
+    Cond cond;  // Signaled when jobs are queued, a client leaves, or the server stops
+    ServeJob *first_job;
+    ServeJob *last_job;
+    int client_count;  // The number of socket clients that are being served
+    int stopping;
+    int worker_count;
+} Server;
+
+static const char *skip_space(const char *p) {
+    while (isspace((unsigned char)*p))
+        p++;
+    return p;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    c = (char)tolower((unsigned char)c);
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+// Parses a JSON string. Returns the end of the string, or NULL when it's invalid.
+// The string will be stored in *str when str is not NULL.
+static const char *parse_string(const char *p, char **str) {
+    if (*p != '"')
+        return NULL;
+    p++;
+    // Escaped strings are never longer than the raw ones.
+    char *buf = (char *)malloc(strlen(p) + 1);
+    if (buf == NULL)
+        return NULL;
+    char *out = buf;
+    while (*p != '"') {
+        if (*p == '\0' || (unsigned char)*p < 0x20) {
+            free(buf);
+            return NULL;
+        }
+        if (*p != '\\') {
+            *out++ = *p++;
+            continue;
+        }
+        p++;
+        switch (*p) {
+        case '"': case '\\': case '/':
+            *out++ = *p;
+            break;
+        case 'b': *out++ = '\b'; break;
+        case 'f': *out++ = '\f'; break;
+        case 'n': *out++ = '\n'; break;
+        case 'r': *out++ = '\r'; break;
+        case 't': *out++ = '\t'; break;
+        case 'u': {
+            // Encode a code point of BMP as UTF-8. Surrogate pairs are not supported.
+            int code = 0;
+            for (int i = 1; i <= 4; i++) {
+                int v = hex_value(p[i]);
+                if (v < 0) {
+                    free(buf);
+                    return NULL;
+                }
+                code = code * 16 + v;
+            }
+            if (code == 0 || (code >= 0xD800 && code < 0xE000)) {
+                free(buf);
+                return NULL;
+            }
+            if (code < 0x80) {
+                *out++ = (char)code;
+            } else if (code < 0x800) {
+                *out++ = (char)(0xC0 | (code >> 6));
+                *out++ = (char)(0x80 | (code & 0x3F));
+            } else {
+                *out++ = (char)(0xE0 | (code >> 12));
+                *out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+                *out++ = (char)(0x80 | (code & 0x3F));
+            }
+            p += 4;
+            break;
+        }
+        default:
+            free(buf);
+            return NULL;
+        }
+        p++;
+    }
+    *out = '\0';
+    if (str != NULL)
+        *str = buf;
+    else
+        free(buf);
+    return p + 1;
+}
+
+static const char *parse_digits(const char *p) {
+    const char *begin = p;
+    while (isdigit((unsigned char)*p))
+        p++;
+    return p == begin ? NULL : p;
+}
+
+// Parses a number in the JSON grammar. Returns the end of the number, or NULL.
+static const char *parse_number(const char *p) {
+    if (*p == '-')
+        p++;
+    // Leading zeros are not allowed.
+    if (*p == '0')
+        p++;
+    else if ((p = parse_digits(p)) == NULL)
+        return NULL;
+    if (*p == '.' && (p = parse_digits(p + 1)) == NULL)
+        return NULL;
+    if (*p == 'e' || *p == 'E') {
+        p++;
+        if (*p == '+' || *p == '-')
+            p++;
+        p = parse_digits(p);
+    }
+    return p;
+}
+
+// Parses a number, true, false, or null. Returns the end of the value, or NULL.
+static const char *parse_literal(const char *p) {
+    const char *words[] = { "true", "false", "null" };
+    for (int i = 0; i < 3; i++) {
+        size_t size = strlen(words[i]);
+        if (strncmp(p, words[i], size) == 0)
+            return p + size;
+    }
+    return parse_number(p);
+}
+
+// Parses a string or a literal, and copies the raw JSON to *raw.
+static const char *parse_raw_value(const char *p, char **raw) {
+    const char *end = *p == '"' ? parse_string(p, NULL) : parse_literal(p);
+    if (end == NULL)
+        return NULL;
+    size_t size = (size_t)(end - p);
+    *raw = (char *)malloc(size + 1);
+    if (*raw == NULL)
+        return NULL;
+    memcpy(*raw, p, size);
+    (*raw)[size] = '\0';
+    return end;
+}
+
+static void init_request(ServeJob *job) {
+    job->args.swizzle = 1;
+    job->args.input_filename = NULL;
+    job->args.output_filename = NULL;
+    job->args.platform = SWIZ_PLATFORM_PS4;
+    job->args.gobs_height = 16;
+    job->id = NULL;
+    job->error = NULL;
+}
+
+static void free_job(ServeJob *job) {
+    free((char *)job->args.input_filename);
+    free((char *)job->args.output_filename);
+    free(job->id);
+    free(job);
+}
+
+static void free_jobs(ServeJob *jobs) {
+    while (jobs != NULL) {
+        ServeJob *next = jobs->next;
+        free_job(jobs);
+        jobs = next;
+    }
+}
+
+// Parses a value of a job. Returns the end of the value, or NULL.
+// *has_command will be set when the value of "command" is valid.
+static const char *parse_field(const char *p, const char *key, ServeJob *job,
+                               int *has_command) {
+    if (strcmp(key, "id") == 0) {
+        free(job->id);
+        job->id = NULL;
+        return parse_raw_value(p, &job->id);
+    }
+    if (strcmp(key, "gobs_height") == 0) {
+        char *value;
+        const char *end = parse_raw_value(p, &value);
+        if (end != NULL && !parseGobsHeight(value, &job->args.gobs_height))
+            job->error = "The max height of GOB blocks should be 1, 2, 4, 8, 16, or 32.";
+        free(end != NULL ? value : NULL);
+        return end;
+    }
+
+    int is_known = strcmp(key, "command") == 0 || strcmp(key, "platform") == 0 ||
+                   strcmp(key, "input") == 0 || strcmp(key, "output") == 0;
+    char *value = NULL;
+    const char *end = *p == '"' ? parse_string(p, &value) : parse_literal(p);
+    if (end == NULL)
+        return NULL;
+    if (value == NULL) {
+        if (is_known)
+            job->error = "command, input, output, and platform should be strings.";
+        return end;  // Ignore non-string values of unknown fields.
+    }
+    if (strcmp(key, "command") == 0) {
+        if (parseCommand(value, &job->args.swizzle))
+            *has_command = 1;
+        else
+            job->error = "Unknown command.";
+    } else if (strcmp(key, "platform") == 0) {
+        if (!parsePlatform(value, &job->args.platform))
+            job->error = "Unknown platform.";
+    } else if (strcmp(key, "input") == 0) {
+        free((char *)job->args.input_filename);
+        job->args.input_filename = value;
+        return end;
+    } else if (strcmp(key, "output") == 0) {
+        free((char *)job->args.output_filename);
+        job->args.output_filename = value;
+        return end;
+    }
+    free(value);
+    return end;
+}
+
+// Parses a job object. Returns the end of the object, or NULL when it's invalid JSON.
+static const char *parse_request(const char *p, ServeJob *job) {
+    init_request(job);
+    if (*p != '{')
+        return NULL;
+    p = skip_space(p + 1);
+    int has_command = 0;
+    while (*p != '}') {
+        char *key;
+        p = parse_string(p, &key);
+        if (p == NULL)
+            return NULL;
+        p = skip_space(p);
+        if (*p != ':') {
+            free(key);
+            return NULL;
+        }
+        p = parse_field(skip_space(p + 1), key, job, &has_command);
+        free(key);
+        if (p == NULL)
+            return NULL;
+        p = skip_space(p);
+        if (*p == ',') {
+            p = skip_space(p + 1);
+            if (*p == '}')
+                return NULL;  // Trailing commas are not JSON.
+        } else if (*p != '}') {
+            return NULL;
+        }
+    }
+    if (job->error == NULL && (!has_command || job->args.input_filename == NULL ||
+                               job->args.output_filename == NULL))
+        job->error = "A job needs command, input, and output.";
+    return p + 1;
+}
+
+// Parses a line into a list of jobs. Returns zero when it's invalid JSON.
+static int parse_line(const char *line, ServeJob **jobs) {
+    *jobs = NULL;
+    ServeJob **tail = jobs;
+    const char *p = skip_space(line);
+    if (*p == '\0')
+        return 1;
+    int is_array = *p == '[';
+    if (is_array)
+        p = skip_space(p + 1);
+    while (!is_array || *p != ']') {
+        ServeJob *job = (ServeJob *)malloc(sizeof(ServeJob));
+        if (job == NULL) {
+            p = NULL;
+            break;
+        }
+        p = parse_request(p, job);
+        job->next = NULL;
+        *tail = job;
+        tail = &job->next;
+        if (p == NULL)
+            break;
+        p = skip_space(p);
+        if (!is_array)
+            break;
+        if (*p == ',') {
+            p = skip_space(p + 1);
+            if (*p == ']')
+                p = NULL;  // Trailing commas are not JSON.
+        } else if (*p != ']') {
+            p = NULL;
+        }
+        if (p == NULL)
+            break;
+    }
+    if (p != NULL && is_array)
+        p = skip_space(p + 1);
+    if (p == NULL || *p != '\0') {
+        free_jobs(*jobs);
+        *jobs = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+static int64_t to_us(double seconds) {
+    return (int64_t)(seconds * 1e6);
+}
+
+// Writes a completion record. Times are in microseconds.
+static void write_record(FILE *output, const char *id, const char *error,
+                         const ConvertJob *job, double map_time, double convert_time,
+                         double total_time) {
+    fprintf(output, "{\"id\":%s,\"status\":\"%s\"", id != NULL ? id : "null",
+            error == NULL ? "ok" : "error");
+    if (error != NULL) {
+        fprintf(output, ",\"error\":");
+        writeJsonString(output, error);
+    }
+    if (job != NULL) {
+        fprintf(output, ",\"input\":");
+        writeJsonString(output, job->args.input_filename);
+        fprintf(output, ",\"output\":");
+        writeJsonString(output, job->args.output_filename);
+        fprintf(output, ",\"read_bytes\":%" PRIu64 ",\"written_bytes\":%" PRIu64,
+                (uint64_t)job->input.size, (uint64_t)job->output.size);
+        fprintf(output, ",\"map_us\":%" PRId64 ",\"convert_us\":%" PRId64
+                ",\"total_us\":%" PRId64, to_us(map_time), to_us(convert_time),
+                to_us(total_time));
+    }
+    fprintf(output, "}\n");
+}
+
+// Writes a record of a job that has completed, and frees the job.
+static void finish_job(ServeJob *request, const char *error, const ConvertJob *job,
+                       double map_time, double convert_time) {
+    Client *client = request->client;
+    MUTEX_LOCK(&client->mutex);
+    write_record(client->output, request->id, error, job, map_time, convert_time,
+                 getTime() - request->start);
+    fflush(client->output);
+    client->pending_jobs--;
+    COND_BROADCAST(&client->cond);
+    MUTEX_UNLOCK(&client->mutex);
+    free_job(request);
+}
+
+static void run_job(Server *server, ServeJob *request) {
+    ConvertJob job;
+    double map_start = getTime();
+    int mapped = beginConvertJob(&job, &request->args, &server->cache);
+    double convert_start = getTime();
+    if (mapped)
+        runConvertJob(&job);
+    double convert_time = getTime() - convert_start;
+
+    // Sizes are cleared when files are unmapped.
+    ConvertJob result = job;
+    endConvertJob(&job);
+    if (job.error != NULL)
+        result.input.size = result.output.size = 0;
+    finish_job(request, job.error, &result, convert_start - map_start, convert_time);
+}
+
+// Takes jobs from the queue until the server stops.
+static void serve_jobs(void *arg) {
+    Server *server = (Server *)arg;
+    while (1) {
+        MUTEX_LOCK(&server->mutex);
+        while (server->first_job == NULL && !server->stopping)
+            COND_WAIT(&server->cond, &server->mutex);
+        ServeJob *job = server->first_job;
+        if (job != NULL) {
+            server->first_job = job->next;
+            if (server->first_job == NULL)
+                server->last_job = NULL;
+        }
+        MUTEX_UNLOCK(&server->mutex);
+        if (job == NULL)
+            break;
+        run_job(server, job);
+    }
+}
+
+// Queues jobs of a line. Jobs with errors are answered right away.
+static void queue_jobs(Server *server, Client *client, ServeJob *jobs, double start) {
+    ServeJob *first = NULL;
+    ServeJob *last = NULL;
+    while (jobs != NULL) {
+        ServeJob *job = jobs;
+        jobs = job->next;
+        job->client = client;
+        job->start = start;
+        job->next = NULL;
+        MUTEX_LOCK(&client->mutex);
+        client->pending_jobs++;
+        MUTEX_UNLOCK(&client->mutex);
+        if (job->error != NULL) {
+            finish_job(job, job->error, NULL, 0, 0);
+        } else if (server->worker_count == 0) {
+            run_job(server, job);  // No threads could be created.
+        } else {
+            if (last != NULL)
+                last->next = job;
+            else
+                first = job;
+            last = job;
+        }
+    }
+    if (first == NULL)
+        return;
+
+    MUTEX_LOCK(&server->mutex);
+    if (server->last_job != NULL)
+        server->last_job->next = first;
+    else
+        server->first_job = first;
+    server->last_job = last;
+    COND_BROADCAST(&server->cond);
+    MUTEX_UNLOCK(&server->mutex);
+}
+
+// Reads lines until the end of the input, and waits for records of the jobs.
+static void serve_stream(Server *server, FILE *input, FILE *output) {
+    Client client;
+    client.output = output;
+    MUTEX_INIT(&client.mutex);
+    COND_INIT(&client.cond);
+    client.pending_jobs = 0;
+
+    char *line;
+    while ((line = readLine(input)) != NULL) {
+        double start = getTime();
+        ServeJob *jobs;
+        int ok = parse_line(line, &jobs);
+        free(line);
+        if (!ok) {
+            MUTEX_LOCK(&client.mutex);
+            write_record(output, NULL, "Invalid JSON.", NULL, 0, 0, 0);
+            fflush(output);
+            MUTEX_UNLOCK(&client.mutex);
+            continue;
+        }
+        queue_jobs(server, &client, jobs, start);
+    }
+
+    // Workers write records to the output. So, it should be kept until they finish.
+    MUTEX_LOCK(&client.mutex);
+    while (client.pending_jobs > 0)
+        COND_WAIT(&client.cond, &client.mutex);
+    MUTEX_UNLOCK(&client.mutex);
+    COND_DESTROY(&client.cond);
+    MUTEX_DESTROY(&client.mutex);
+}
+
+#ifdef _WIN32
+
+static int serve_socket(Server *server, const char *socket_path) {
+    (void)server;
+    (void)socket_path;
+    fprintf(stderr, "Unix domain sockets are not supported on this platform.\n");
+    return 1;
+}
+
+#else  // _WIN32
+
+// A socket client that is served on its own thread.
+typedef struct SocketClient {
+    Server *server;
+    int fd;
+} SocketClient;
+
+static void serve_client(void *arg) {
+    SocketClient *client = (SocketClient *)arg;
+    int client_out = dup(client->fd);
+    FILE *input = fdopen(client->fd, "r");
+    FILE *output = client_out >= 0 ? fdopen(client_out, "w") : NULL;
+    if (input != NULL && output != NULL)
+        serve_stream(client->server, input, output);
+    if (input != NULL)
+        fclose(input);
+    else
+        close(client->fd);
+    if (output != NULL)
+        fclose(output);
+    else if (client_out >= 0)
+        close(client_out);
+
+    Server *server = client->server;
+    free(client);
+    MUTEX_LOCK(&server->mutex);
+    server->client_count--;
+    COND_BROADCAST(&server->cond);
+    MUTEX_UNLOCK(&server->mutex);
+}
+
+// Each client is served on its own thread. Jobs of all clients share the workers.
+static int serve_socket(Server *server, const char *socket_path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "The socket path is too long. (%s)\n", socket_path);
+        return 1;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to make a socket.\n");
+        return 1;
+    }
+    unlink(socket_path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+        fprintf(stderr, "Failed to listen on the socket. (%s)\n", socket_path);
+        close(fd);
+        return 1;
+    }
+    // Don't exit when a client disconnects before reading records.
+    signal(SIGPIPE, SIG_IGN);
+    fprintf(stderr, "Listening on %s...\n", socket_path);
+
+    while (1) {
+        int client_fd = accept(fd, NULL, NULL);
+        if (client_fd < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        SocketClient *client = (SocketClient *)malloc(sizeof(SocketClient));
+        if (client == NULL) {
+            close(client_fd);
+            continue;
+        }
+        client->server = server;
+        client->fd = client_fd;
+        MUTEX_LOCK(&server->mutex);
+        server->client_count++;
+        MUTEX_UNLOCK(&server->mutex);
+        // When a thread can't be created, the client is served on this thread.
+        Thread thread;
+        if (createThread(&thread, serve_client, client))
+            detachThread(thread);
+        else
+            serve_client(client);
+    }
+    close(fd);
+    unlink(socket_path);
+
+    // Clients use the server until they leave.
+    MUTEX_LOCK(&server->mutex);
+    while (server->client_count > 0)
+        COND_WAIT(&server->cond, &server->mutex);
+    MUTEX_UNLOCK(&server->mutex);
+    return 1;
+}
+
+#endif  // _WIN32
+
+int runServer(const char *socket_path, int thread_count) {
+    int worker_count = thread_count > 0 ? thread_count : getProcessorCount();
+    Server *server = (Server *)malloc(sizeof(Server));
+    Thread *workers = (Thread *)malloc(sizeof(Thread) * worker_count);
+    if (server == NULL || workers == NULL) {
+        fprintf(stderr, "Memory allocation error.\n");
+        free(server);
+        free(workers);
+        return 1;
+    }
+    initPlanCache(&server->cache);
+    MUTEX_INIT(&server->mutex);
+    COND_INIT(&server->cond);
+    server->first_job = NULL;
+    server->last_job = NULL;
+    server->client_count = 0;
+    server->stopping = 0;
+    server->worker_count = 0;
+    // When no threads can be created, clients convert their jobs by themselves.
+    while (server->worker_count < worker_count &&
+           createThread(&workers[server->worker_count], serve_jobs, server))
+        server->worker_count++;
+
+    int ret = 0;
+    if (socket_path != NULL)
+        ret = serve_socket(server, socket_path);
+    else
+        serve_stream(server, stdin, stdout);
+
+    MUTEX_LOCK(&server->mutex);
+    server->stopping = 1;
+    COND_BROADCAST(&server->cond);
+    MUTEX_UNLOCK(&server->mutex);
+    for (int i = 0; i < server->worker_count; i++)
+        joinThread(workers[i]);
+
+    freePlanCache(&server->cache);
+    COND_DESTROY(&server->cond);
+    MUTEX_DESTROY(&server->mutex);
+    free(workers);
+    free(server);
+    return ret;
+}
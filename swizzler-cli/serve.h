@@ -0,0 +1,14 @@
+#ifndef __SWIZZLER_CLI_SERVE_H__
+#define __SWIZZLER_CLI_SERVE_H__
+
+// Serves jobs from stdin, or from clients of a Unix domain socket when socket_path is not NULL.
+// Jobs are newline-delimited JSON. A line is a job object or an array of jobs.
+//   {"id": 1, "command": "swizzle", "input": "a.dds", "output": "b.dds",
+//    "platform": "switch", "gobs_height": 8}
+// Jobs of all lines and clients go to a queue, and worker threads convert them concurrently.
+// A completion record is written for each job as soon as it completes.
+// The workers and plans are kept while serving, so small jobs don't pay for them.
+// Returns non-zero when it failed to start.
+int runServer(const char *socket_path, int thread_count);
+
+#endif  // __SWIZZLER_CLI_SERVE_H__
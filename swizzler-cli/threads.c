@@ -0,0 +1,71 @@
+// sysconf is not in C99.
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include <stdlib.h>
+#include "threads.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+typedef struct ThreadStart {
+    void (*func)(void *arg);
+    void *arg;
+} ThreadStart;
+
+#ifdef _WIN32
+static DWORD WINAPI thread_main(LPVOID arg) {
+#else
+static void *thread_main(void *arg) {
+#endif
+    ThreadStart start = *(ThreadStart *)arg;
+    free(arg);
+    start.func(start.arg);
+    return 0;
+}
+
+int createThread(Thread *thread, void (*func)(void *arg), void *arg) {
+    ThreadStart *start = (ThreadStart *)malloc(sizeof(ThreadStart));
+    if (start == NULL)
+        return 0;
+    start->func = func;
+    start->arg = arg;
+#ifdef _WIN32
+    *thread = CreateThread(NULL, 0, thread_main, start, 0, NULL);
+    int ok = *thread != NULL;
+#else
+    int ok = pthread_create(thread, NULL, thread_main, start) == 0;
+#endif
+    if (!ok)
+        free(start);
+    return ok;
+}
+
+void joinThread(Thread thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+void detachThread(Thread thread) {
+#ifdef _WIN32
+    CloseHandle(thread);
+#else
+    pthread_detach(thread);
+#endif
+}
+
+int getProcessorCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? count : 1;
+#endif
+}
@@ -0,0 +1,52 @@
+#ifndef __SWIZZLER_CLI_THREADS_H__
+#define __SWIZZLER_CLI_THREADS_H__
+
+// Threads and locks for Win32 and pthreads.
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE Thread;
+typedef DWORD ThreadId;
+typedef CRITICAL_SECTION Mutex;
+typedef CONDITION_VARIABLE Cond;
+#define MUTEX_INIT(m) InitializeCriticalSection(m)
+#define MUTEX_DESTROY(m) DeleteCriticalSection(m)
+#define MUTEX_LOCK(m) EnterCriticalSection(m)
+#define MUTEX_UNLOCK(m) LeaveCriticalSection(m)
+#define COND_INIT(c) InitializeConditionVariable(c)
+#define COND_DESTROY(c)
+#define COND_WAIT(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#define COND_BROADCAST(c) WakeAllConditionVariable(c)
+#define GET_THREAD_ID() GetCurrentThreadId()
+#define THREAD_ID_EQUAL(a, b) ((a) == (b))
+#else
+#include <pthread.h>
+typedef pthread_t Thread;
+typedef pthread_t ThreadId;
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Cond;
+#define MUTEX_INIT(m) pthread_mutex_init(m, NULL)
+#define MUTEX_DESTROY(m) pthread_mutex_destroy(m)
+#define MUTEX_LOCK(m) pthread_mutex_lock(m)
+#define MUTEX_UNLOCK(m) pthread_mutex_unlock(m)
+#define COND_INIT(c) pthread_cond_init(c, NULL)
+#define COND_DESTROY(c) pthread_cond_destroy(c)
+#define COND_WAIT(c, m) pthread_cond_wait(c, m)
+#define COND_BROADCAST(c) pthread_cond_broadcast(c)
+#define GET_THREAD_ID() pthread_self()
+#define THREAD_ID_EQUAL(a, b) pthread_equal(a, b)
+#endif
+
+// Starts a thread that calls func(arg). Returns zero when it failed.
+int createThread(Thread *thread, void (*func)(void *arg), void *arg);
+
+// Waits until the thread ends.
+void joinThread(Thread thread);
+
+// Lets the thread free its resources when it ends. It can't be joined after it.
+void detachThread(Thread thread);
+
+// Gets the number of logical processors.
+int getProcessorCount(void);
+
+#endif  // __SWIZZLER_CLI_THREADS_H__
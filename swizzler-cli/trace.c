@@ -0,0 +1,134 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include "convert.h"
+#include "threads.h"
+#include "trace.h"
+
+// The max number of tracks. Spans of other threads go to the last track.
+#define MAX_TRACE_THREADS 64
+
+typedef struct Trace {
+    FILE *file;  // NULL if no traces are open
+    Mutex mutex;
+    double start;  // Time of openTrace(). Timestamps are relative to it.
+    ThreadId threads[MAX_TRACE_THREADS];  // Thread of each track. tid is index + 1.
+    int thread_count;
+    int event_count;
+} Trace;
+
+static Trace trace = { NULL };
+
+// Writes the separator of events. The mutex should be locked.
+static void begin_event(void) {
+    fprintf(trace.file, trace.event_count == 0 ? "\n" : ",\n");
+    trace.event_count++;
+}
+
+static void write_thread_name(int tid, const char *name) {
+    begin_event();
+    fprintf(trace.file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+            "\"args\":{\"name\":", tid);
+    writeJsonString(trace.file, name);
+    fprintf(trace.file, "}}");
+}
+
+// Gets the track of the calling thread. A new track gets the name, or a default one.
+// The mutex should be locked.
+static int get_tid(const char *name) {
+    ThreadId id = GET_THREAD_ID();
+    for (int i = 0; i < trace.thread_count; i++) {
+        if (THREAD_ID_EQUAL(trace.threads[i], id))
+            return i + 1;
+    }
+    if (trace.thread_count == MAX_TRACE_THREADS)
+        return MAX_TRACE_THREADS;
+    trace.threads[trace.thread_count++] = id;
+    int tid = trace.thread_count;
+    char default_name[32];
+    if (name == NULL) {
+        snprintf(default_name, sizeof(default_name), "thread %d", tid);
+        name = default_name;
+    }
+    write_thread_name(tid, name);
+    return tid;
+}
+
+int openTrace(const char *filename) {
+    FILE *file = fopen(filename, "w");
+    if (file == NULL)
+        return 0;
+    MUTEX_INIT(&trace.mutex);
+    trace.file = file;
+    trace.start = getTime();
+    trace.thread_count = 0;
+    trace.event_count = 0;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    begin_event();
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+            "\"args\":{\"name\":\"swizzler-cli\"}}");
+    setTraceThreadName("main");
+    return 1;
+}
+
+int closeTrace(void) {
+    if (trace.file == NULL)
+        return 1;
+    fprintf(trace.file, "\n]}\n");
+    int ok = !ferror(trace.file);
+    if (fclose(trace.file) != 0)
+        ok = 0;
+    trace.file = NULL;
+    MUTEX_DESTROY(&trace.mutex);
+    return ok;
+}
+
+int isTracing(void) {
+    return trace.file != NULL;
+}
+
+void setTraceThreadName(const char *name) {
+    if (trace.file == NULL)
+        return;
+    MUTEX_LOCK(&trace.mutex);
+    int count = trace.thread_count;
+    int tid = get_tid(name);
+    // Rename the track if the thread already had one.
+    if (trace.thread_count == count)
+        write_thread_name(tid, name);
+    MUTEX_UNLOCK(&trace.mutex);
+}
+
+// Writes the common fields of a span. The mutex should be locked.
+static void begin_span(const char *name, double start, double end) {
+    int tid = get_tid(NULL);
+    begin_event();
+    fprintf(trace.file, "{\"name\":");
+    writeJsonString(trace.file, name);
+    fprintf(trace.file, ",\"cat\":\"swizzler-cli\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+            "\"pid\":1,\"tid\":%d", (start - trace.start) * 1e6, (end - start) * 1e6, tid);
+}
+
+void traceSpan(const char *name, double start, double end, const char *filename) {
+    if (trace.file == NULL)
+        return;
+    MUTEX_LOCK(&trace.mutex);
+    begin_span(name, start, end);
+    if (filename != NULL) {
+        fprintf(trace.file, ",\"args\":{\"file\":");
+        writeJsonString(trace.file, filename);
+        fprintf(trace.file, "}");
+    }
+    fprintf(trace.file, "}");
+    MUTEX_UNLOCK(&trace.mutex);
+}
+
+void traceSubresourceSpan(const char *name, double start, double end,
+                          int mip, int slice, uint64_t size) {
+    if (trace.file == NULL)
+        return;
+    MUTEX_LOCK(&trace.mutex);
+    begin_span(name, start, end);
+    fprintf(trace.file, ",\"args\":{\"mip\":%d,\"slice\":%d,\"bytes\":%" PRIu64 "}}",
+            mip, slice, size);
+    MUTEX_UNLOCK(&trace.mutex);
+}
@@ -0,0 +1,29 @@
+#ifndef __SWIZZLER_CLI_TRACE_H__
+#define __SWIZZLER_CLI_TRACE_H__
+#include <stdint.h>
+
+// Spans are written as Chrome trace events. Perfetto and chrome://tracing can open the file.
+// Each thread that records spans gets its own track. Times are from getTime().
+// All functions are thread-safe, and do nothing while a trace is not open.
+
+// Starts writing a trace. The calling thread will be the "main" track.
+// Returns zero if it can't open the file.
+int openTrace(const char *filename);
+
+// Finishes the trace file. Returns zero if it failed to write the file.
+int closeTrace(void);
+
+// Returns non-zero if a trace is open.
+int isTracing(void);
+
+// Names the track of the calling thread.
+void setTraceThreadName(const char *name);
+
+// Records a span on the track of the calling thread. filename can be NULL.
+void traceSpan(const char *name, double start, double end, const char *filename);
+
+// Records a span that works on a range of a subresource.
+void traceSubresourceSpan(const char *name, double start, double end,
+                          int mip, int slice, uint64_t size);
+
+#endif  // __SWIZZLER_CLI_TRACE_H__
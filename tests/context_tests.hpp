@@ -94,6 +94,105 @@ TEST_F(ContextTest, swizContextSetGobsHeight) {
     }
 }
 
+TEST_F(ContextTest, swizContextSetThreadCount) {
+    std::vector<std::pair<int, unsigned int>> cases = {
+        { 1, SWIZ_OK },
+        { 4, SWIZ_OK },
+        { 0, SWIZ_OK },
+        { -1, SWIZ_ERROR_INVALID_THREAD_COUNT },
+    };
+    for (auto c : cases) {
+        swizContextInit(context);
+        EXPECT_EQ(c.second, swizContextSetThreadCount(context, c.first));
+    }
+}
+
+TEST_F(ContextTest, swizContextSetKernelVariant) {
+    ASSERT_EQ(SWIZ_OK, swizContextSetKernelVariant(context, SWIZ_KERNEL_AUTO));
+    ASSERT_NE(SWIZ_KERNEL_AUTO, swizContextGetKernelVariant(context));
+    ASSERT_EQ(SWIZ_OK, swizContextSetKernelVariant(context, SWIZ_KERNEL_SCALAR));
+    ASSERT_EQ(SWIZ_KERNEL_SCALAR, swizContextGetKernelVariant(context));
+    ASSERT_EQ(SWIZ_ERROR_UNSUPPORTED_KERNEL_VARIANT,
+              swizContextSetKernelVariant(context, SWIZ_KERNEL_MAX));
+}
+
+TEST_F(ContextTest, swizContextSetWorkspace) {
+    swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
+    swizContextSetTextureSize(context, 16, 16);
+    swizContextSetBlockInfo(context, 4, 4, 8);
+    SwizPlan *plan = swizNewPlan(context);
+    ASSERT_NE(nullptr, plan);
+    std::vector<uint8_t> data(swizPlanGetUnswizzledSize(plan));
+    std::vector<uint8_t> swizzled(swizPlanGetSwizzledSize(plan));
+    SwizJob jobs[] = {
+        { plan, data.data(), swizzled.data(), SWIZ_OK },
+        { plan, data.data(), swizzled.data(), SWIZ_OK },
+    };
+
+    // The context should use the workspace instead of allocating scratch memory.
+    std::vector<uint8_t> workspace(swizGetBatchWorkspaceSize(2));
+    ASSERT_EQ(SWIZ_OK, swizContextSetWorkspace(context, workspace.data(), workspace.size()));
+    ASSERT_EQ(SWIZ_OK, swizContextSetStatsEnabled(context, 1));
+    ASSERT_EQ(SWIZ_OK, swizDoSwizzleBatch(jobs, 2, context));
+    SwizStats stats;
+    ASSERT_EQ(SWIZ_OK, swizContextGetStats(context, &stats));
+    ASSERT_EQ(0, stats.scratch_bytes_allocated);
+
+    // Without the workspace, the context allocates scratch memory.
+    ASSERT_EQ(SWIZ_OK, swizContextSetWorkspace(context, NULL, 0));
+    ASSERT_EQ(SWIZ_OK, swizDoSwizzleBatch(jobs, 2, context));
+    ASSERT_EQ(SWIZ_OK, swizContextGetStats(context, &stats));
+    ASSERT_EQ(swizGetBatchWorkspaceSize(2), stats.scratch_bytes_allocated);
+    swizFreePlan(plan);
+}
+
+TEST_F(ContextTest, swizGetBatchWorkspaceSize) {
+    ASSERT_EQ(0, swizGetBatchWorkspaceSize(0));
+    ASSERT_EQ(0, swizGetBatchWorkspaceSize(-1));
+    ASSERT_LT(0, swizGetBatchWorkspaceSize(1));
+    ASSERT_EQ(swizGetBatchWorkspaceSize(1) * 1000, swizGetBatchWorkspaceSize(1000));
+}
+
+TEST_F(ContextTest, swizContextGetStatsDisabled) {
+    SwizStats stats;
+    ASSERT_EQ(SWIZ_OK, swizContextGetStats(context, &stats));
+    ASSERT_EQ(0, stats.call_count);
+    ASSERT_EQ(0, stats.mip_count);
+    ASSERT_EQ(SWIZ_ERROR_NULL_POINTER, swizContextGetStats(context, NULL));
+}
+
+TEST_F(ContextTest, swizContextGetStats) {
+    swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
+    swizContextSetTextureSize(context, 4, 4);
+    swizContextSetHasMips(context, 1);
+    swizContextSetBlockInfo(context, 4, 4, 16);
+    swizContextSetThreadCount(context, 2);
+    ASSERT_EQ(SWIZ_OK, swizContextSetStatsEnabled(context, 1));
+    uint8_t data[16 * 3] = { 0 };
+    uint8_t swizzled[32 * 32 * 3] = { 0 };
+    ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data, swizzled, context));
+    ASSERT_EQ(SWIZ_OK, swizDoUnswizzle(swizzled, data, context));
+
+    SwizStats stats;
+    ASSERT_EQ(SWIZ_OK, swizContextGetStats(context, &stats));
+    ASSERT_EQ(2, stats.call_count);
+    ASSERT_EQ(sizeof(data) + sizeof(swizzled), stats.bytes_read);
+    ASSERT_EQ(sizeof(swizzled) + sizeof(data), stats.bytes_written);
+    // Each mipmap has a block, and it's padded to 8x8 blocks.
+    ASSERT_EQ(sizeof(swizzled) - sizeof(data), stats.padding_bytes);
+    ASSERT_EQ(swizContextGetKernelVariant(context), stats.kernel_variant);
+    ASSERT_EQ(3, stats.mip_count);
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(16 + 32 * 32, stats.mips[i].bytes_read);
+        ASSERT_EQ(32 * 32 - 16, stats.mips[i].padding_bytes);
+    }
+
+    swizContextResetStats(context);
+    ASSERT_EQ(SWIZ_OK, swizContextGetStats(context, &stats));
+    ASSERT_EQ(0, stats.call_count);
+    ASSERT_EQ(SWIZ_OK, swizContextSetStatsEnabled(context, 0));
+}
+
 TEST_F(ContextTest, swizGetSwizzledSize) {
     swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
     swizContextSetTextureSize(context, 128, 128);
@@ -162,6 +261,30 @@ TEST_F(ContextTest, swizGetUnswizzledSizeUncompressed) {
     ASSERT_EQ(106576, data_size);
 }
 
+TEST_F(ContextTest, swizGetSize64) {
+    // 16K BC7 with mipmaps x 64 slices is larger than 4 GiB.
+    swizContextSetPlatform(context, SWIZ_PLATFORM_SWITCH);
+    swizContextSetTextureSize(context, 16384, 16384);
+    swizContextSetHasMips(context, 1);
+    swizContextSetArraySize(context, 64);
+    swizContextSetBlockInfo(context, 4, 4, 16);
+    uint64_t slice_size = 0;
+    for (int i = 4096; i >= 1; i /= 2)
+        slice_size += (uint64_t)i * i * 16;
+    slice_size += 16 * 2;  // 2x2 and 1x1 mipmaps also use a block.
+    ASSERT_EQ(slice_size * 64, swizGetUnswizzledSize64(context));
+    ASSERT_LE(slice_size * 64, swizGetSwizzledSize64(context));
+
+    SwizSubresourceInfo info;
+    ASSERT_EQ(SWIZ_OK, swizGetSubresourceInfo(context, 0, 63, &info));
+    ASSERT_EQ(slice_size * 63, info.data_offset);
+    ASSERT_EQ(SWIZ_OK, swizContextGetLastError(context));
+
+    // 32-bit functions should not return wrapped-around sizes.
+    ASSERT_EQ(0, swizGetUnswizzledSize(context));
+    ASSERT_EQ(SWIZ_ERROR_SIZE_OVERFLOW, swizContextGetLastError(context));
+}
+
 TEST_F(ContextTest, swizGetUnswizzledSizeError) {
     swizContextSetPlatform(context, SWIZ_PLATFORM_UNK);
     swizContextSetTextureSize(context, 100, 200);
@@ -171,6 +294,41 @@ TEST_F(ContextTest, swizGetUnswizzledSizeError) {
     ASSERT_EQ(0, data_size);
 }
 
+TEST_F(ContextTest, swizGetSizeAfterSetter) {
+    swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
+    swizContextSetTextureSize(context, 128, 128);
+    swizContextSetBlockInfo(context, 4, 4, 8);
+    ASSERT_EQ(32 * 32 * 8, swizGetUnswizzledSize(context));
+    // The cached layout should be updated.
+    swizContextSetArraySize(context, 2);
+    ASSERT_EQ(32 * 32 * 8 * 2, swizGetUnswizzledSize(context));
+    swizContextSetTextureSize(context, 64, 64);
+    ASSERT_EQ(16 * 16 * 8 * 2, swizGetUnswizzledSize(context));
+}
+
+TEST_F(ContextTest, swizGetSubresourceInfo) {
+    swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
+    swizContextSetTextureSize(context, 128, 128);
+    swizContextSetHasMips(context, 1);
+    swizContextSetArraySize(context, 2);
+    swizContextSetBlockInfo(context, 4, 4, 16);
+    ASSERT_EQ(8, swizGetMipCount(context));
+
+    SwizSubresourceInfo info;
+    ASSERT_EQ(SWIZ_OK, swizGetSubresourceInfo(context, 1, 1, &info));
+    ASSERT_EQ(64, info.width);
+    ASSERT_EQ(64, info.height);
+    uint32_t slice_size = swizGetUnswizzledSize(context) / 2;
+    ASSERT_EQ(slice_size + 32 * 32 * 16, info.data_offset);
+    ASSERT_EQ(16 * 16 * 16, info.data_size);
+    ASSERT_EQ(swizGetSwizzledSize(context) / 2 + 32 * 32 * 16, info.swizzled_offset);
+    ASSERT_EQ(16 * 16 * 16, info.swizzled_size);
+
+    ASSERT_EQ(SWIZ_ERROR_OUT_OF_RANGE, swizGetSubresourceInfo(context, 8, 0, &info));
+    ASSERT_EQ(SWIZ_ERROR_OUT_OF_RANGE, swizGetSubresourceInfo(context, 0, 2, &info));
+    ASSERT_EQ(SWIZ_ERROR_NULL_POINTER, swizGetSubresourceInfo(context, 0, 0, NULL));
+}
+
 TEST_F(ContextTest, swizAllocUnswizzledData) {
     swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
     swizContextSetTextureSize(context, 128, 128);
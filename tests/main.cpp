@@ -3,6 +3,8 @@
 #include "util_tests.hpp"
 #include "context_tests.hpp"
 #include "swizzle_tests.hpp"
+#include "plan_tests.hpp"
+#include "stream_tests.hpp"
 
 int main(int argc, char* argv[]) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,240 @@
+#pragma once
+#include <gtest/gtest.h>
+#include <string.h>
+#include <vector>
+#include "console-swizzler.h"
+
+class PlanTest : public ::testing::Test {
+ protected:
+    virtual void SetUp() {
+        context = swizNewContext();
+        ASSERT_NE(nullptr, context);
+    }
+
+    virtual void TearDown() {
+        swizFreeContext(context);
+    }
+
+    SwizContext *context;
+};
+
+TEST_F(PlanTest, swizNewPlanError) {
+    swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
+    swizContextSetTextureSize(context, 128, 128);
+    SwizPlan *plan = swizNewPlan(context);
+    ASSERT_EQ(nullptr, plan);
+    ASSERT_EQ(SWIZ_ERROR_INVALID_BLOCK_INFO, swizContextGetLastError(context));
+}
+
+TEST_F(PlanTest, swizFreePlanNull) {
+    swizFreePlan(NULL);
+}
+
+TEST_F(PlanTest, swizPlanGetSize) {
+    swizContextSetPlatform(context, SWIZ_PLATFORM_SWITCH);
+    swizContextSetTextureSize(context, 100, 200);
+    swizContextSetHasMips(context, 1);
+    swizContextSetArraySize(context, 3);
+    swizContextSetBlockInfo(context, 1, 1, 4);
+    SwizPlan *plan = swizNewPlan(context);
+    ASSERT_NE(nullptr, plan);
+    ASSERT_EQ(swizGetSwizzledSize(context), swizPlanGetSwizzledSize(plan));
+    ASSERT_EQ(swizGetUnswizzledSize(context), swizPlanGetUnswizzledSize(plan));
+    swizFreePlan(plan);
+}
+
+TEST_F(PlanTest, swizPlanDoSwizzle) {
+    swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
+    swizContextSetTextureSize(context, 200, 100);
+    swizContextSetHasMips(context, 1);
+    swizContextSetArraySize(context, 2);
+    swizContextSetBlockInfo(context, 4, 4, 8);
+    SwizPlan *plan = swizNewPlan(context);
+    ASSERT_NE(nullptr, plan);
+
+    std::vector<uint8_t> data(swizPlanGetUnswizzledSize(plan));
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)(i * 7);
+    std::vector<uint8_t> expected(swizPlanGetSwizzledSize(plan));
+    std::vector<uint8_t> swizzled(swizPlanGetSwizzledSize(plan));
+    std::vector<uint8_t> unswizzled(swizPlanGetUnswizzledSize(plan));
+
+    ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), expected.data(), context));
+    ASSERT_EQ(SWIZ_OK, swizPlanDoSwizzle(data.data(), swizzled.data(), plan));
+    ASSERT_EQ(expected, swizzled);
+    ASSERT_EQ(SWIZ_OK, swizPlanDoUnswizzle(swizzled.data(), unswizzled.data(), plan));
+    ASSERT_EQ(data, unswizzled);
+
+    // A plan should not depend on the context after it was built.
+    swizContextInit(context);
+    ASSERT_EQ(SWIZ_OK, swizPlanDoSwizzle(data.data(), swizzled.data(), plan));
+    ASSERT_EQ(expected, swizzled);
+    swizFreePlan(plan);
+}
+
+TEST_F(PlanTest, swizPlanDoSwizzleNull) {
+    swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
+    swizContextSetTextureSize(context, 1, 1);
+    swizContextSetBlockInfo(context, 1, 1, 1);
+    SwizPlan *plan = swizNewPlan(context);
+    ASSERT_NE(nullptr, plan);
+    uint8_t data[1] = { 0 };
+    ASSERT_EQ(SWIZ_ERROR_NULL_POINTER, swizPlanDoSwizzle(&data[0], NULL, plan));
+    ASSERT_EQ(SWIZ_ERROR_NULL_POINTER, swizPlanDoUnswizzle(NULL, &data[0], plan));
+    // Errors of plans should not affect the context.
+    ASSERT_EQ(SWIZ_OK, swizContextGetLastError(context));
+    swizFreePlan(plan);
+}
+
+TEST_F(PlanTest, swizDoSwizzleBatch) {
+    // Mixed large and small textures
+    std::vector<SwizPlan *> plans;
+    int sizes[][2] = { { 1024, 512 }, { 16, 16 }, { 300, 7 }, { 64, 64 } };
+    for (auto size : sizes) {
+        swizContextInit(context);
+        swizContextSetPlatform(context, plans.size() % 2 ? SWIZ_PLATFORM_SWITCH
+                                                         : SWIZ_PLATFORM_PS4);
+        swizContextSetTextureSize(context, size[0], size[1]);
+        swizContextSetHasMips(context, 1);
+        swizContextSetBlockInfo(context, 1, 1, 4);
+        plans.push_back(swizNewPlan(context));
+        ASSERT_NE(nullptr, plans.back());
+    }
+    ASSERT_EQ(SWIZ_OK, swizContextSetThreadCount(context, 3));
+
+    size_t job_count = plans.size() * 2;
+    std::vector<std::vector<uint8_t>> data(job_count);
+    std::vector<std::vector<uint8_t>> swizzled(job_count);
+    std::vector<std::vector<uint8_t>> unswizzled(job_count);
+    std::vector<SwizJob> jobs(job_count);
+    for (size_t i = 0; i < job_count; i++) {
+        SwizPlan *plan = plans[i % plans.size()];
+        data[i].resize(swizPlanGetUnswizzledSize(plan));
+        for (size_t j = 0; j < data[i].size(); j++)
+            data[i][j] = (uint8_t)(j * 3 + i);
+        swizzled[i].resize(swizPlanGetSwizzledSize(plan));
+        unswizzled[i].resize(swizPlanGetUnswizzledSize(plan));
+        jobs[i] = { plan, data[i].data(), swizzled[i].data(), SWIZ_OK };
+    }
+    ASSERT_EQ(SWIZ_OK, swizDoSwizzleBatch(jobs.data(), (int)job_count, context));
+
+    for (size_t i = 0; i < job_count; i++) {
+        std::vector<uint8_t> expected(swizzled[i].size());
+        ASSERT_EQ(SWIZ_OK, swizPlanDoSwizzle(data[i].data(), expected.data(), jobs[i].plan));
+        ASSERT_EQ(expected, swizzled[i]);
+        jobs[i].src = swizzled[i].data();
+        jobs[i].dst = unswizzled[i].data();
+    }
+    ASSERT_EQ(SWIZ_OK, swizDoUnswizzleBatch(jobs.data(), (int)job_count, context));
+    for (size_t i = 0; i < job_count; i++)
+        ASSERT_EQ(data[i], unswizzled[i]);
+
+    for (SwizPlan *plan : plans)
+        swizFreePlan(plan);
+}
+
+TEST_F(PlanTest, swizDoSwizzleBatchError) {
+    swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
+    swizContextSetTextureSize(context, 32, 32);
+    swizContextSetBlockInfo(context, 4, 4, 8);
+    SwizPlan *plan = swizNewPlan(context);
+    ASSERT_NE(nullptr, plan);
+    std::vector<uint8_t> data(swizPlanGetUnswizzledSize(plan));
+    std::vector<uint8_t> swizzled(swizPlanGetSwizzledSize(plan));
+
+    // Each job gets its own error.
+    SwizJob jobs[] = {
+        { plan, data.data(), swizzled.data(), SWIZ_OK },
+        { plan, data.data(), NULL, SWIZ_OK },
+        { NULL, data.data(), swizzled.data(), SWIZ_OK },
+    };
+    ASSERT_EQ(SWIZ_ERROR_NULL_POINTER, swizDoSwizzleBatch(jobs, 3, context));
+    ASSERT_EQ(SWIZ_OK, jobs[0].error);
+    ASSERT_EQ(SWIZ_ERROR_NULL_POINTER, jobs[1].error);
+    ASSERT_EQ(SWIZ_ERROR_NULL_POINTER, jobs[2].error);
+    ASSERT_EQ(SWIZ_OK, swizContextGetLastError(context));
+
+    // The workspace should be large enough to schedule jobs.
+    uint8_t workspace[4];
+    ASSERT_EQ(SWIZ_OK, swizContextSetWorkspace(context, workspace, sizeof(workspace)));
+    ASSERT_EQ(SWIZ_ERROR_MEMORY_ALLOC, swizDoSwizzleBatch(jobs, 1, context));
+    swizFreePlan(plan);
+}
+
+TEST_F(PlanTest, swizPlanGetSwizzledOffset) {
+    int block_infos[][3] = { { 1, 1, 4 }, { 4, 4, 16 }, { 1, 1, 12 } };
+    for (SwizPlatform platform : { SWIZ_PLATFORM_PS4, SWIZ_PLATFORM_SWITCH }) {
+        for (auto block : block_infos) {
+            swizContextInit(context);
+            swizContextSetPlatform(context, platform);
+            swizContextSetTextureSize(context, 37, 21);
+            swizContextSetHasMips(context, 1);
+            swizContextSetArraySize(context, 2);
+            swizContextSetBlockInfo(context, block[0], block[1], block[2]);
+            SwizPlan *plan = swizNewPlan(context);
+            ASSERT_NE(nullptr, plan);
+
+            // Blocks have their positions as data.
+            int bds = block[2];
+            std::vector<uint8_t> data(swizPlanGetUnswizzledSize(plan));
+            for (size_t i = 0; i < data.size(); i += bds)
+                memcpy(&data[i], &i, sizeof(int));
+            std::vector<uint8_t> swizzled(swizPlanGetSwizzledSize(plan));
+            ASSERT_EQ(SWIZ_OK, swizPlanDoSwizzle(data.data(), swizzled.data(), plan));
+
+            size_t data_index = 0;
+            for (int slice = 0; slice < 2; slice++) {
+                int width = 37;
+                int height = 21;
+                for (int mip = 0; mip < 6; mip++) {
+                    int block_count_x = (width + block[0] - 1) / block[0];
+                    int block_count_y = (height + block[1] - 1) / block[1];
+                    std::vector<int> xs, ys;
+                    for (int y = 0; y < block_count_y; y++) {
+                        for (int x = 0; x < block_count_x; x++) {
+                            uint64_t offset;
+                            ASSERT_EQ(SWIZ_OK, swizPlanGetSwizzledOffset(plan, x, y, mip, slice,
+                                                                         &offset));
+                            ASSERT_EQ(0, memcmp(&data[data_index], &swizzled[offset], bds));
+
+                            int pos[4];
+                            ASSERT_EQ(SWIZ_OK, swizPlanGetBlockPosition(
+                                plan, offset + bds - 1, &pos[0], &pos[1], &pos[2], &pos[3]));
+                            ASSERT_EQ(x, pos[0]);
+                            ASSERT_EQ(y, pos[1]);
+                            ASSERT_EQ(mip, pos[2]);
+                            ASSERT_EQ(slice, pos[3]);
+                            xs.push_back(x);
+                            ys.push_back(y);
+                            data_index += bds;
+                        }
+                    }
+                    std::vector<uint64_t> offsets(xs.size());
+                    ASSERT_EQ(SWIZ_OK, swizPlanGetSwizzledOffsets(plan, xs.data(), ys.data(),
+                                                                  (int)xs.size(), mip, slice,
+                                                                  offsets.data()));
+                    for (size_t i = 0; i < xs.size(); i++) {
+                        uint64_t offset;
+                        swizPlanGetSwizzledOffset(plan, xs[i], ys[i], mip, slice, &offset);
+                        ASSERT_EQ(offset, offsets[i]);
+                    }
+                    width = std::max(1, width / 2);
+                    height = std::max(1, height / 2);
+                }
+            }
+
+            // Out of the texture
+            uint64_t offset;
+            int pos[4];
+            int block_count_x = (37 + block[0] - 1) / block[0];
+            ASSERT_EQ(SWIZ_ERROR_OUT_OF_RANGE,
+                      swizPlanGetSwizzledOffset(plan, block_count_x, 0, 0, 0, &offset));
+            ASSERT_EQ(SWIZ_ERROR_OUT_OF_RANGE,
+                      swizPlanGetSwizzledOffset(plan, 0, 0, 6, 0, &offset));
+            ASSERT_EQ(SWIZ_ERROR_OUT_OF_RANGE,
+                      swizPlanGetBlockPosition(plan, (uint64_t)swizzled.size(),
+                                               &pos[0], &pos[1], &pos[2], &pos[3]));
+            swizFreePlan(plan);
+        }
+    }
+}
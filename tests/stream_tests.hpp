@@ -0,0 +1,164 @@
+#pragma once
+#include <gtest/gtest.h>
+#include <vector>
+#include "console-swizzler.h"
+
+class StreamTest : public ::testing::Test {
+ protected:
+    virtual void SetUp() {
+        context = swizNewContext();
+        ASSERT_NE(nullptr, context);
+    }
+
+    virtual void TearDown() {
+        swizFreeContext(context);
+    }
+
+    SwizContext *context;
+};
+
+static int append_to_vector(const uint8_t *data, size_t size, void *user_data) {
+    std::vector<uint8_t> *output = (std::vector<uint8_t> *)user_data;
+    output->insert(output->end(), data, data + size);
+    return 0;
+}
+
+static int fail_to_write(const uint8_t *data, size_t size, void *user_data) {
+    return 1;
+}
+
+// Gets the number of rows in each mipmap of a slice.
+static std::vector<std::pair<int, int>> get_rows(int width, int height,
+                                                 int block_width, int block_height,
+                                                 int block_data_size, int has_mips) {
+    std::vector<std::pair<int, int>> rows;  // pairs of (row count, pitch)
+    while (true) {
+        int pitch = (width + block_width - 1) / block_width * block_data_size;
+        rows.push_back({ (height + block_height - 1) / block_height, pitch });
+        if (!has_mips || (width == 1 && height == 1))
+            break;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return rows;
+}
+
+TEST_F(StreamTest, swizStreamPushRows) {
+    for (SwizPlatform platform : { SWIZ_PLATFORM_PS4, SWIZ_PLATFORM_SWITCH }) {
+        for (int push_size : { 1, 3, 8, 1000 }) {
+            swizContextInit(context);
+            swizContextSetPlatform(context, platform);
+            swizContextSetTextureSize(context, 100, 150);
+            swizContextSetHasMips(context, 1);
+            swizContextSetArraySize(context, 2);
+            swizContextSetBlockInfo(context, 4, 4, 16);
+            std::vector<uint8_t> data(swizGetUnswizzledSize(context));
+            for (size_t i = 0; i < data.size(); i++)
+                data[i] = (uint8_t)(i * 5 + 1);
+            std::vector<uint8_t> expected(swizGetSwizzledSize(context));
+            ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), expected.data(), context));
+
+            std::vector<uint8_t> swizzled;
+            SwizStream *stream = swizStreamBegin(context, append_to_vector, &swizzled);
+            ASSERT_NE(nullptr, stream);
+
+            // Push rows of all slices and mipmaps.
+            const uint8_t *rows = data.data();
+            auto mips = get_rows(100, 150, 4, 4, 16, 1);
+            for (int slice = 0; slice < 2; slice++) {
+                for (auto mip : mips) {
+                    for (int row = 0; row < mip.first; row += push_size) {
+                        int row_count = std::min(push_size, mip.first - row);
+                        ASSERT_EQ(SWIZ_OK, swizStreamPushRows(stream, rows, row_count));
+                        rows += row_count * mip.second;
+                    }
+                }
+            }
+            ASSERT_EQ(data.data() + data.size(), rows);
+            ASSERT_EQ(SWIZ_OK, swizStreamEnd(stream));
+            ASSERT_EQ(expected, swizzled);
+        }
+    }
+}
+
+TEST_F(StreamTest, swizStreamPushAllRows) {
+    // Rows can span mipmaps.
+    swizContextSetPlatform(context, SWIZ_PLATFORM_SWITCH);
+    swizContextSetTextureSize(context, 64, 64);
+    swizContextSetHasMips(context, 1);
+    swizContextSetBlockInfo(context, 1, 1, 4);
+    std::vector<uint8_t> data(swizGetUnswizzledSize(context));
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)(i * 3);
+    std::vector<uint8_t> expected(swizGetSwizzledSize(context));
+    ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), expected.data(), context));
+
+    std::vector<uint8_t> swizzled;
+    SwizStream *stream = swizStreamBegin(context, append_to_vector, &swizzled);
+    ASSERT_NE(nullptr, stream);
+    ASSERT_EQ(SWIZ_OK, swizStreamPushRows(stream, data.data(), 127));
+    ASSERT_EQ(SWIZ_OK, swizStreamEnd(stream));
+    ASSERT_EQ(expected, swizzled);
+}
+
+TEST_F(StreamTest, swizStreamErrors) {
+    swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
+    swizContextSetTextureSize(context, 32, 32);
+    swizContextSetBlockInfo(context, 4, 4, 8);
+    std::vector<uint8_t> data(swizGetUnswizzledSize(context) * 2);
+    std::vector<uint8_t> swizzled;
+
+    ASSERT_EQ(nullptr, swizStreamBegin(context, NULL, NULL));
+    ASSERT_EQ(SWIZ_ERROR_NULL_POINTER, swizContextGetLastError(context));
+    swizContextInit(context);
+    swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
+    swizContextSetTextureSize(context, 32, 32);
+    swizContextSetBlockInfo(context, 4, 4, 8);
+
+    // Too many rows
+    SwizStream *stream = swizStreamBegin(context, append_to_vector, &swizzled);
+    ASSERT_NE(nullptr, stream);
+    ASSERT_EQ(SWIZ_ERROR_INVALID_ROW_COUNT, swizStreamPushRows(stream, data.data(), 9));
+    ASSERT_EQ(SWIZ_ERROR_INVALID_ROW_COUNT, swizStreamEnd(stream));
+
+    // Too few rows
+    stream = swizStreamBegin(context, append_to_vector, &swizzled);
+    ASSERT_NE(nullptr, stream);
+    ASSERT_EQ(SWIZ_OK, swizStreamPushRows(stream, data.data(), 7));
+    ASSERT_EQ(SWIZ_ERROR_INVALID_ROW_COUNT, swizStreamEnd(stream));
+
+    // Write errors
+    stream = swizStreamBegin(context, fail_to_write, NULL);
+    ASSERT_NE(nullptr, stream);
+    ASSERT_EQ(SWIZ_ERROR_STREAM_WRITE, swizStreamPushRows(stream, data.data(), 8));
+    ASSERT_EQ(SWIZ_ERROR_STREAM_WRITE, swizStreamEnd(stream));
+}
+
+TEST_F(StreamTest, swizStreamWithOtherCalls) {
+    // Other calls on the context should not break an open stream.
+    swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
+    swizContextSetTextureSize(context, 64, 64);
+    swizContextSetBlockInfo(context, 1, 1, 4);
+    std::vector<uint8_t> data(swizGetUnswizzledSize(context));
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)(i * 7 + 2);
+    std::vector<uint8_t> expected(swizGetSwizzledSize(context));
+    ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), expected.data(), context));
+
+    std::vector<uint8_t> swizzled;
+    SwizStream *stream = swizStreamBegin(context, append_to_vector, &swizzled);
+    ASSERT_NE(nullptr, stream);
+    ASSERT_EQ(SWIZ_OK, swizStreamPushRows(stream, data.data(), 12));
+
+    // A large batch grows the workspace of the context.
+    SwizPlan *plan = swizNewPlan(context);
+    ASSERT_NE(nullptr, plan);
+    std::vector<uint8_t> batch_swizzled(expected.size());
+    std::vector<SwizJob> jobs(1000, { plan, data.data(), batch_swizzled.data(), SWIZ_OK });
+    ASSERT_EQ(SWIZ_OK, swizDoSwizzleBatch(jobs.data(), 1000, context));
+    swizFreePlan(plan);
+
+    ASSERT_EQ(SWIZ_OK, swizStreamPushRows(stream, data.data() + 12 * 64 * 4, 64 - 12));
+    ASSERT_EQ(SWIZ_OK, swizStreamEnd(stream));
+    ASSERT_EQ(expected, swizzled);
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <stdio.h>
+#include <string.h>
 #include <gtest/gtest.h>
 #include <vector>
 #include <utility>
@@ -317,3 +318,501 @@ TEST_F(SwizzleTest, swizzleBlockSwitchMips) {
     TestSwizzle();
     TestUnswizzle();
 }
+
+TEST_F(SwizzleTest, swizzlePaddingPS4) {
+    // 3x2 blocks will be padded to 8x8 blocks.
+    uint8_t data[3 * 2] = { 1, 2, 3, 4, 5, 6 };
+    uint8_t expected[64] = { 1, 2, 4, 5, 3, 0, 6, 0 };
+    swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
+    swizContextSetTextureSize(context, 3, 2);
+    swizContextSetBlockInfo(context, 1, 1, 1);
+    ASSERT_EQ(64, swizGetSwizzledSize(context));
+    uint8_t *actual_swizzled = swizAllocSwizzledData(context);
+    ASSERT_NE(nullptr, actual_swizzled);
+    memset(actual_swizzled, 0xFF, 64);
+    ASSERT_EQ(SWIZ_OK, swizDoSwizzle(&data[0], actual_swizzled, context));
+    for (int i = 0; i < 64; i++) {
+        ASSERT_EQ(expected[i], actual_swizzled[i]);
+    }
+
+    uint8_t actual_unswizzled[3 * 2 + 1] = { 0 };
+    actual_unswizzled[3 * 2] = 0xFF;
+    ASSERT_EQ(SWIZ_OK, swizDoUnswizzle(actual_swizzled, &actual_unswizzled[0], context));
+    for (int i = 0; i < 3 * 2; i++) {
+        ASSERT_EQ(data[i], actual_unswizzled[i]);
+    }
+    // unswizzling should not write padding to the outside of the texture.
+    ASSERT_EQ(0xFF, actual_unswizzled[3 * 2]);
+    free(actual_swizzled);
+}
+
+TEST_F(SwizzleTest, swizzlePaddingSwitch) {
+    // 3 pixels of a row will be a 12-byte block in a 16-byte swizzling block.
+    uint8_t data[3 * 4 * 2];
+    for (int i = 0; i < 3 * 4 * 2; i++)
+        data[i] = i + 1;
+    swizContextSetPlatform(context, SWIZ_PLATFORM_SWITCH);
+    swizContextSetTextureSize(context, 3, 2);
+    swizContextSetBlockInfo(context, 1, 1, 4);
+    ASSERT_EQ(512 * 16, swizGetSwizzledSize(context));
+    uint8_t *actual_swizzled = swizAllocSwizzledData(context);
+    ASSERT_NE(nullptr, actual_swizzled);
+    memset(actual_swizzled, 0xFF, 512 * 16);
+    ASSERT_EQ(SWIZ_OK, swizDoSwizzle(&data[0], actual_swizzled, context));
+    for (int i = 0; i < 512 * 16; i++) {
+        uint8_t expected = 0;
+        if (i < 12)
+            expected = data[i];
+        else if (i >= 16 && i < 28)
+            expected = data[i - 4];
+        ASSERT_EQ(expected, actual_swizzled[i]);
+    }
+
+    uint8_t *actual_unswizzled = swizAllocUnswizzledData(context);
+    ASSERT_NE(nullptr, actual_unswizzled);
+    ASSERT_EQ(SWIZ_OK, swizDoUnswizzle(actual_swizzled, actual_unswizzled, context));
+    for (int i = 0; i < 3 * 4 * 2; i++) {
+        ASSERT_EQ(data[i], actual_unswizzled[i]);
+    }
+    free(actual_swizzled);
+    free(actual_unswizzled);
+}
+
+TEST_F(SwizzleTest, swizzleRoundTripBlockSizes) {
+    std::vector<std::array<int, 3>> blocks = {
+        {1, 1, 1}, {1, 1, 2}, {1, 1, 4}, {1, 1, 8}, {1, 1, 12}, {1, 1, 16}, {4, 4, 8}, {4, 4, 16},
+    };
+    for (SwizPlatform platform : { SWIZ_PLATFORM_PS4, SWIZ_PLATFORM_SWITCH }) {
+        for (auto b : blocks) {
+            swizContextInit(context);
+            swizContextSetPlatform(context, platform);
+            swizContextSetTextureSize(context, 75, 41);
+            swizContextSetHasMips(context, 1);
+            swizContextSetBlockInfo(context, b[0], b[1], b[2]);
+            std::vector<uint8_t> data(swizGetUnswizzledSize(context));
+            for (size_t i = 0; i < data.size(); i++)
+                data[i] = (uint8_t)(i * 13 + 1);
+            std::vector<uint8_t> swizzled(swizGetSwizzledSize(context));
+            std::vector<uint8_t> unswizzled(data.size());
+            ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), swizzled.data(), context));
+            ASSERT_EQ(SWIZ_OK, swizDoUnswizzle(swizzled.data(), unswizzled.data(), context));
+            ASSERT_EQ(data, unswizzled) << "platform: " << platform << ", block size: " << b[2];
+        }
+    }
+}
+
+TEST_F(SwizzleTest, swizzleMultiThread) {
+    for (SwizPlatform platform : { SWIZ_PLATFORM_PS4, SWIZ_PLATFORM_SWITCH }) {
+        swizContextInit(context);
+        swizContextSetPlatform(context, platform);
+        swizContextSetTextureSize(context, 200, 100);
+        swizContextSetHasMips(context, 1);
+        swizContextSetArraySize(context, 6);
+        swizContextSetBlockInfo(context, 4, 4, 16);
+        std::vector<uint8_t> data(swizGetUnswizzledSize(context));
+        for (size_t i = 0; i < data.size(); i++)
+            data[i] = (uint8_t)(i * 5 + 3);
+        std::vector<uint8_t> expected(swizGetSwizzledSize(context));
+        ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), expected.data(), context));
+
+        // The result should be the same as single-threaded swizzling.
+        ASSERT_EQ(SWIZ_OK, swizContextSetThreadCount(context, 4));
+        std::vector<uint8_t> swizzled(expected.size());
+        std::vector<uint8_t> unswizzled(data.size());
+        ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), swizzled.data(), context));
+        ASSERT_EQ(expected, swizzled);
+        ASSERT_EQ(SWIZ_OK, swizDoUnswizzle(swizzled.data(), unswizzled.data(), context));
+        ASSERT_EQ(data, unswizzled);
+    }
+}
+
+TEST_F(SwizzleTest, swizzleMultiThreadLargeMip) {
+    // Large mipmaps are split into stripes.
+    for (SwizPlatform platform : { SWIZ_PLATFORM_PS4, SWIZ_PLATFORM_SWITCH }) {
+        swizContextInit(context);
+        swizContextSetPlatform(context, platform);
+        swizContextSetTextureSize(context, 1000, 700);
+        swizContextSetBlockInfo(context, 1, 1, 4);
+        std::vector<uint8_t> data(swizGetUnswizzledSize(context));
+        for (size_t i = 0; i < data.size(); i++)
+            data[i] = (uint8_t)(i * 7 + 1);
+        std::vector<uint8_t> expected(swizGetSwizzledSize(context));
+        ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), expected.data(), context));
+
+        ASSERT_EQ(SWIZ_OK, swizContextSetThreadCount(context, 3));
+        std::vector<uint8_t> swizzled(expected.size());
+        std::vector<uint8_t> unswizzled(data.size());
+        ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), swizzled.data(), context));
+        ASSERT_EQ(expected, swizzled);
+        ASSERT_EQ(SWIZ_OK, swizDoUnswizzle(swizzled.data(), unswizzled.data(), context));
+        ASSERT_EQ(data, unswizzled);
+    }
+}
+
+// Checks that all SIMD variants that the CPU supports give the same bytes as scalar kernels.
+// Output buffers are filled with garbage first. So, padding should be written too.
+static void check_kernel_variants(SwizContext *context) {
+    ASSERT_EQ(SWIZ_OK, swizContextSetKernelVariant(context, SWIZ_KERNEL_SCALAR));
+    std::vector<uint8_t> data(swizGetUnswizzledSize(context));
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (uint8_t)(i * 7 + i / 251);
+    std::vector<uint8_t> expected(swizGetSwizzledSize(context), 0xCD);
+    ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), expected.data(), context));
+
+    for (int variant = SWIZ_KERNEL_SSE2; variant < SWIZ_KERNEL_MAX; variant++) {
+        if (swizContextSetKernelVariant(context, variant) != SWIZ_OK)
+            break;
+        std::vector<uint8_t> swizzled(expected.size(), 0xCD);
+        std::vector<uint8_t> unswizzled(data.size(), 0xCD);
+        ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), swizzled.data(), context));
+        ASSERT_EQ(expected, swizzled) << "variant: " << variant;
+        ASSERT_EQ(SWIZ_OK, swizDoUnswizzle(swizzled.data(), unswizzled.data(), context));
+        ASSERT_EQ(data, unswizzled) << "variant: " << variant;
+    }
+}
+
+TEST_F(SwizzleTest, swizzleKernelVariantsPS4) {
+    // SIMD kernels handle 4, 8, and 16-byte blocks. Sizes have whole and partial tiles.
+    int block_infos[][3] = { { 1, 1, 4 }, { 4, 4, 8 }, { 4, 4, 16 }, { 1, 1, 8 }, { 1, 1, 16 } };
+    int sizes[][2] = { { 64, 64 }, { 136, 72 }, { 37, 21 } };
+    for (auto block : block_infos) {
+        for (auto size : sizes) {
+            swizContextInit(context);
+            swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
+            swizContextSetTextureSize(context, size[0] * block[0], size[1] * block[1]);
+            swizContextSetHasMips(context, 1);
+            swizContextSetArraySize(context, 2);
+            swizContextSetBlockInfo(context, block[0], block[1], block[2]);
+            SCOPED_TRACE("block size: " + std::to_string(block[2]) +
+                         ", width: " + std::to_string(size[0]));
+            ASSERT_NO_FATAL_FAILURE(check_kernel_variants(context));
+        }
+    }
+}
+
+TEST_F(SwizzleTest, swizzleKernelVariantsSwitch) {
+    // SIMD kernels move whole GOBs of 16-byte blocks. Smaller blocks are expanded to 16 bytes.
+    int block_infos[][3] = { { 1, 1, 4 }, { 4, 4, 8 }, { 4, 4, 16 }, { 1, 1, 16 } };
+    int sizes[][2] = { { 64, 64 }, { 136, 72 }, { 37, 21 } };
+    for (auto block : block_infos) {
+        for (auto size : sizes) {
+            for (int gobs_height : { 1, 2, 4, 8, 16 }) {
+                swizContextInit(context);
+                swizContextSetPlatform(context, SWIZ_PLATFORM_SWITCH);
+                swizContextSetGobsHeight(context, gobs_height);
+                swizContextSetTextureSize(context, size[0] * block[0], size[1] * block[1]);
+                swizContextSetHasMips(context, 1);
+                swizContextSetArraySize(context, 2);
+                swizContextSetBlockInfo(context, block[0], block[1], block[2]);
+                SCOPED_TRACE("block size: " + std::to_string(block[2]) +
+                             ", width: " + std::to_string(size[0]) +
+                             ", gobs height: " + std::to_string(gobs_height));
+                ASSERT_NO_FATAL_FAILURE(check_kernel_variants(context));
+            }
+        }
+    }
+}
+
+TEST_F(SwizzleTest, swizzleRectWholeMips) {
+    // Swizzling all mipmaps as rectangles should be the same as swizDoSwizzle().
+    int block_infos[][3] = { { 1, 1, 4 }, { 4, 4, 8 }, { 4, 4, 16 }, { 1, 1, 2 }, { 1, 1, 12 } };
+    for (SwizPlatform platform : { SWIZ_PLATFORM_PS4, SWIZ_PLATFORM_SWITCH }) {
+        for (auto block : block_infos) {
+            swizContextInit(context);
+            swizContextSetPlatform(context, platform);
+            swizContextSetGobsHeight(context, block[2] == 8 ? 2 : 16);
+            swizContextSetTextureSize(context, 70, 45);
+            swizContextSetHasMips(context, 1);
+            swizContextSetArraySize(context, 2);
+            swizContextSetBlockInfo(context, block[0], block[1], block[2]);
+            std::vector<uint8_t> data(swizGetUnswizzledSize(context));
+            for (size_t i = 0; i < data.size(); i++)
+                data[i] = (uint8_t)(i * 3 + 5);
+            std::vector<uint8_t> expected(swizGetSwizzledSize(context));
+            ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), expected.data(), context));
+
+            std::vector<uint8_t> swizzled(expected.size());
+            std::vector<uint8_t> unswizzled(data.size());
+            size_t offset = 0;
+            for (int slice = 0; slice < 2; slice++) {
+                int width = 70;
+                int height = 45;
+                for (int mip = 0; mip < 7; mip++) {
+                    SwizRect rect = { 0, 0, width, height, mip, slice };
+                    ASSERT_EQ(SWIZ_OK, swizDoSwizzleRect(data.data() + offset,
+                                                         swizzled.data(), &rect, context));
+                    ASSERT_EQ(SWIZ_OK, swizDoUnswizzleRect(expected.data(),
+                                                           unswizzled.data() + offset,
+                                                           &rect, context));
+                    offset += (width + block[0] - 1) / block[0] *
+                              ((height + block[1] - 1) / block[1]) * block[2];
+                    width = std::max(1, width / 2);
+                    height = std::max(1, height / 2);
+                }
+            }
+            ASSERT_EQ(data.size(), offset);
+            ASSERT_EQ(expected, swizzled);
+            ASSERT_EQ(data, unswizzled);
+        }
+    }
+}
+
+TEST_F(SwizzleTest, swizzleRectPartial) {
+    for (SwizPlatform platform : { SWIZ_PLATFORM_PS4, SWIZ_PLATFORM_SWITCH }) {
+        swizContextInit(context);
+        swizContextSetPlatform(context, platform);
+        swizContextSetTextureSize(context, 100, 60);
+        swizContextSetBlockInfo(context, 4, 4, 8);
+        std::vector<uint8_t> data(swizGetUnswizzledSize(context));
+        for (size_t i = 0; i < data.size(); i++)
+            data[i] = (uint8_t)(i * 3 + 5);
+        std::vector<uint8_t> swizzled(swizGetSwizzledSize(context));
+        ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), swizzled.data(), context));
+
+        // Update a 20x8 rectangle at (12, 36). It's 5x2 blocks.
+        SwizRect rect = { 12, 36, 20, 8, 0, 0 };
+        std::vector<uint8_t> rect_data(5 * 2 * 8);
+        for (size_t i = 0; i < rect_data.size(); i++)
+            rect_data[i] = (uint8_t)(i + 1);
+        int pitch = 25 * 8;
+        for (int y = 0; y < 2; y++)
+            memcpy(&data[(9 + y) * pitch + 3 * 8], &rect_data[y * 5 * 8], 5 * 8);
+        ASSERT_EQ(SWIZ_OK, swizDoSwizzleRect(rect_data.data(), swizzled.data(), &rect, context));
+
+        std::vector<uint8_t> expected(swizzled.size());
+        ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), expected.data(), context));
+        ASSERT_EQ(expected, swizzled);
+
+        std::vector<uint8_t> unswizzled(rect_data.size());
+        ASSERT_EQ(SWIZ_OK, swizDoUnswizzleRect(swizzled.data(), unswizzled.data(),
+                                               &rect, context));
+        ASSERT_EQ(rect_data, unswizzled);
+    }
+}
+
+TEST_F(SwizzleTest, swizzleRectTiles) {
+    // Large rectangles have whole tiles inside and partial tiles on the edges.
+    int block_infos[][3] = { { 1, 1, 4 }, { 4, 4, 8 }, { 4, 4, 16 }, { 1, 1, 2 }, { 1, 1, 12 } };
+    // Rectangles in blocks: x, y, width, height
+    int rects[][4] = { { 5, 3, 70, 41 }, { 8, 16, 64, 32 }, { 0, 0, 37, 50 }, { 33, 9, 47, 71 } };
+    for (SwizPlatform platform : { SWIZ_PLATFORM_PS4, SWIZ_PLATFORM_SWITCH }) {
+        for (auto block : block_infos) {
+            for (auto r : rects) {
+                swizContextInit(context);
+                swizContextSetPlatform(context, platform);
+                swizContextSetGobsHeight(context, 2);
+                swizContextSetTextureSize(context, 80 * block[0], 80 * block[1]);
+                swizContextSetBlockInfo(context, block[0], block[1], block[2]);
+                int bds = block[2];
+                std::vector<uint8_t> data(swizGetUnswizzledSize(context));
+                std::vector<uint8_t> swizzled(swizGetSwizzledSize(context));
+                ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), swizzled.data(), context));
+
+                SwizRect rect = { r[0] * block[0], r[1] * block[1],
+                                  r[2] * block[0], r[3] * block[1], 0, 0 };
+                std::vector<uint8_t> rect_data(r[2] * r[3] * bds);
+                for (size_t i = 0; i < rect_data.size(); i++)
+                    rect_data[i] = (uint8_t)(i * 7 + i / 253 + 1);
+                for (int y = 0; y < r[3]; y++) {
+                    memcpy(&data[((r[1] + y) * 80 + r[0]) * bds],
+                           &rect_data[y * r[2] * bds], r[2] * bds);
+                }
+                ASSERT_EQ(SWIZ_OK, swizDoSwizzleRect(rect_data.data(), swizzled.data(),
+                                                     &rect, context));
+
+                std::vector<uint8_t> expected(swizzled.size());
+                ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), expected.data(), context));
+                ASSERT_EQ(expected, swizzled) << "platform: " << platform <<
+                    ", block size: " << bds << ", x: " << r[0];
+
+                std::vector<uint8_t> unswizzled(rect_data.size());
+                ASSERT_EQ(SWIZ_OK, swizDoUnswizzleRect(swizzled.data(), unswizzled.data(),
+                                                       &rect, context));
+                ASSERT_EQ(rect_data, unswizzled);
+            }
+        }
+    }
+}
+
+TEST_F(SwizzleTest, swizzleSubresource) {
+    // Swizzling all subresources should be the same as swizDoSwizzle().
+    int block_infos[][3] = { { 1, 1, 4 }, { 4, 4, 8 }, { 4, 4, 16 }, { 1, 1, 12 } };
+    for (SwizPlatform platform : { SWIZ_PLATFORM_PS4, SWIZ_PLATFORM_SWITCH }) {
+        for (auto block : block_infos) {
+            swizContextInit(context);
+            swizContextSetPlatform(context, platform);
+            swizContextSetTextureSize(context, 300, 130);
+            swizContextSetHasMips(context, 1);
+            swizContextSetArraySize(context, 2);
+            swizContextSetBlockInfo(context, block[0], block[1], block[2]);
+            swizContextSetThreadCount(context, 4);
+            std::vector<uint8_t> data(swizGetUnswizzledSize(context));
+            for (size_t i = 0; i < data.size(); i++)
+                data[i] = (uint8_t)(i * 3 + 5);
+            std::vector<uint8_t> expected(swizGetSwizzledSize(context));
+            ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), expected.data(), context));
+
+            std::vector<uint8_t> swizzled(expected.size());
+            std::vector<uint8_t> unswizzled(data.size());
+            int mip_count = swizGetMipCount(context);
+            ASSERT_EQ(9, mip_count);
+            for (int slice = 0; slice < 2; slice++) {
+                for (int mip = 0; mip < mip_count; mip++) {
+                    SwizSubresourceInfo info;
+                    ASSERT_EQ(SWIZ_OK, swizGetSubresourceInfo(context, mip, slice, &info));
+                    ASSERT_EQ(SWIZ_OK, swizDoSwizzleSubresource(
+                        &data[info.data_offset], &swizzled[info.swizzled_offset],
+                        mip, slice, context));
+                    // It should only read the subresource.
+                    std::vector<uint8_t> subresource(expected.begin() + info.swizzled_offset,
+                                                     expected.begin() + info.swizzled_offset +
+                                                     info.swizzled_size);
+                    ASSERT_EQ(SWIZ_OK, swizDoUnswizzleSubresource(
+                        subresource.data(), &unswizzled[info.data_offset],
+                        mip, slice, context));
+                }
+            }
+            ASSERT_EQ(expected, swizzled);
+            ASSERT_EQ(data, unswizzled);
+        }
+    }
+}
+
+TEST_F(SwizzleTest, swizzleSubresourceError) {
+    swizContextSetPlatform(context, SWIZ_PLATFORM_SWITCH);
+    swizContextSetTextureSize(context, 30, 30);
+    swizContextSetBlockInfo(context, 4, 4, 8);
+    uint8_t *swizzled = swizAllocSwizzledData(context);
+    uint8_t *data = swizAllocUnswizzledData(context);
+    SwizPlan *plan = swizNewPlan(context);
+    ASSERT_NE(nullptr, plan);
+    ASSERT_EQ(1, swizPlanGetMipCount(plan));
+
+    EXPECT_EQ(SWIZ_OK, swizPlanDoSwizzleSubresource(data, swizzled, 0, 0, plan));
+    EXPECT_EQ(SWIZ_ERROR_OUT_OF_RANGE, swizPlanDoSwizzleSubresource(data, swizzled, 1, 0, plan));
+    EXPECT_EQ(SWIZ_ERROR_OUT_OF_RANGE,
+              swizPlanDoUnswizzleSubresource(swizzled, data, 0, -1, plan));
+    EXPECT_EQ(SWIZ_ERROR_NULL_POINTER,
+              swizPlanDoUnswizzleSubresource(NULL, data, 0, 0, plan));
+
+    EXPECT_EQ(SWIZ_ERROR_OUT_OF_RANGE, swizDoSwizzleSubresource(data, swizzled, 0, 1, context));
+    EXPECT_EQ(SWIZ_ERROR_OUT_OF_RANGE, swizContextGetLastError(context));
+    swizFreePlan(plan);
+    free(swizzled);
+    free(data);
+}
+
+TEST_F(SwizzleTest, swizzleChunks) {
+    // Swizzling all chunks in order should be the same as swizDoSwizzle().
+    int block_infos[][3] = { { 1, 1, 4 }, { 4, 4, 8 }, { 4, 4, 16 }, { 1, 1, 12 } };
+    size_t budgets[] = { 0, 5000, 100000, 100000000 };
+    for (SwizPlatform platform : { SWIZ_PLATFORM_PS4, SWIZ_PLATFORM_SWITCH }) {
+        for (auto block : block_infos) {
+            swizContextInit(context);
+            swizContextSetPlatform(context, platform);
+            swizContextSetTextureSize(context, 300, 130);
+            swizContextSetHasMips(context, 1);
+            swizContextSetArraySize(context, 2);
+            swizContextSetBlockInfo(context, block[0], block[1], block[2]);
+            swizContextSetThreadCount(context, 4);
+            std::vector<uint8_t> data(swizGetUnswizzledSize(context));
+            for (size_t i = 0; i < data.size(); i++)
+                data[i] = (uint8_t)(i * 3 + 5);
+            std::vector<uint8_t> expected(swizGetSwizzledSize(context));
+            ASSERT_EQ(SWIZ_OK, swizDoSwizzle(data.data(), expected.data(), context));
+
+            for (size_t budget : budgets) {
+                std::vector<uint8_t> swizzled(expected.size());
+                std::vector<uint8_t> unswizzled(data.size());
+                int chunk_count = swizGetChunkCount(context, budget);
+                ASSERT_LE(2 * 9, chunk_count);
+                uint64_t data_offset = 0;
+                uint64_t swizzled_offset = 0;
+                for (int i = 0; i < chunk_count; i++) {
+                    SwizChunk chunk;
+                    ASSERT_EQ(SWIZ_OK, swizGetChunk(context, budget, i, &chunk));
+                    ASSERT_EQ(data_offset, chunk.data_offset);
+                    ASSERT_EQ(swizzled_offset, chunk.swizzled_offset);
+                    if (chunk.stripe_count > 1) {
+                        ASSERT_GE(budget, chunk.data_size + chunk.swizzled_size);
+                    }
+                    ASSERT_EQ(SWIZ_OK, swizDoSwizzleChunk(
+                        &data[chunk.data_offset], &swizzled[chunk.swizzled_offset],
+                        &chunk, context));
+                    // It should only read the chunk.
+                    std::vector<uint8_t> src(expected.begin() + chunk.swizzled_offset,
+                                             expected.begin() + chunk.swizzled_offset +
+                                             chunk.swizzled_size);
+                    ASSERT_EQ(SWIZ_OK, swizDoUnswizzleChunk(
+                        src.data(), &unswizzled[chunk.data_offset], &chunk, context));
+                    data_offset += chunk.data_size;
+                    swizzled_offset += chunk.swizzled_size;
+                }
+                ASSERT_EQ(data.size(), data_offset);
+                ASSERT_EQ(expected.size(), swizzled_offset);
+                ASSERT_EQ(expected, swizzled);
+                ASSERT_EQ(data, unswizzled);
+            }
+        }
+    }
+}
+
+TEST_F(SwizzleTest, swizzleChunkError) {
+    swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
+    swizContextSetTextureSize(context, 30, 30);
+    swizContextSetBlockInfo(context, 4, 4, 8);
+    uint8_t *swizzled = swizAllocSwizzledData(context);
+    uint8_t *data = swizAllocUnswizzledData(context);
+    SwizPlan *plan = swizNewPlan(context);
+    ASSERT_NE(nullptr, plan);
+    ASSERT_EQ(1, swizPlanGetChunkCount(plan, 0));
+
+    SwizChunk chunk;
+    ASSERT_EQ(SWIZ_ERROR_OUT_OF_RANGE, swizPlanGetChunk(plan, 0, 1, &chunk));
+    ASSERT_EQ(SWIZ_ERROR_NULL_POINTER, swizPlanGetChunk(plan, 0, 0, NULL));
+    ASSERT_EQ(SWIZ_OK, swizPlanGetChunk(plan, 0, 0, &chunk));
+    EXPECT_EQ(SWIZ_OK, swizPlanDoSwizzleChunk(data, swizzled, &chunk, plan));
+    chunk.stripe_count = 2;
+    EXPECT_EQ(SWIZ_ERROR_OUT_OF_RANGE, swizPlanDoSwizzleChunk(data, swizzled, &chunk, plan));
+    EXPECT_EQ(SWIZ_ERROR_NULL_POINTER, swizPlanDoUnswizzleChunk(swizzled, data, NULL, plan));
+    swizFreePlan(plan);
+    free(swizzled);
+    free(data);
+}
+
+TEST_F(SwizzleTest, swizzleRectError) {
+    swizContextSetPlatform(context, SWIZ_PLATFORM_PS4);
+    swizContextSetTextureSize(context, 30, 30);
+    swizContextSetBlockInfo(context, 4, 4, 8);
+    uint8_t *swizzled = swizAllocSwizzledData(context);
+    uint8_t *data = swizAllocUnswizzledData(context);
+    SwizPlan *plan = swizNewPlan(context);
+    ASSERT_NE(nullptr, plan);
+
+    SwizRect valid_rects[] = {
+        { 0, 0, 30, 30, 0, 0 },
+        { 28, 4, 2, 26, 0, 0 },
+        { 8, 8, 0, 0, 0, 0 },
+    };
+    for (auto rect : valid_rects)
+        EXPECT_EQ(SWIZ_OK, swizPlanDoSwizzleRect(data, swizzled, &rect, plan));
+
+    SwizRect invalid_rects[] = {
+        { 2, 0, 4, 4, 0, 0 },
+        { 0, 0, 6, 4, 0, 0 },
+        { 0, 0, 32, 32, 0, 0 },
+        { -4, 0, 4, 4, 0, 0 },
+        { 0, 0, 4, 4, 1, 0 },
+        { 0, 0, 4, 4, 0, 1 },
+    };
+    for (auto rect : invalid_rects) {
+        EXPECT_EQ(SWIZ_ERROR_INVALID_RECT, swizPlanDoSwizzleRect(data, swizzled, &rect, plan));
+        EXPECT_EQ(SWIZ_ERROR_INVALID_RECT,
+                  swizPlanDoUnswizzleRect(swizzled, data, &rect, plan));
+    }
+    EXPECT_EQ(SWIZ_ERROR_NULL_POINTER,
+              swizPlanDoSwizzleRect(data, swizzled, NULL, plan));
+    swizFreePlan(plan);
+    free(swizzled);
+    free(data);
+}
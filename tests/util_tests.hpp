@@ -26,6 +26,18 @@ TEST(UtilTest, swizGetErrorMessage) {
           SWIZ_ERROR_INVALID_GOBS_HEIGHT },
         { "Memory allocation error.", SWIZ_ERROR_MEMORY_ALLOC },
         { "De-referencing a null pointer.", SWIZ_ERROR_NULL_POINTER },
+        { "Thread count should be a non-negative number.",
+          SWIZ_ERROR_INVALID_THREAD_COUNT },
+        { "The CPU does not support the kernel variant.",
+          SWIZ_ERROR_UNSUPPORTED_KERNEL_VARIANT },
+        { "The number of rows does not match the texture.",
+          SWIZ_ERROR_INVALID_ROW_COUNT },
+        { "Failed to write swizzled data.", SWIZ_ERROR_STREAM_WRITE },
+        { "The rectangle should be aligned to blocks and in the mipmap.",
+          SWIZ_ERROR_INVALID_RECT },
+        { "The position is out of the texture.", SWIZ_ERROR_OUT_OF_RANGE },
+        { "The data size does not fit in 32 bits. Use 64-bit functions.",
+          SWIZ_ERROR_SIZE_OVERFLOW },
         { "Unexpected error.", SWIZ_ERROR_MAX },
     };
     for (auto c : cases) {